@@ -0,0 +1,50 @@
+/*
+* Author:  agent
+* Written: 10/16/2026
+*
+* BMP280 - Bmp280Device::Interface on a port of a shared I2cBus
+*/
+#include <unistd.h>
+#include "Bmp280BusPort.h"
+
+/*-----------------------------------------------Bmp280BusPort::Bmp280BusPort-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+Bmp280BusPort::Bmp280BusPort(
+   I2cBus & bus,
+   int i2cAddr,
+   I2cBus::PRIORITY priority
+) :
+Port(bus, i2cAddr, priority)
+{}
+
+/*-------------------------------------------------------Bmp280BusPort::sleep-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+void Bmp280BusPort::sleep(int ms) {
+   usleep(1000 * ms);
+}
+
+/*-------------------------------------------------------Bmp280BusPort::write-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+bool Bmp280BusPort::write(void const * buf, int len) {
+   return send(buf, len, m_priority);
+}
+
+/*-----------------------------------------------------Bmp280BusPort::readReg-+
+| Write the register address, then read 'len' bytes after a repeated start    |
++----------------------------------------------------------------------------*/
+bool Bmp280BusPort::readReg(unsigned char reg, void * buf, int len) {
+   struct i2c_msg msgs[2];
+   msgs[0].addr = m_addr;
+   msgs[0].flags = 0;
+   msgs[0].len = 1;
+   msgs[0].buf = &reg;
+   msgs[1].addr = m_addr;
+   msgs[1].flags = I2C_M_RD;
+   msgs[1].len = (unsigned short)len;
+   msgs[1].buf = (unsigned char *)buf;
+   return transfer(msgs, 2, m_priority);
+}
+/*===========================================================================*/
@@ -0,0 +1,37 @@
+/*
+* Author:  agent
+* Written: 10/16/2026
+*
+* BMP280 - Bmp280Device::Interface on a port of a shared I2cBus
+*
+* Compile with the I2C-Common directory on the include path, and link
+* with I2cBus.cpp and -pthread (see I2C-Common/README.md.)
+*/
+#ifndef _BMP280BUSPORT_H_
+#define _BMP280BUSPORT_H_
+
+#include "I2cBus.h"
+#include "Bmp280Device.h"
+
+class Bmp280BusPort : public I2cBus::Port, public Bmp280Device::Interface {
+public:
+   Bmp280BusPort(
+      I2cBus & bus,
+      int i2cAddr,
+      I2cBus::PRIORITY priority = I2cBus::PRIORITY_NORMAL
+   );
+   bool isSpi() const;
+   void sleep(int ms);
+   bool write(void const * buf, int len);
+   bool readReg(unsigned char reg, void * buf, int len);
+};
+
+/*--------+
+| INLINES |
++--------*/
+inline bool Bmp280BusPort::isSpi() const {
+   return false;
+}
+
+#endif
+/*===========================================================================*/
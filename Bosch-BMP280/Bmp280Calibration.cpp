@@ -0,0 +1,365 @@
+/*
+* Author:  agent
+* Written: 10/16/2026
+*
+* BMP280 - Compensation of the raw values (see the Bosch datasheet, 3.11.3)
+*/
+#include "Bmp280Calibration.h"
+
+// The vector code and the scalar code must round alike: no contraction of
+// a multiply and an add into an FMA, whatever the -m or -march options.
+#if defined __clang__
+#pragma STDC FP_CONTRACT OFF
+#elif defined __GNUC__
+#pragma GCC optimize ("fp-contract=off")
+#endif
+
+#if defined __AVX2__
+#include <immintrin.h>
+#elif defined __ARM_NEON && defined __aarch64__
+#include <arm_neon.h>
+#endif
+
+/*-----------------------------------------Bmp280DoubleCompensation::populate-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+void Bmp280DoubleCompensation::populate(unsigned char const * buf) {
+   t1 = (double)((unsigned short)(buf[0]|(buf[1+0]<<8))) / 0x400;
+   t2 = ((short)(buf[2]|(buf[3]<<8)));
+   t3 = (double)((short)(buf[4]|(buf[5]<<8))) / 0x40;
+   p1 = ((unsigned short)(buf[6]|(buf[7]<<8)));
+   p2 = ((double)((short)(buf[8]|(buf[9]<<8)))) * (p1 / 0x400000000L);
+   p3 = ((double)((short)(buf[10]|(buf[11]<<8)))) * (p1 / 0x20000000000000L);
+   p4 = ((short)(buf[12]|(buf[13]<<8))) << 4;
+   p5 = ((double)((short)(buf[14]|(buf[15]<<8)))) / 0x2000;
+   p6 = ((double)((short)(buf[16]|(buf[17]<<8)))) / 0x20000000;
+   p7 = ((double)((short)(buf[18]|(buf[19]<<8)))) / 0x10;
+   p8 = ((double)((short)(buf[20]|(buf[21]<<8)))) / 0x80000;
+   p9 = ((double)((short)(buf[22]|(buf[23]<<8)))) / 0x800000000L;
+}
+
+/*---------------------------------------Bmp280DoubleCompensation::compensate-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+void Bmp280DoubleCompensation::compensate(
+   int32_t adcPress,
+   int32_t adcTmprt,
+   double & press,
+   double & tmprt
+) const {
+   double d1;
+   double d2;
+
+   // compensate temperature
+   d1 = ((double)adcTmprt/0x4000) - t1;
+   d1 = (t3*d1*d1) + (t2*d1);
+   tmprt = d1 / 5120;
+
+   // compensate pressure
+   d1 = (d1/2) - 64000;
+   d2 = (p6*d1*d1) + (p5*d1) + p4;
+   d1 = (p3*d1*d1) + (p2*d1) + p1;
+   if (d1 == 0) {  // to avoid zero-divide
+      press = adcPress;
+   }else {
+      press = (((1048576-(double)adcPress)-d2)*6250)/d1;
+      press += (p9*press*press) + (p8*press) + p7;
+   }
+}
+
+/*---------------------------------------Bmp280DoubleCompensation::compensate-+
+| Compensate 'n' samples.  The vector code does the same operations, in the   |
+| same order, as the scalar code above: results are identical (see the        |
+| FP_CONTRACT pragma, at the top of this file.)                               |
++----------------------------------------------------------------------------*/
+void Bmp280DoubleCompensation::compensate(
+   int n,
+   int32_t const * adcPress,
+   int32_t const * adcTmprt,
+   double * press,
+   double * tmprt
+) const {
+   int i = 0;
+#if defined __AVX2__
+   __m256d const vT1 = _mm256_set1_pd(t1);
+   __m256d const vT2 = _mm256_set1_pd(t2);
+   __m256d const vT3 = _mm256_set1_pd(t3);
+   __m256d const vP1 = _mm256_set1_pd(p1);
+   __m256d const vP2 = _mm256_set1_pd(p2);
+   __m256d const vP3 = _mm256_set1_pd(p3);
+   __m256d const vP4 = _mm256_set1_pd(p4);
+   __m256d const vP5 = _mm256_set1_pd(p5);
+   __m256d const vP6 = _mm256_set1_pd(p6);
+   __m256d const vP7 = _mm256_set1_pd(p7);
+   __m256d const vP8 = _mm256_set1_pd(p8);
+   __m256d const vP9 = _mm256_set1_pd(p9);
+   __m256d const zero = _mm256_setzero_pd();
+   for (; i+4 <= n; i += 4) {
+      __m256d adcP = _mm256_cvtepi32_pd(
+         _mm_loadu_si128((__m128i const *)(adcPress+i))
+      );
+      __m256d d1 = _mm256_cvtepi32_pd(
+         _mm_loadu_si128((__m128i const *)(adcTmprt+i))
+      );
+      __m256d d2;
+      __m256d p;
+
+      // compensate temperature
+      d1 = _mm256_sub_pd(_mm256_div_pd(d1, _mm256_set1_pd(0x4000)), vT1);
+      d1 = _mm256_add_pd(
+         _mm256_mul_pd(_mm256_mul_pd(vT3, d1), d1), _mm256_mul_pd(vT2, d1)
+      );
+      _mm256_storeu_pd(tmprt+i, _mm256_div_pd(d1, _mm256_set1_pd(5120)));
+
+      // compensate pressure
+      d1 = _mm256_sub_pd(
+         _mm256_div_pd(d1, _mm256_set1_pd(2)), _mm256_set1_pd(64000)
+      );
+      d2 = _mm256_add_pd(
+         _mm256_add_pd(
+            _mm256_mul_pd(_mm256_mul_pd(vP6, d1), d1), _mm256_mul_pd(vP5, d1)
+         ),
+         vP4
+      );
+      d1 = _mm256_add_pd(
+         _mm256_add_pd(
+            _mm256_mul_pd(_mm256_mul_pd(vP3, d1), d1), _mm256_mul_pd(vP2, d1)
+         ),
+         vP1
+      );
+      p = _mm256_div_pd(
+         _mm256_mul_pd(
+            _mm256_sub_pd(_mm256_sub_pd(_mm256_set1_pd(1048576), adcP), d2),
+            _mm256_set1_pd(6250)
+         ),
+         d1
+      );
+      p = _mm256_add_pd(
+         p,
+         _mm256_add_pd(
+            _mm256_add_pd(
+               _mm256_mul_pd(_mm256_mul_pd(vP9, p), p), _mm256_mul_pd(vP8, p)
+            ),
+            vP7
+         )
+      );
+      // to avoid zero-divide: keep the raw value
+      p = _mm256_blendv_pd(p, adcP, _mm256_cmp_pd(d1, zero, _CMP_EQ_OQ));
+      _mm256_storeu_pd(press+i, p);
+   }
+#elif defined __ARM_NEON && defined __aarch64__
+   float64x2_t const vT1 = vdupq_n_f64(t1);
+   float64x2_t const vT2 = vdupq_n_f64(t2);
+   float64x2_t const vT3 = vdupq_n_f64(t3);
+   float64x2_t const vP1 = vdupq_n_f64(p1);
+   float64x2_t const vP2 = vdupq_n_f64(p2);
+   float64x2_t const vP3 = vdupq_n_f64(p3);
+   float64x2_t const vP4 = vdupq_n_f64(p4);
+   float64x2_t const vP5 = vdupq_n_f64(p5);
+   float64x2_t const vP6 = vdupq_n_f64(p6);
+   float64x2_t const vP7 = vdupq_n_f64(p7);
+   float64x2_t const vP8 = vdupq_n_f64(p8);
+   float64x2_t const vP9 = vdupq_n_f64(p9);
+   float64x2_t const zero = vdupq_n_f64(0);
+   for (; i+2 <= n; i += 2) {
+      float64x2_t adcP = vcvtq_f64_s64(vmovl_s32(vld1_s32(adcPress+i)));
+      float64x2_t d1 = vcvtq_f64_s64(vmovl_s32(vld1_s32(adcTmprt+i)));
+      float64x2_t d2;
+      float64x2_t p;
+
+      // compensate temperature
+      d1 = vsubq_f64(vdivq_f64(d1, vdupq_n_f64(0x4000)), vT1);
+      d1 = vaddq_f64(vmulq_f64(vmulq_f64(vT3, d1), d1), vmulq_f64(vT2, d1));
+      vst1q_f64(tmprt+i, vdivq_f64(d1, vdupq_n_f64(5120)));
+
+      // compensate pressure
+      d1 = vsubq_f64(vdivq_f64(d1, vdupq_n_f64(2)), vdupq_n_f64(64000));
+      d2 = vaddq_f64(
+         vaddq_f64(vmulq_f64(vmulq_f64(vP6, d1), d1), vmulq_f64(vP5, d1)),
+         vP4
+      );
+      d1 = vaddq_f64(
+         vaddq_f64(vmulq_f64(vmulq_f64(vP3, d1), d1), vmulq_f64(vP2, d1)),
+         vP1
+      );
+      p = vdivq_f64(
+         vmulq_f64(
+            vsubq_f64(vsubq_f64(vdupq_n_f64(1048576), adcP), d2),
+            vdupq_n_f64(6250)
+         ),
+         d1
+      );
+      p = vaddq_f64(
+         p,
+         vaddq_f64(
+            vaddq_f64(vmulq_f64(vmulq_f64(vP9, p), p), vmulq_f64(vP8, p)),
+            vP7
+         )
+      );
+      // to avoid zero-divide: keep the raw value
+      p = vbslq_f64(vceqq_f64(d1, zero), adcP, p);
+      vst1q_f64(press+i, p);
+   }
+#endif
+   for (; i < n; ++i) {
+      compensate(adcPress[i], adcTmprt[i], press[i], tmprt[i]);
+   }
+}
+
+/*------------------------------------------Bmp280FixedCompensation::populate-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+void Bmp280FixedCompensation::populate(unsigned char const * buf) {
+   t1 = (uint16_t)(buf[0]|(buf[1]<<8));
+   t2 = (int16_t)(buf[2]|(buf[3]<<8));
+   t3 = (int16_t)(buf[4]|(buf[5]<<8));
+   p1 = (uint16_t)(buf[6]|(buf[7]<<8));
+   p2 = (int16_t)(buf[8]|(buf[9]<<8));
+   p3 = (int16_t)(buf[10]|(buf[11]<<8));
+   p4 = (int16_t)(buf[12]|(buf[13]<<8));
+   p5 = (int16_t)(buf[14]|(buf[15]<<8));
+   p6 = (int16_t)(buf[16]|(buf[17]<<8));
+   p7 = (int16_t)(buf[18]|(buf[19]<<8));
+   p8 = (int16_t)(buf[20]|(buf[21]<<8));
+   p9 = (int16_t)(buf[22]|(buf[23]<<8));
+}
+
+/*-----------------------------------Bmp280FixedCompensation::compensateTmprt-+
+| Returns the temperature in 0.01 Celsius degree, and the "fine" temperature  |
+| the pressure compensation needs.                                            |
++----------------------------------------------------------------------------*/
+int32_t Bmp280FixedCompensation::compensateTmprt(
+   int32_t adcTmprt,
+   int32_t & tFine
+) const {
+   int32_t var1;
+   int32_t var2;
+
+   var1 = ((((adcTmprt>>3) - ((int32_t)t1<<1))) * ((int32_t)t2)) >> 11;
+   var2 = (
+      (
+         (((adcTmprt>>4) - ((int32_t)t1)) * ((adcTmprt>>4) - ((int32_t)t1)))
+         >> 12
+      ) * ((int32_t)t3)
+   ) >> 14;
+   tFine = var1 + var2;
+   return (tFine * 5 + 128) >> 8;
+}
+
+/*-----------------------------------Bmp280Int32Compensation::compensatePress-+
+| Returns the pressure in Pa.  On a zero divisor (P1 == 0), the raw value is  |
+| returned, as the double precision engine does (Bosch returns 0.)            |
++----------------------------------------------------------------------------*/
+uint32_t Bmp280Int32Compensation::compensatePress(
+   int32_t adcPress,
+   int32_t tFine
+) const {
+   int32_t var1;
+   int32_t var2;
+   uint32_t p;
+
+   var1 = (((int32_t)tFine)>>1) - (int32_t)64000;
+   var2 = (((var1>>2) * (var1>>2)) >> 11) * ((int32_t)p6);
+   var2 = var2 + ((var1*((int32_t)p5))<<1);
+   var2 = (var2>>2) + (((int32_t)p4)<<16);
+   var1 = (
+      ((p3 * (((var1>>2) * (var1>>2)) >> 13)) >> 3) +
+      ((((int32_t)p2) * var1)>>1)
+   ) >> 18;
+   var1 = (((32768+var1))*((int32_t)p1))>>15;
+   if (var1 == 0) return (uint32_t)adcPress;  // to avoid zero-divide
+   p = (((uint32_t)(((int32_t)1048576)-adcPress)-(var2>>12)))*3125;
+   if (p < 0x80000000) {
+      p = (p << 1) / ((uint32_t)var1);
+   }else {
+      p = (p / (uint32_t)var1) * 2;
+   }
+   var1 = (((int32_t)p9) * ((int32_t)(((p>>3) * (p>>3))>>13)))>>12;
+   var2 = (((int32_t)(p>>2)) * ((int32_t)p8))>>13;
+   return (uint32_t)((int32_t)p + ((var1 + var2 + p7) >> 4));
+}
+
+/*----------------------------------------Bmp280Int32Compensation::compensate-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+void Bmp280Int32Compensation::compensate(
+   int32_t adcPress,
+   int32_t adcTmprt,
+   double & press,
+   double & tmprt
+) const {
+   int32_t tFine;
+   tmprt = (double)compensateTmprt(adcTmprt, tFine) / 100;
+   press = compensatePress(adcPress, tFine);
+}
+
+/*----------------------------------------Bmp280Int32Compensation::compensate-+
+| Compensate 'n' samples                                                      |
++----------------------------------------------------------------------------*/
+void Bmp280Int32Compensation::compensate(
+   int n,
+   int32_t const * adcPress,
+   int32_t const * adcTmprt,
+   double * press,
+   double * tmprt
+) const {
+   for (int i=0; i < n; ++i) {
+      compensate(adcPress[i], adcTmprt[i], press[i], tmprt[i]);
+   }
+}
+
+/*-----------------------------------Bmp280Int64Compensation::compensatePress-+
+| Returns the pressure in Pa, as unsigned 32 bit integer in Q24.8 format      |
+| (24 integer bits and 8 fractional bits.)  On a zero divisor, the raw value. |
++----------------------------------------------------------------------------*/
+uint32_t Bmp280Int64Compensation::compensatePress(
+   int32_t adcPress,
+   int32_t tFine
+) const {
+   int64_t var1;
+   int64_t var2;
+   int64_t p;
+
+   var1 = ((int64_t)tFine) - 128000;
+   var2 = var1 * var1 * (int64_t)p6;
+   var2 = var2 + ((var1*(int64_t)p5)<<17);
+   var2 = var2 + (((int64_t)p4)<<35);
+   var1 = ((var1 * var1 * (int64_t)p3)>>8) + ((var1 * (int64_t)p2)<<12);
+   var1 = (((((int64_t)1)<<47)+var1))*((int64_t)p1)>>33;
+   if (var1 == 0) return (uint32_t)adcPress << 8;  // to avoid zero-divide
+   p = 1048576 - adcPress;
+   p = (((p<<31)-var2)*3125)/var1;
+   var1 = (((int64_t)p9) * (p>>13) * (p>>13)) >> 25;
+   var2 = (((int64_t)p8) * p) >> 19;
+   return (uint32_t)(((p + var1 + var2) >> 8) + (((int64_t)p7)<<4));
+}
+
+/*----------------------------------------Bmp280Int64Compensation::compensate-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+void Bmp280Int64Compensation::compensate(
+   int32_t adcPress,
+   int32_t adcTmprt,
+   double & press,
+   double & tmprt
+) const {
+   int32_t tFine;
+   tmprt = (double)compensateTmprt(adcTmprt, tFine) / 100;
+   press = (double)compensatePress(adcPress, tFine) / 256;
+}
+
+/*----------------------------------------Bmp280Int64Compensation::compensate-+
+| Compensate 'n' samples                                                      |
++----------------------------------------------------------------------------*/
+void Bmp280Int64Compensation::compensate(
+   int n,
+   int32_t const * adcPress,
+   int32_t const * adcTmprt,
+   double * press,
+   double * tmprt
+) const {
+   for (int i=0; i < n; ++i) {
+      compensate(adcPress[i], adcTmprt[i], press[i], tmprt[i]);
+   }
+}
+/*===========================================================================*/
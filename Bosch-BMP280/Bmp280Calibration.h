@@ -0,0 +1,113 @@
+/*
+* Author:  agent
+* Written: 10/16/2026
+*
+* BMP280 - Compensation of the raw values (see the Bosch datasheet, 3.11.3)
+*
+* Three compensation engines, selected at compile time:
+* - Bmp280DoubleCompensation: double precision (the default)
+* - Bmp280Int32Compensation: 32-bit fixed point, 1 Pa resolution
+* - Bmp280Int64Compensation: 64-bit fixed point, 1/256 Pa resolution
+* The fixed point engines are bit-exact with the Bosch reference formulas
+* and do not require any FPU, except to return the results as doubles.
+* On a zero divisor (P1 == 0), all the engines return the raw pressure
+* (the Bosch formulas return 0.)  See Bmp280Test: "check" and "bench".
+*
+* Each engine also compensates arrays of raw values (structure of arrays)
+* in one pass.  The double precision engine then uses AVX2 (x86, when
+* compiled with -mavx2) or NEON (AArch64) and falls back to scalar code.
+*/
+#ifndef _BMP280CALIBRATION_H_
+#define _BMP280CALIBRATION_H_
+
+#include <stdint.h>
+
+/*-------------------------------------------- class Bmp280DoubleCompensation-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+class Bmp280DoubleCompensation {
+public:
+   void populate(unsigned char const * buf);
+   void compensate(
+      int32_t adcPress, int32_t adcTmprt,
+      double & press, double & tmprt
+   ) const;
+   void compensate(
+      int n, int32_t const * adcPress, int32_t const * adcTmprt,
+      double * press, double * tmprt
+   ) const;
+private:
+   double t1, t2, t3;
+   double p1, p2, p3, p4, p5, p6, p7, p8, p9;
+};
+
+/*--------------------------------------------- class Bmp280FixedCompensation-+
+| Common to the 32-bit and 64-bit engines                                     |
++----------------------------------------------------------------------------*/
+class Bmp280FixedCompensation {
+public:
+   void populate(unsigned char const * buf);
+   int32_t compensateTmprt(int32_t adcTmprt, int32_t & tFine) const;
+protected:
+   uint16_t t1;
+   int16_t t2, t3;
+   uint16_t p1;
+   int16_t p2, p3, p4, p5, p6, p7, p8, p9;
+};
+
+/*--------------------------------------------- class Bmp280Int32Compensation-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+class Bmp280Int32Compensation : public Bmp280FixedCompensation {
+public:
+   uint32_t compensatePress(int32_t adcPress, int32_t tFine) const; // in Pa
+   void compensate(
+      int32_t adcPress, int32_t adcTmprt,
+      double & press, double & tmprt
+   ) const;
+   void compensate(
+      int n, int32_t const * adcPress, int32_t const * adcTmprt,
+      double * press, double * tmprt
+   ) const;
+};
+
+/*--------------------------------------------- class Bmp280Int64Compensation-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+class Bmp280Int64Compensation : public Bmp280FixedCompensation {
+public:
+   uint32_t compensatePress(int32_t adcPress, int32_t tFine) const; // Q24.8
+   void compensate(
+      int32_t adcPress, int32_t adcTmprt,
+      double & press, double & tmprt
+   ) const;
+   void compensate(
+      int n, int32_t const * adcPress, int32_t const * adcTmprt,
+      double * press, double * tmprt
+   ) const;
+};
+
+/*--------------------------------------------------- class Bmp280Calibration-+
+| Policy is one of the above engines.                                         |
++----------------------------------------------------------------------------*/
+template <class Policy> class Bmp280Calibration : public Policy {
+public:
+   enum { BUFLEN = 24 };
+   using Policy::compensate;
+   // in: raw values, out: Pa and Celsius degrees
+   void compensate(double & press, double & tmprt) const;
+};
+
+/*--------+
+| INLINES |
++--------*/
+template <class Policy>
+inline void Bmp280Calibration<Policy>::compensate(
+   double & press,
+   double & tmprt
+) const {
+   Policy::compensate((int32_t)press, (int32_t)tmprt, press, tmprt);
+}
+
+#endif
+/*===========================================================================*/
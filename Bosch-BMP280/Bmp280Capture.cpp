@@ -0,0 +1,84 @@
+/*
+* Author:  agent
+* Written: 10/16/2026
+*
+* BMP280 - Ring buffer of raw samples, for a deferred compensation
+*/
+#include <time.h>
+#include "Bmp280Capture.h"
+
+/*-----------------------------------------------Bmp280Capture::Bmp280Capture-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+Bmp280Capture::Bmp280Capture(unsigned int capacity) :
+m_head(0),
+m_tail(0),
+m_overruns(0)
+{
+   unsigned int size = 1;
+   while (size < capacity) size <<= 1;
+   m_samples = new Sample[size];
+   m_mask = size - 1;
+}
+
+/*----------------------------------------------Bmp280Capture::~Bmp280Capture-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+Bmp280Capture::~Bmp280Capture() {
+   delete [] m_samples;
+}
+
+/*-------------------------------------------------Bmp280Capture::getFreeSlot-+
+| Producer: get the slot to fill up, then call publish()                      |
++----------------------------------------------------------------------------*/
+Bmp280Capture::Sample * Bmp280Capture::getFreeSlot() {
+   unsigned int head = m_head.load(std::memory_order_relaxed);
+   if ((head - m_tail.load(std::memory_order_acquire)) > m_mask) {
+      m_overruns.fetch_add(1, std::memory_order_relaxed);
+      return 0;
+   }else {
+      return m_samples + (head & m_mask);
+   }
+}
+
+/*-----------------------------------------------------Bmp280Capture::publish-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+void Bmp280Capture::publish() {
+   m_head.store(
+      m_head.load(std::memory_order_relaxed) + 1,
+      std::memory_order_release
+   );
+}
+
+/*---------------------------------------------------------Bmp280Capture::now-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+long long Bmp280Capture::now() {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (ts.tv_sec * 1000000LL) + (ts.tv_nsec / 1000);
+}
+
+/*-----------------------------------------------Bmp280Capture::getReadySlots-+
+| Consumer: get the captured samples, up to the end of the buffer.            |
+| Once done with them, call release().                                        |
++----------------------------------------------------------------------------*/
+unsigned int Bmp280Capture::getReadySlots(Sample const ** first) const {
+   unsigned int tail = m_tail.load(std::memory_order_relaxed);
+   unsigned int count = m_head.load(std::memory_order_acquire) - tail;
+   unsigned int toEnd = (m_mask + 1) - (tail & m_mask);
+   *first = m_samples + (tail & m_mask);
+   return (count < toEnd)? count : toEnd;
+}
+
+/*-----------------------------------------------------Bmp280Capture::release-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+void Bmp280Capture::release(unsigned int count) {
+   m_tail.store(
+      m_tail.load(std::memory_order_relaxed) + count,
+      std::memory_order_release
+   );
+}
+/*===========================================================================*/
@@ -0,0 +1,66 @@
+/*
+* Author:  agent
+* Written: 10/16/2026
+*
+* BMP280 - Ring buffer of raw samples, for a deferred compensation
+*
+* One thread (the producer) captures the raw values with
+* Bmp280Device::captureValues, another one (the consumer) compensates
+* them in batches with Bmp280Device::drainValues.
+* The buffer is allocated once, at construction: neither side allocates,
+* nor waits for the other.  When the buffer is full, new samples are
+* dropped and counted as overruns.
+*/
+#ifndef _BMP280CAPTURE_H_
+#define _BMP280CAPTURE_H_
+
+#include <atomic>
+
+class Bmp280Capture {
+public:
+   struct Sample {
+      long long stamp;             // CLOCK_MONOTONIC, in microseconds
+      unsigned char raw[6];        // REG_VALUES, as read
+   };
+   Bmp280Capture(unsigned int capacity); // rounded up to a power of 2
+   ~Bmp280Capture();
+   unsigned int getCapacity() const;
+   unsigned int getCount() const;
+   unsigned long getOverruns() const;
+
+   // producer side
+   Sample * getFreeSlot();         // 0 if full
+   void publish();                 // the slot is filled up
+   static long long now();         // in microseconds
+
+   // consumer side
+   unsigned int getReadySlots(Sample const ** first) const; // contiguous
+   void release(unsigned int count);
+
+private:
+   Sample * m_samples;
+   unsigned int m_mask;            // capacity - 1
+   std::atomic<unsigned int> m_head;  // next slot to fill (producer)
+   std::atomic<unsigned int> m_tail;  // next slot to drain (consumer)
+   std::atomic<unsigned long> m_overruns;
+
+   Bmp280Capture(Bmp280Capture const &);  // no copy
+   Bmp280Capture & operator=(Bmp280Capture const &);
+};
+
+/*--------+
+| INLINES |
++--------*/
+inline unsigned int Bmp280Capture::getCapacity() const {
+   return m_mask + 1;
+}
+inline unsigned int Bmp280Capture::getCount() const {
+   return m_head.load(std::memory_order_acquire) -
+          m_tail.load(std::memory_order_acquire);
+}
+inline unsigned long Bmp280Capture::getOverruns() const {
+   return m_overruns.load(std::memory_order_relaxed);
+}
+
+#endif
+/*===========================================================================*/
@@ -0,0 +1,94 @@
+/*
+* Author:  agent
+* Written: 10/16/2026
+*
+* BMP280 - Options computed at compile time
+*
+* For fixed settings, the CTRL_MEAS and CONFIG register values and the
+* timings are constants: there is no computation left at run time.
+* Example:
+*
+*   typedef Bmp280Config<
+*      Bmp280Device::VAL_MODE_NORMAL,
+*      Bmp280Device::VAL_FILTER_COEFF_2,
+*      Bmp280Device::VAL_OVERSAMP_16X,   // pressure
+*      Bmp280Device::VAL_OVERSAMP_4X,    // temperature
+*      Bmp280Device::VAL_STANDBY_1000_MS
+*   > MyConfig;
+*   device.setConfig<MyConfig>();
+*/
+#ifndef _BMP280CONFIG_H_
+#define _BMP280CONFIG_H_
+
+#include "Bmp280Device.h"
+
+template <
+   Bmp280Device::VAL_MODE Mode,
+   Bmp280Device::VAL_FILTER Filter,
+   Bmp280Device::VAL_OVERSAMP OsP,
+   Bmp280Device::VAL_OVERSAMP OsT,
+   Bmp280Device::VAL_STANDBY Standby,
+   Bmp280Device::VAL_SPI_WIRING SpiWiring = Bmp280Device::VAL_SPI_WIRING_4
+>
+class Bmp280Config {
+   static_assert(
+      (Mode == Bmp280Device::VAL_MODE_FORCED) ||
+      (Mode == Bmp280Device::VAL_MODE_NORMAL),
+      "Bmp280Config: the mode must be either FORCED or NORMAL"
+   );
+   static_assert(
+      (Filter >= Bmp280Device::VAL_FILTER_OFF) &&
+      (Filter <= Bmp280Device::VAL_FILTER_COEFF_16),
+      "Bmp280Config: bad filter coefficient"
+   );
+   static_assert(
+      (OsP >= Bmp280Device::VAL_OVERSAMP_NONE) &&
+      (OsP <= Bmp280Device::VAL_OVERSAMP_16X) &&
+      (OsT >= Bmp280Device::VAL_OVERSAMP_NONE) &&
+      (OsT <= Bmp280Device::VAL_OVERSAMP_16X),
+      "Bmp280Config: bad oversampling"
+   );
+   static_assert(
+      OsT != Bmp280Device::VAL_OVERSAMP_NONE,
+      "Bmp280Config: the temperature is required to compensate the values"
+   );
+   static_assert(
+      (Standby >= Bmp280Device::VAL_STANDBY_0_5_MS) &&
+      (Standby <= Bmp280Device::VAL_STANDBY_4000_MS),
+      "Bmp280Config: bad standby time"
+   );
+   // the maximum measurement time, see Bmp280Device::setOptions
+   static constexpr int MEASURE_TIME_US = 1250 + (
+      2300 * (((1<<OsP) >> 1) + ((1<<OsT) >> 1))
+   ) + (
+      (OsP != Bmp280Device::VAL_OVERSAMP_NONE)? 575 : 0
+   );
+
+public:
+   static constexpr unsigned char OVERSAMP_TMPRT = OsT;
+   static constexpr unsigned char OVERSAMP_PRESS = OsP;
+   static constexpr unsigned char STANDBY_TIME = Standby;
+   static constexpr unsigned char FILTER = Filter;
+   static constexpr unsigned char MODE = Mode;
+   static constexpr unsigned char SPI_WIRING = SpiWiring;
+
+   // FORCED measures are triggered on demand: the device sleeps meanwhile
+   static constexpr unsigned char CTRL_MEAS = (OsT << 5) | (OsP << 2) | (
+      (Mode == Bmp280Device::VAL_MODE_NORMAL)?
+      Bmp280Device::VAL_MODE_NORMAL : Bmp280Device::VAL_MODE_SLEEP
+   );
+   static constexpr unsigned char CONFIG =
+      (Standby << 5) | (Filter << 2) | SpiWiring;
+
+   // in milliseconds
+   static constexpr int MEASURE_TIME = (MEASURE_TIME_US + 999) / 1000;
+   static constexpr int OUT_DATA_PERIOD = (
+      MEASURE_TIME_US + 500 + (
+         (Standby != Bmp280Device::VAL_STANDBY_0_5_MS)?
+         (62500<<(Standby-1)) : 500
+      )
+   ) / 1000;
+};
+
+#endif
+/*===========================================================================*/
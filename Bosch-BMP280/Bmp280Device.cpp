@@ -7,6 +7,8 @@
 * BMP280 - Air Pressure and Temperature Sensor from Bosh Sensortec
 */
 #include <stdio.h>
+#include <string.h>
+#include <stdint.h>
 #include "Bmp280Device.h"
 
 #define GET_VALUE(name, in) \
@@ -14,18 +16,40 @@
 #define SET_VALUE(name, in, to) \
    in = ((in & ~name##_MASK) | ((to << name##_POS) & name##_MASK))
 
+static bool loadCalibration(
+   char const * path, char const * bus, int i2cAddr, unsigned char chipId,
+   unsigned char * calib, int len
+);
+static void saveCalibration(
+   char const * path, char const * bus, int i2cAddr, unsigned char chipId,
+   unsigned char const * calib, int len
+);
+
 /*-------------------------------------------------Bmp280Device::Bmp280Device-+
-|                                                                             |
+| If 'cachePath' is given, the calibration values are read from this file,    |
+| if it was written for the same bus, I2C address and chip id, and if its     |
+| dig_T1 and dig_T2 match those of the device (the chip id is the same for    |
+| all the parts: another part on the same bus would pass.)  Otherwise, the    |
+| whole calibration is read, and the file is (re)written.                     |
 +----------------------------------------------------------------------------*/
-Bmp280Device::Bmp280Device(Interface & interface) :
+Bmp280Device::Bmp280Device(
+   Interface & interface,
+   char const * cachePath,
+   char const * bus,
+   int i2cAddr
+) :
 m_interface(interface),
 m_isOk(false),
 m_isOptionsSet(false),
+m_isShadowValid(false),
 m_orMaskRead(interface.isSpi()? 0x80 : 0x00),
-m_andMaskWrite(interface.isSpi()? 0x7F : 0xFF)
+m_andMaskWrite(interface.isSpi()? 0x7F : 0xFF),
+m_pollInterval(1),
+m_pollDeadline(100),
+m_conversionTime(-1)
 {
+   unsigned char id;
    for (int tries=5; ; m_interface.sleep(10)) {
-      unsigned char id;
       if (tries-- == 0) {
          printf("No BMP280 device found\n");
          return;
@@ -38,96 +62,165 @@ m_andMaskWrite(interface.isSpi()? 0x7F : 0xFF)
          break;
       }
    }
-   if (!softReset()) return;
 
    // fill-up the calibration struct
    {
       unsigned char buf[Calibration::BUFLEN];  // auto-increment read
+      unsigned char check[4];                  // dig_T1, dig_T2
 
-      if (!m_interface.readReg(REG_CALIB | m_orMaskRead, buf, sizeof buf)) {
-         printf("Can't get calibration values\n");
-         return;
+      if (!softReset()) return;
+      if (
+         !cachePath ||
+         !loadCalibration(cachePath, bus, i2cAddr, id, buf, sizeof buf) ||
+         !m_interface.readReg(REG_CALIB | m_orMaskRead, check, sizeof check) ||
+         (memcmp(check, buf, sizeof check) != 0)
+      ) {
+         if (!m_interface.readReg(REG_CALIB | m_orMaskRead, buf, sizeof buf)) {
+            printf("Can't get calibration values\n");
+            return;
+         }
+         if (cachePath) {
+            saveCalibration(cachePath, bus, i2cAddr, id, buf, sizeof buf);
+         }
       }
       m_calibration.populate(buf);
    }
 
    // fill up the options struct
-   {
-      unsigned char buf[2] = {};
+   if (!readShadow()) return;
+   m_options.oversampTmprt = GET_VALUE(BITS_OVERSAMP_TMPRT, m_shadowCtrlMeas);
+   m_options.oversampPress = GET_VALUE(BITS_OVERSAMP_PRESS, m_shadowCtrlMeas);
+   m_options.mode = GET_VALUE(BITS_MODE, m_shadowCtrlMeas);
+   m_options.standbyTime = GET_VALUE(BITS_STANDBY_TIME, m_shadowConfig);
+   m_options.filter = GET_VALUE(BITS_FILTER, m_shadowConfig);
+   m_options.spiWiring = GET_VALUE(BITS_SPI_WIRING, m_shadowConfig);
+   m_isOk = true; // although options are not yet set on the device (lazy set);
+}
 
-      if (!m_interface.readReg(REG_CTRL_MEAS | m_orMaskRead, buf, sizeof buf)) {
-         printf("Can't get current options");
-         return;
-      }
-      m_options.oversampTmprt = GET_VALUE(BITS_OVERSAMP_TMPRT, buf[0]);
-      m_options.oversampPress = GET_VALUE(BITS_OVERSAMP_PRESS, buf[0]);
-      m_options.mode = GET_VALUE(BITS_MODE, buf[0]);
-      m_options.standbyTime = GET_VALUE(BITS_STANDBY_TIME, buf[1]);
-      m_options.filter = GET_VALUE(BITS_FILTER, buf[1]);
-      m_options.spiWiring = GET_VALUE(BITS_SPI_WIRING, buf[1]);
+/*---------------------------------------------------Bmp280Device::readShadow-+
+| Get the CTRL_MEAS and CONFIG registers as they are on the device            |
++----------------------------------------------------------------------------*/
+bool Bmp280Device::readShadow() {
+   unsigned char buf[2] = {};
+
+   m_isShadowValid = m_interface.readReg(
+      REG_CTRL_MEAS | m_orMaskRead, buf, sizeof buf
+   );
+   if (!m_isShadowValid) {
+      printf("Can't get current options\n");
+   }else {
+      m_shadowCtrlMeas = buf[0];
+      m_shadowConfig = buf[1];
    }
-   m_isOk = true; // although options are not yet set on the device (lazy set);
+   return m_isShadowValid;
 }
 
 /*---------------------------------------------------Bmp280Device::setOptions-+
-|                                                                             |
+| Compute the register values and timings from the options struct.            |
 +----------------------------------------------------------------------------*/
 bool Bmp280Device::setOptions() {
-   unsigned char buf1[2] = {};
+   unsigned char ctrlMeas;
+   unsigned char config;
 
    m_isOptionsSet = false;
+   if (!m_isShadowValid && !readShadow()) return false;
+   ctrlMeas = m_shadowCtrlMeas;
+   config = m_shadowConfig;
+   SET_VALUE(BITS_OVERSAMP_TMPRT, ctrlMeas, m_options.oversampTmprt);
+   SET_VALUE(BITS_OVERSAMP_PRESS, ctrlMeas, m_options.oversampPress);
+   SET_VALUE(
+      BITS_MODE, ctrlMeas,
+      (m_options.mode == VAL_MODE_NORMAL)? VAL_MODE_NORMAL : VAL_MODE_SLEEP
+   );
+   SET_VALUE(BITS_STANDBY_TIME, config, m_options.standbyTime);
+   SET_VALUE(BITS_FILTER, config, m_options.filter);
+   SET_VALUE(BITS_SPI_WIRING, config, m_options.spiWiring);
+
+   // compute the time required for a measure
+   /*
+   | Datasheet, 3.8.1, maximum measurement time, for temperature and pressure:
+   | - 2300 us is the duration of the 1 x oversampling
+   | - oversampling factor is: (1 << options.oversampXxxxx) >> 1
+   | - 1250 us to start the measuring process
+   | - add 575 us to start the pressure oversampling (hence, if not 0)
+   | - divide by 1000 (us -> ms) and round up
+   | A part may take up to the maximum: sleeping for the typical time would
+   | read the previous values, or the reset ones (0x80000.)
+   | The output data period adds the standby time (normal mode.)
+   | Bmp280Config does the same computation at compile time.
+   */
+   int measureTime = 1250 + (
+      2300 * (
+         ((1<<m_options.oversampPress) >> 1) +
+         ((1<<m_options.oversampTmprt) >> 1)
+      )
+   ) + (
+      m_options.oversampPress? 575 : 0
+   );
+   return writeOptions(
+      ctrlMeas,
+      config,
+      (measureTime + 999) / 1000,
+      (
+         measureTime + 500 + ( // 500 added for rounding it up
+            m_options.standbyTime? (62500<<(m_options.standbyTime-1)) : 500
+         )
+      ) / 1000
+   );
+}
+
+/*-------------------------------------------------Bmp280Device::writeOptions-+
+| Only the registers which differ from their shadow copy are written, in a    |
+| single write.  Leaving the NORMAL mode, or writing CONFIG in NORMAL mode    |
+| (it may be ignored), the device is soft reset first, as Bosch's conf_sensor |
+| does: writing SLEEP does not stop the measure running, which would swallow  |
+| the next FORCED trigger.  Both registers are then 0.                        |
+| FORCED measures are triggered by readValues (see triggerForced): in         |
+| between, the device is in SLEEP mode.                                       |
++----------------------------------------------------------------------------*/
+bool Bmp280Device::writeOptions(
+   unsigned char ctrlMeas,
+   unsigned char config,
+   int measureTime,
+   int outDataPeriod
+) {
+   unsigned char buf[6];
+   int len = 0;
+
+   m_isOptionsSet = false;
+   if (!m_isShadowValid && !readShadow()) return false;
    if (
-      softReset() &&
-      m_interface.readReg(REG_CTRL_MEAS | m_orMaskRead, buf1, sizeof buf1)
+      (GET_VALUE(BITS_MODE, m_shadowCtrlMeas) == VAL_MODE_NORMAL) && (
+         (config != m_shadowConfig) ||
+         (GET_VALUE(BITS_MODE, ctrlMeas) != VAL_MODE_NORMAL)
+      )
    ) {
-      unsigned char buf2[4] = {};
-
-      SET_VALUE(BITS_OVERSAMP_TMPRT, buf1[0], m_options.oversampTmprt);
-      SET_VALUE(BITS_OVERSAMP_PRESS, buf1[0], m_options.oversampPress);
-      // power mode (currently VAL_MODE_SLEEP) is set at the end
-      SET_VALUE(BITS_STANDBY_TIME, buf1[1], m_options.standbyTime);
-      SET_VALUE(BITS_FILTER, buf1[1], m_options.filter);
-      SET_VALUE(BITS_SPI_WIRING, buf1[1], m_options.spiWiring);
-
-      buf2[0] = REG_CTRL_MEAS & m_andMaskWrite;
-      buf2[1] = buf1[0];
-      buf2[2] = REG_CONFIG & m_andMaskWrite;
-      buf2[3] = buf1[1];
-      if (m_interface.write(buf2, sizeof buf2)) { // write 2 pairs
-         // compute the minimal time required for a measure
-         /*
-         | For temperature and pressure,
-         | - 2000 us is the duration of the 1 x oversampling
-         | - oversampling factor is: (1 << options.oversampXxxxx) >> 1
-         | - 1000 us to start the measuring process
-         | - add 500 us to start the pressure oversampling (hence, if not 0)
-         | - add the standby time
-         | - divide by 1000 (us -> ms) and round
-         */
-         m_outDataPeriod = (
-            1000 + 500 + ( // 500 added for rounding it up
-               2000 * (
-                  ((1<<m_options.oversampPress) >> 1) +
-                  ((1<<m_options.oversampTmprt) >> 1)
-               )
-            ) + (
-               m_options.oversampPress? 500 : 0
-            ) + (
-               m_options.standbyTime? (62500<<(m_options.standbyTime-1)) : 500
-            )
-         ) / 1000;
-
-         // set the power mode (if not VAL_MODE_SLEEP) in a separate write
-         if (m_options.mode != VAL_MODE_SLEEP) { // softReset sets MODE_SLEEP
-            SET_VALUE(BITS_MODE, buf2[1], m_options.mode);
-            m_isOptionsSet = m_interface.write(buf2, 2); // single pair
-         }else {
-            m_isOptionsSet = true;
-         }
+      if (!softReset()) {
+         m_isShadowValid = false;
+         return false;
       }
+      m_shadowCtrlMeas = 0;        // reset values
+      m_shadowConfig = 0;
+   }
+   if (config != m_shadowConfig) {
+      buf[len++] = REG_CONFIG & m_andMaskWrite;
+      buf[len++] = config;
+   }
+   if (ctrlMeas != m_shadowCtrlMeas) {
+      buf[len++] = REG_CTRL_MEAS & m_andMaskWrite;
+      buf[len++] = ctrlMeas;
    }
-   if (!m_isOptionsSet) printf("Can't set options");
-   return m_isOptionsSet;
+   if ((len > 0) && !m_interface.write(buf, len)) { // write all pairs
+      m_isShadowValid = false;                      // who knows?
+      printf("Can't set options\n");
+      return false;
+   }
+   m_shadowCtrlMeas = ctrlMeas;
+   m_shadowConfig = config;
+   m_measureTime = measureTime;
+   m_outDataPeriod = outDataPeriod;
+   m_isOptionsSet = true;
+   return true;
 }
 
 /*---------------------------------------------Bmp280Device::getOutDataPeriod-+
@@ -158,67 +251,277 @@ bool Bmp280Device::softReset() {
    }
 }
 
-/*---------------------------------------------------Bmp280Device::readValues-+
+/*------------------------------------------------Bmp280Device::triggerForced-+
+| Start a single measure.                                                     |
+| Only CTRL_MEAS is written: the options are already set on the device.       |
++----------------------------------------------------------------------------*/
+bool Bmp280Device::triggerForced() {
+   unsigned char buf[2] = {
+      (unsigned char)(REG_CTRL_MEAS & m_andMaskWrite), m_shadowCtrlMeas
+   };
+   SET_VALUE(BITS_MODE, buf[1], VAL_MODE_FORCED);
+   if (!m_interface.write(buf, sizeof buf)) {
+      printf("Can't trigger a forced measure\n");
+      return false;
+   }else {
+      return true;
+   }
+}
+
+/*--------------------------------------------Bmp280Device::waitForConversion-+
+| Poll the STATUS register until both the "measuring" and "im_update" bits    |
+| are cleared.  The conversion time is measured on CLOCK_MONOTONIC, bus and   |
+| system calls included.  The deadline counts the polling intervals only.     |
+| In NORMAL mode, the device measures again after each standby time: there    |
+| is nothing to wait for (the values registers are always consistent), and    |
+| with a short standby the bits may never be seen cleared.  Fail at once.     |
++----------------------------------------------------------------------------*/
+bool Bmp280Device::waitForConversion() {
+   if (!m_isOk) return false;
+   if (m_options.mode == VAL_MODE_NORMAL) {
+      printf("No polling in NORMAL mode: use readValues\n");
+      return false;
+   }
+   long long start = Bmp280Capture::now();
+   for (int elapsed=0; ; elapsed += m_pollInterval) {
+      unsigned char status;
+      if (!m_interface.readReg(REG_STATUS | m_orMaskRead, &status, 1)) {
+         printf("Can't get status\n");
+         return false;
+      }
+      if ((status & (BITS_MEASURING_MASK | BITS_IM_UPDATE_MASK)) == 0) {
+         m_conversionTime = (int)((Bmp280Capture::now() - start + 500) / 1000);
+         return true;
+      }
+      if (elapsed >= m_pollDeadline) {
+         printf("Conversion not completed after %d ms\n", elapsed);
+         return false;
+      }
+      m_interface.sleep(m_pollInterval);
+   }
+}
+
+/*-------------------------------------------------Bmp280Device::startMeasure-+
+| Make sure the options are set, trigger the measure if in FORCED mode,       |
+| then either sleep for the measuring time, or poll until it completes.       |
++----------------------------------------------------------------------------*/
+bool Bmp280Device::startMeasure(bool isPolled) {
+   if (m_options.mode == VAL_MODE_SLEEP) m_options.mode = VAL_MODE_FORCED;
+   if (!m_isOk || (!m_isOptionsSet && !setOptions())) {
+      return false;
+   }else if (m_options.mode != VAL_MODE_FORCED) {
+      return !isPolled || waitForConversion();
+   }else if (!triggerForced()) {
+      return false;
+   }else if (isPolled) {
+      return waitForConversion();
+   }else {
+      m_interface.sleep(m_measureTime);
+      return true;
+   }
+}
+
+/*--------------------------------------------------Bmp280Device::fetchValues-+
 |                                                                             |
 +----------------------------------------------------------------------------*/
-bool Bmp280Device::readValues(double & pressure, double & temperature)
+bool Bmp280Device::fetchValues(double & pressure, double & temperature)
 {
    unsigned char buf[6];
 
-   if (m_options.mode == VAL_MODE_SLEEP) m_options.mode = VAL_MODE_FORCED;
-   if (
-      !m_isOk || (
-        (!m_isOptionsSet || (m_options.mode != VAL_MODE_NORMAL)) &&
-        !setOptions()
-      ) || // auto-increment read
-      !m_interface.readReg(REG_VALUES | m_orMaskRead, buf, sizeof buf)
-   ) {
+   // auto-increment read
+   if (!m_interface.readReg(REG_VALUES | m_orMaskRead, buf, sizeof buf)) {
       return false;
    }else {
-      pressure = (buf[0] << 12) | (buf[1] << 4) | (buf[2] >> 4);
-      temperature = (buf[3] << 12) | (buf[4] << 4) | (buf[5] >> 4);
-      m_calibration.compensate(pressure, temperature);
+      m_calibration.compensate(
+         getAdcPress(buf), getAdcTmprt(buf), pressure, temperature
+      );
       return true;
    }
 }
 
-/*----------------------------------------Bmp280Device::Calibration::populate-+
+/*---------------------------------------------------Bmp280Device::readValues-+
 |                                                                             |
 +----------------------------------------------------------------------------*/
-void Bmp280Device::Calibration::populate(unsigned char const * buf) {
-   t1 = (double)((unsigned short)(buf[0]|(buf[1+0]<<8))) / 0x400;
-   t2 = ((short)(buf[2]|(buf[3]<<8)));
-   t3 = (double)((short)(buf[4]|(buf[5]<<8))) / 0x40;
-   p1 = ((unsigned short)(buf[6]|(buf[7]<<8)));
-   p2 = ((double)((short)(buf[8]|(buf[9]<<8)))) * (p1 / 0x400000000L);
-   p3 = ((double)((short)(buf[10]|(buf[11]<<8)))) * (p1 / 0x20000000000000L);
-   p4 = ((short)(buf[12]|(buf[13]<<8))) << 4;
-   p5 = ((double)((short)(buf[14]|(buf[15]<<8)))) / 0x2000;
-   p6 = ((double)((short)(buf[16]|(buf[17]<<8)))) /  0x40000;
-   p7 = ((double)((short)(buf[18]|(buf[19]<<8)))) / 0x10;
-   p8 = ((double)((short)(buf[20]|(buf[21]<<8)))) / 0x80000;
-   p9 = ((double)((short)(buf[22]|(buf[23]<<8)))) / 0x800000000L;
-}
-
-/*--------------------------------------Bmp280Device::Calibration::compensate-+
-|                                                                             |
+bool Bmp280Device::readValues(double & pressure, double & temperature)
+{
+   return startMeasure(false) && fetchValues(pressure, temperature);
+}
+
+/*------------------------------------------Bmp280Device::readValuesWhenReady-+
+| Same as readValues, but returns as soon as the device is done.              |
 +----------------------------------------------------------------------------*/
-void Bmp280Device::Calibration::compensate(double & press, double & tmprt) const
+bool Bmp280Device::readValuesWhenReady(
+   double & pressure,
+   double & temperature
+) {
+   return startMeasure(true) && fetchValues(pressure, temperature);
+}
+
+/*------------------------------------------------Bmp280Device::captureValues-+
+| Read the raw values in the next free slot of the capture buffer.            |
+| No compensation is done: see drainValues.                                   |
+| When the buffer is full, no measure is started: the sample is dropped       |
+| without any bus traffic.                                                    |
++----------------------------------------------------------------------------*/
+bool Bmp280Device::captureValues(Bmp280Capture & capture)
 {
-   double d1;
-   double d2;
-
-   // compensate temperature
-   d1 = (tmprt/0x4000) - t1;
-   d1 = (t3*d1*d1) + (t2*d1);
-   tmprt = d1 / 5120;
-
-   // compensate pressure
-   d1 = (d1/2) - 64000;
-   d2 = (p6*d1*d1) + (p5*d1) + p4;
-   d1 = (p3*d1*d1) + (p2*d1) + p1;
-   if (d1 != 0) {  // to avoid zero-divide
-      press = ((p9*d1*d1) + (p8*d1) + p7 + ((((1048576-press)-d2)*6250)/d1));
+   Bmp280Capture::Sample * sample;
+
+   if (((sample = capture.getFreeSlot()) == 0) || !startMeasure(false)) {
+      return false;
+   }else if (
+      // auto-increment read
+      !m_interface.readReg(
+         REG_VALUES | m_orMaskRead, sample->raw, sizeof sample->raw
+      )
+   ) {
+      return false;
+   }else {
+      sample->stamp = Bmp280Capture::now();
+      capture.publish();
+      return true;
+   }
+}
+
+/*--------------------------------------------------Bmp280Device::drainValues-+
+| Compensate up to 'max' captured samples, in batches.                        |
+| 'stamps' can be 0.  Returns the number of samples drained.                  |
++----------------------------------------------------------------------------*/
+int Bmp280Device::drainValues(
+   Bmp280Capture & capture,
+   double * pressures,
+   double * temperatures,
+   long long * stamps,
+   int max
+) {
+   enum { BATCH = 64 };
+   int32_t adcPress[BATCH];
+   int32_t adcTmprt[BATCH];
+   int done = 0;
+
+   while (done < max) {
+      Bmp280Capture::Sample const * samples;
+      int count = capture.getReadySlots(&samples);
+      if (count == 0) break;
+      if (count > max-done) count = max-done;
+      if (count > BATCH) count = BATCH;
+      for (int i=0; i < count; ++i) {
+         adcPress[i] = getAdcPress(samples[i].raw);
+         adcTmprt[i] = getAdcTmprt(samples[i].raw);
+         if (stamps) stamps[done+i] = samples[i].stamp;
+      }
+      capture.release(count);
+      m_calibration.compensate(
+         count, adcPress, adcTmprt, pressures+done, temperatures+done
+      );
+      done += count;
+   }
+   return done;
+}
+
+/*STATIC-------------------------------------------------------------checksum-+
+| FNV-1a hash of the cache record                                             |
++----------------------------------------------------------------------------*/
+static uint32_t checksum(unsigned char const * data, int n) {
+   uint32_t hash = 2166136261U;
+   for (int i=0; i < n; ++i) {
+      hash = (hash ^ data[i]) * 16777619U;
+   }
+   return hash;
+}
+
+/*STATIC--------------------------------------------------------------makeKey-+
+| The cache record starts with: "BMP280", chip id, I2C address, bus name      |
++----------------------------------------------------------------------------*/
+enum { KEY_LEN = 6 + 1 + 1 + 32 };
+static void makeKey(
+   unsigned char * key, char const * bus, int i2cAddr, unsigned char chipId
+) {
+   memset(key, 0, KEY_LEN);
+   memcpy(key, "BMP280", 6);
+   key[6] = chipId;
+   key[7] = (unsigned char)i2cAddr;
+   if (bus) strncpy((char *)key+8, bus, KEY_LEN-8-1);
+}
+
+/*STATIC------------------------------------------------------loadCalibration-+
+| Returns false if the file is missing, or if its key or checksum mismatch.   |
++----------------------------------------------------------------------------*/
+static bool loadCalibration(
+   char const * path,
+   char const * bus,
+   int i2cAddr,
+   unsigned char chipId,
+   unsigned char * calib,
+   int len
+) {
+   unsigned char key[KEY_LEN];
+   unsigned char record[KEY_LEN + 64 + 4];
+   uint32_t sum;
+   FILE * file = fopen(path, "rb");
+   int recordLen = KEY_LEN + len + 4;
+
+   if (!file) return false;
+   if (
+      (recordLen > (int)sizeof record) ||
+      ((int)fread(record, 1, sizeof record, file) != recordLen) ||
+      !feof(file)
+   ) {
+      fclose(file);
+      return false;
+   }
+   fclose(file);
+   makeKey(key, bus, i2cAddr, chipId);
+   sum = checksum(record, recordLen - 4);
+   if (
+      (memcmp(record, key, KEY_LEN) != 0) ||
+      (record[recordLen-4] != (unsigned char)sum) ||
+      (record[recordLen-3] != (unsigned char)(sum >> 8)) ||
+      (record[recordLen-2] != (unsigned char)(sum >> 16)) ||
+      (record[recordLen-1] != (unsigned char)(sum >> 24))
+   ) {
+      printf("Calibration cache %s discarded\n", path);
+      return false;
+   }
+   memcpy(calib, record + KEY_LEN, len);
+   return true;
+}
+
+/*STATIC------------------------------------------------------saveCalibration-+
+| Write a temporary file, then rename it: the cache is never half written.    |
++----------------------------------------------------------------------------*/
+static void saveCalibration(
+   char const * path,
+   char const * bus,
+   int i2cAddr,
+   unsigned char chipId,
+   unsigned char const * calib,
+   int len
+) {
+   unsigned char record[KEY_LEN + 64 + 4];
+   char tmpPath[1024];
+   int recordLen = KEY_LEN + len + 4;
+   uint32_t sum;
+   FILE * file;
+   bool isOk = false;
+
+   if (recordLen > (int)sizeof record) return;
+   int tmpLen = snprintf(tmpPath, sizeof tmpPath, "%s.tmp", path);
+   if (tmpLen >= (int)sizeof tmpPath) return;
+   makeKey(record, bus, i2cAddr, chipId);
+   memcpy(record + KEY_LEN, calib, len);
+   sum = checksum(record, recordLen - 4);
+   record[recordLen-4] = (unsigned char)sum;
+   record[recordLen-3] = (unsigned char)(sum >> 8);
+   record[recordLen-2] = (unsigned char)(sum >> 16);
+   record[recordLen-1] = (unsigned char)(sum >> 24);
+   if ((file = fopen(tmpPath, "wb")) != 0) {
+      isOk = ((int)fwrite(record, 1, recordLen, file) == recordLen);
+      isOk = (fclose(file) == 0) && isOk;
+   }
+   if (!isOk || (rename(tmpPath, path) != 0)) {
+      printf("Can't write the calibration cache %s\n", path);
+      remove(tmpPath);
    }
 }
 /*===========================================================================*/
@@ -9,6 +9,9 @@
 #ifndef _BMP280DEVICE_H_
 #define _BMP280DEVICE_H_
 
+#include "Bmp280Calibration.h"
+#include "Bmp280Capture.h"
+
 class Bmp280Device {
 public:
    class Interface {               // pure abstract class
@@ -53,7 +56,12 @@ public:
       VAL_SPI_WIRING_3 = 1         // 3-wire
    };
 
-   Bmp280Device(Interface & interface);
+   Bmp280Device(
+      Interface & interface,
+      char const * cachePath = 0,  // calibration cache file (optional)
+      char const * bus = 0,        // ex: "/dev/i2c-1"
+      int i2cAddr = 0
+   );
    bool isOperational();
 
    void setMode(VAL_MODE val);
@@ -64,8 +72,26 @@ public:
    void setSpiWiring(VAL_SPI_WIRING val);
    int getOutDataPeriod();         // in milliseconds
 
+   // all options at once, computed at compile time (see Bmp280Config)
+   template <class Config> bool setConfig();
+
    bool readValues(double & pressure, double & temperature);
 
+   // REG_STATUS polling, rather than sleeping for the worst case
+   // (FORCED mode only: fails at once in NORMAL mode)
+   void setPollInterval(int ms);   // default: 1 ms
+   void setPollDeadline(int ms);   // default: 100 ms
+   bool waitForConversion();
+   bool readValuesWhenReady(double & pressure, double & temperature);
+   int getConversionTime() const;  // last measured by polling, in ms
+
+   // deferred compensation (see Bmp280Capture)
+   bool captureValues(Bmp280Capture & capture);
+   int drainValues(
+      Bmp280Capture & capture,
+      double * pressures, double * temperatures, long long * stamps, int max
+   );
+
 private:
    enum REG {
       REG_CALIB = 0x88,
@@ -97,18 +123,19 @@ private:
       BITS_SPI_WIRING_POS = 0,
       BITS_SPI_WIRING_MASK = 0x01,
       BITS_MODE_POS = 0,
-      BITS_MODE_MASK = 0x03
+      BITS_MODE_MASK = 0x03,
+      BITS_MEASURING_MASK = 0x08,
+      BITS_IM_UPDATE_MASK = 0x01
    };
 
-   class Calibration {
-   public:
-      enum { BUFLEN = 24 };
-      void populate(unsigned char const * buf);
-      void compensate(double & press, double & tmprt) const;
-   private:
-      double t1, t2, t3;
-      double p1, p2, p3, p4, p5, p6, p7, p8, p9;
-   } m_calibration;
+#if defined BMP280_COMPENSATION_INT32
+   typedef Bmp280Calibration<Bmp280Int32Compensation> Calibration;
+#elif defined BMP280_COMPENSATION_INT64
+   typedef Bmp280Calibration<Bmp280Int64Compensation> Calibration;
+#else
+   typedef Bmp280Calibration<Bmp280DoubleCompensation> Calibration;
+#endif
+   Calibration m_calibration;
 
    struct {                        // CTRL_MEAS + CONFIG registers
       unsigned char oversampTmprt; // see VAL_OVERSAMP
@@ -122,12 +149,29 @@ private:
    Interface & m_interface;
    bool m_isOk;
    bool m_isOptionsSet;
+   bool m_isShadowValid;
    unsigned char const m_orMaskRead;
    unsigned char const m_andMaskWrite;
+   unsigned char m_shadowCtrlMeas; // CTRL_MEAS, as on the device
+   unsigned char m_shadowConfig;   // CONFIG, as on the device
+   int m_measureTime;              // in milliseconds
    int m_outDataPeriod;            // in milliseconds
+   int m_pollInterval;             // in milliseconds
+   int m_pollDeadline;             // in milliseconds
+   int m_conversionTime;           // in milliseconds
 
    bool softReset();
+   bool readShadow();
    bool setOptions();
+   bool writeOptions(
+      unsigned char ctrlMeas, unsigned char config,
+      int measureTime, int outDataPeriod
+   );
+   bool triggerForced();
+   bool startMeasure(bool isPolled);
+   bool fetchValues(double & pressure, double & temperature);
+   static int32_t getAdcPress(unsigned char const * buf);
+   static int32_t getAdcTmprt(unsigned char const * buf);
 };
 
 /*--------+
@@ -136,29 +180,68 @@ private:
 inline bool Bmp280Device::isOperational() {
    return m_isOk;
 }
+inline int32_t Bmp280Device::getAdcPress(unsigned char const * buf) {
+   return (buf[0] << 12) | (buf[1] << 4) | (buf[2] >> 4);
+}
+inline int32_t Bmp280Device::getAdcTmprt(unsigned char const * buf) {
+   return (buf[3] << 12) | (buf[4] << 4) | (buf[5] >> 4);
+}
+template <class Config> inline bool Bmp280Device::setConfig() {
+   m_options.oversampTmprt = Config::OVERSAMP_TMPRT;
+   m_options.oversampPress = Config::OVERSAMP_PRESS;
+   m_options.standbyTime = Config::STANDBY_TIME;
+   m_options.filter = Config::FILTER;
+   m_options.mode = Config::MODE;
+   m_options.spiWiring = Config::SPI_WIRING;
+   return m_isOk && writeOptions(
+      Config::CTRL_MEAS, Config::CONFIG,
+      Config::MEASURE_TIME, Config::OUT_DATA_PERIOD
+   );
+}
+inline void Bmp280Device::setPollInterval(int ms) {
+   m_pollInterval = (ms > 0)? ms : 1;
+}
+inline void Bmp280Device::setPollDeadline(int ms) {
+   m_pollDeadline = ms;
+}
+inline int Bmp280Device::getConversionTime() const {
+   return m_conversionTime;
+}
 inline void Bmp280Device::setMode(VAL_MODE val) {
-   m_isOptionsSet = false;
-   m_options.mode = val;
+   if (m_options.mode != val) {
+      m_isOptionsSet = false;
+      m_options.mode = val;
+   }
 }
 inline void Bmp280Device::setFilter(VAL_FILTER val) {
-   m_isOptionsSet = false;
-   m_options.filter = val;
+   if (m_options.filter != val) {
+      m_isOptionsSet = false;
+      m_options.filter = val;
+   }
 }
 inline void Bmp280Device::setOversampPress(VAL_OVERSAMP val) {
-   m_isOptionsSet = false;
-   m_options.oversampPress = val;
+   if (m_options.oversampPress != val) {
+      m_isOptionsSet = false;
+      m_options.oversampPress = val;
+   }
 }
 inline void Bmp280Device::setOversampTmprt(VAL_OVERSAMP val) {
-   m_isOptionsSet = false;
-   m_options.oversampTmprt = val;
+   if (m_options.oversampTmprt != val) {
+      m_isOptionsSet = false;
+      m_options.oversampTmprt = val;
+   }
 }
 inline void Bmp280Device::setStandbyTime(VAL_STANDBY val) {
-   m_isOptionsSet = false;
-   m_options.standbyTime = val;
+   if (m_options.standbyTime != val) {
+      m_isOptionsSet = false;
+      m_options.standbyTime = val;
+   }
 }
 inline void Bmp280Device::setSpiWiring(VAL_SPI_WIRING val) {
-   m_isOptionsSet = false;
-   m_options.spiWiring = val;
+   if (m_options.spiWiring != val) {
+      m_isOptionsSet = false;
+      m_options.spiWiring = val;
+   }
 }
 
 #endif
@@ -0,0 +1,339 @@
+/*
+* Author:  agent
+* Written: 10/16/2026
+*
+* BMP280 - In-process emulation of the device, as a Bmp280Device::Interface
+*/
+#include <string.h>
+#include "Bmp280Emulator.h"
+
+// trimming parameters of the datasheet example (3.12), little endian
+static unsigned char const exampleCalib[24] = {
+   0x70, 0x6B, 0x43, 0x67, 0x18, 0xFC,             // T1..T3
+   0x7D, 0x8E, 0x43, 0xD6, 0xD0, 0x0B, 0x27, 0x0B, // P1..P4
+   0x8C, 0x00, 0xF9, 0xFF, 0x8C, 0x3C, 0xF8, 0xC6, // P5..P8
+   0x70, 0x17                                      // P9
+};
+
+/*---------------------------------------------Bmp280Emulator::Bmp280Emulator-+
+| The raw values are those of the datasheet example: 100653.27 Pa, 25.08 C    |
++----------------------------------------------------------------------------*/
+Bmp280Emulator::Bmp280Emulator(
+   bool isSpi,
+   unsigned int clockHz,
+   unsigned char const * calib
+) :
+m_isSpi(isSpi),
+m_timing(TIMING_TYPICAL),
+m_clockHz(0),
+m_time(0),
+m_adcPress(415148),
+m_adcTmprt(519888)
+{
+   memset(m_regs, 0, sizeof m_regs);
+   memcpy(
+      m_regs + REG_CALIB, calib? calib : exampleCalib, sizeof exampleCalib
+   );
+   m_regs[REG_CHIP_ID] = CHIP_ID;
+   m_compensation.populate(m_regs + REG_CALIB);
+   setClock(clockHz);
+   resetStats();
+   reset();                        // as at power on
+}
+
+/*---------------------------------------------------Bmp280Emulator::setClock-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+void Bmp280Emulator::setClock(unsigned int clockHz) {
+   if (clockHz) {
+      m_clockHz = clockHz;
+   }else {
+      m_clockHz = m_isSpi? 10000000 : 400000;
+   }
+}
+
+/*---------------------------------------------Bmp280Emulator::setEnvironment-+
+| Find the raw values which compensate to the given pressure and temperature. |
+| Both compensations are monotonic over the 20-bit range: a binary search     |
+| does it, the temperature first, as it is required by the pressure.          |
+| The measures which ended before now are run first, in the old environment.  |
++----------------------------------------------------------------------------*/
+void Bmp280Emulator::setEnvironment(double pressure, double temperature) {
+   double press;
+   double tmprt;
+   int32_t lo = 0;
+   int32_t hi = 0xFFFFF;
+
+   update();
+   while (lo < hi) {               // temperature grows with the raw value
+      int32_t mid = (lo + hi) / 2;
+      m_compensation.compensate(RAW_SKIPPED, mid, press, tmprt);
+      if (tmprt < temperature) lo = mid + 1; else hi = mid;
+   }
+   m_adcTmprt = lo;
+   lo = 0;
+   hi = 0xFFFFF;
+   while (lo < hi) {               // pressure decreases as the raw value grows
+      int32_t mid = (lo + hi) / 2;
+      m_compensation.compensate(mid, m_adcTmprt, press, tmprt);
+      if (press > pressure) lo = mid + 1; else hi = mid;
+   }
+   m_adcPress = lo;
+}
+
+/*----------------------------------------------------Bmp280Emulator::advance-+
+| Let the time pass: the device state is updated at the next transfer.        |
++----------------------------------------------------------------------------*/
+void Bmp280Emulator::advance(long long nanos) {
+   if (nanos > 0) m_time += nanos;
+}
+
+/*-------------------------------------------------Bmp280Emulator::resetStats-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+void Bmp280Emulator::resetStats() {
+   memset(&m_stats, 0, sizeof m_stats);
+}
+
+/*------------------------------------------------------Bmp280Emulator::sleep-+
+| No real sleep: the virtual time just advances.                              |
++----------------------------------------------------------------------------*/
+void Bmp280Emulator::sleep(int ms) {
+   advance(1000000LL * ms);
+}
+
+/*------------------------------------------------------Bmp280Emulator::write-+
+| (register, value) pairs.  In SPI mode, the bit 7 of the register address    |
+| must be cleared (it means "read" otherwise.)                                |
+| The values are written when the transfer is done.                           |
++----------------------------------------------------------------------------*/
+bool Bmp280Emulator::write(void const * buf, int len) {
+   unsigned char const * pairs = (unsigned char const *)buf;
+   bool isOk = (len > 0) && ((len & 1) == 0);
+
+   for (int i=0; isOk && (i < len); i += 2) {
+      if (m_isSpi && (pairs[i] & 0x80)) isOk = false;
+   }
+   chargeBus(m_isSpi? len : 1 + len, 2); // I2C: start, address, ..., stop
+   if (!isOk) {
+      ++m_stats.errors;
+      return false;
+   }
+   update();
+   for (int i=0; i < len; i += 2) {
+      writeReg(m_isSpi? (pairs[i] | 0x80) : pairs[i], pairs[i+1]);
+   }
+   return true;
+}
+
+/*----------------------------------------------------Bmp280Emulator::readReg-+
+| Auto-increment read.  In SPI mode, the bit 7 of the register address must   |
+| be set.  The values are those at the start of the transfer (the device      |
+| shadows the VALUES registers during a burst read.)                          |
++----------------------------------------------------------------------------*/
+bool Bmp280Emulator::readReg(unsigned char reg, void * buf, int len) {
+   unsigned char * values = (unsigned char *)buf;
+
+   if ((len <= 0) || (m_isSpi && !(reg & 0x80))) {
+      chargeBus(m_isSpi? 1 : 2, 2);
+      ++m_stats.errors;
+      return false;
+   }
+   update();
+   for (int i=0; i < len; ++i) {
+      values[i] = m_regs[(unsigned char)(reg + i)];
+   }
+   if ((reg <= REG_VALUES + 5) && (reg + len > REG_VALUES)) {
+      ++m_stats.reads;
+      if (m_isValuesRead) ++m_stats.staleReads;
+      m_isValuesRead = true;
+   }
+   chargeBus(m_isSpi? 1 + len : 3 + len, 3); // I2C: address sent twice
+   return true;
+}
+
+/*------------------------------------------------------Bmp280Emulator::reset-+
+| Power on, or soft reset: the calibration and the chip id are kept (NVM.)    |
++----------------------------------------------------------------------------*/
+void Bmp280Emulator::reset() {
+   memset(m_regs + REG_SOFT_RESET, 0, 0x100 - REG_SOFT_RESET);
+   putRaw(m_regs + REG_VALUES, RAW_SKIPPED);
+   putRaw(m_regs + REG_VALUES + 3, RAW_SKIPPED);
+   m_nvmEnd = m_time + NVM_COPY_TIME;
+   m_isMeasuring = false;
+   m_measureEnd = m_nextStart = m_time;
+   m_measureCtrl = 0;
+   m_isFilterPrimed = false;
+   m_filterPress = m_filterTmprt = 0.0;
+   m_isValuesRead = true;          // nothing new to read
+   m_regs[REG_STATUS] = 0x01;      // im_update
+}
+
+/*-----------------------------------------------------Bmp280Emulator::update-+
+| Run the measures which started, or ended, since the last update, then set   |
+| the STATUS register accordingly.                                            |
++----------------------------------------------------------------------------*/
+void Bmp280Emulator::update() {
+   for (;;) {
+      if (m_isMeasuring) {
+         if (m_time < m_measureEnd) break;
+         endMeasure();
+      }else if (
+         ((m_regs[REG_CTRL_MEAS] & 0x03) == 0x03) && (m_time >= m_nextStart)
+      ) {
+         startMeasure(m_nextStart);
+      }else {
+         break;
+      }
+   }
+   m_regs[REG_STATUS] = (
+      (m_isMeasuring? 0x08 : 0x00) | ((m_time < m_nvmEnd)? 0x01 : 0x00)
+   );
+}
+
+/*-----------------------------------------------Bmp280Emulator::startMeasure-+
+| The oversampling settings are latched at the start of the measure.          |
++----------------------------------------------------------------------------*/
+void Bmp280Emulator::startMeasure(long long start) {
+   m_measureCtrl = m_regs[REG_CTRL_MEAS];
+   m_measureEnd = start + getMeasureTime(m_measureCtrl);
+   m_isMeasuring = true;
+}
+
+/*-------------------------------------------------Bmp280Emulator::endMeasure-+
+| Filter the raw values, and store them in the VALUES registers.              |
+| A skipped measure (no oversampling) reads as 0x80000.                       |
+| Once done, a FORCED mode measure goes back to the SLEEP mode, while a       |
+| NORMAL mode measure schedules the next one after the standby time.          |
++----------------------------------------------------------------------------*/
+void Bmp280Emulator::endMeasure() {
+   int osTmprt = (m_measureCtrl >> 5) & 0x07;
+   int osPress = (m_measureCtrl >> 2) & 0x07;
+   int filter = (m_regs[REG_CONFIG] >> 2) & 0x07;
+   int32_t adcTmprt;
+   int32_t adcPress;
+
+   if (filter) {                   // 20-bit resolution
+      double coeff = 1 << ((filter > 4)? 4 : filter);
+      if (!m_isFilterPrimed) {
+         m_filterTmprt = m_adcTmprt;
+         m_filterPress = m_adcPress;
+         m_isFilterPrimed = true;
+      }
+      if (osTmprt) m_filterTmprt += (m_adcTmprt - m_filterTmprt) / coeff;
+      if (osPress) m_filterPress += (m_adcPress - m_filterPress) / coeff;
+      adcTmprt = (int32_t)(m_filterTmprt + 0.5);
+      adcPress = (int32_t)(m_filterPress + 0.5);
+   }else {                         // 16 to 20-bit resolution
+      adcTmprt = applyResolution(m_adcTmprt, osTmprt);
+      adcPress = applyResolution(m_adcPress, osPress);
+   }
+   putRaw(m_regs + REG_VALUES, osPress? adcPress : RAW_SKIPPED);
+   putRaw(m_regs + REG_VALUES + 3, osTmprt? adcTmprt : RAW_SKIPPED);
+   m_isMeasuring = false;
+   m_isValuesRead = false;
+   ++m_stats.conversions;
+   switch (m_regs[REG_CTRL_MEAS] & 0x03) {
+   case 0x01:
+   case 0x02:
+      m_regs[REG_CTRL_MEAS] &= ~0x03;
+      break;
+   case 0x03:
+      m_nextStart = m_measureEnd + getStandbyTime();
+      break;
+   default:
+      break;
+   }
+}
+
+/*---------------------------------------------Bmp280Emulator::getMeasureTime-+
+| Datasheet, 3.8.1.  The oversampling factor is: (1 << oversamp) >> 1         |
++----------------------------------------------------------------------------*/
+long long Bmp280Emulator::getMeasureTime(unsigned char ctrlMeas) const {
+   int osTmprt = (ctrlMeas >> 5) & 0x07;
+   int osPress = (ctrlMeas >> 2) & 0x07;
+   long long factor = (
+      ((1 << ((osTmprt > 5)? 5 : osTmprt)) >> 1) +
+      ((1 << ((osPress > 5)? 5 : osPress)) >> 1)
+   );
+   if (m_timing == TIMING_MAXIMUM) {
+      return 1250000 + (2300000 * factor) + (osPress? 575000 : 0);
+   }else {
+      return 1000000 + (2000000 * factor) + (osPress? 500000 : 0);
+   }
+}
+
+/*---------------------------------------------Bmp280Emulator::getStandbyTime-+
+| 0.5 ms, then 62.5 ms to 4000 ms, doubling                                   |
++----------------------------------------------------------------------------*/
+long long Bmp280Emulator::getStandbyTime() const {
+   int standby = (m_regs[REG_CONFIG] >> 5) & 0x07;
+   return standby? (62500000LL << (standby - 1)) : 500000LL;
+}
+
+/*---------------------------------------------------Bmp280Emulator::writeReg-+
+| Only SOFT_RESET, CTRL_MEAS and CONFIG are writable.                         |
+| Writes to CONFIG are ignored in NORMAL mode (datasheet, 5.4.6: they "may    |
+| be ignored", which is what a driver must expect.)                           |
++----------------------------------------------------------------------------*/
+void Bmp280Emulator::writeReg(unsigned char reg, unsigned char value) {
+   int mode = m_regs[REG_CTRL_MEAS] & 0x03;
+
+   switch (reg) {
+   case REG_SOFT_RESET:
+      if (value == RESET_WORD) reset();
+      break;
+   case REG_CTRL_MEAS:
+      m_regs[REG_CTRL_MEAS] = value;
+      if (m_isMeasuring) {
+         break;                    // the next measure is set by endMeasure
+      }else if ((value & 0x03) == 0x03) {
+         if (mode != 0x03) startMeasure(m_time);
+      }else if (value & 0x03) {
+         startMeasure(m_time);     // FORCED
+      }
+      break;
+   case REG_CONFIG:
+      if (mode != 0x03) m_regs[REG_CONFIG] = value;
+      break;
+   default:                        // read only
+      break;
+   }
+   update();
+}
+
+/*--------------------------------------------------Bmp280Emulator::chargeBus-+
+| I2C: 9 bits per byte (acknowledge), plus the start / stop conditions.       |
+| SPI: 8 bits per byte.                                                       |
++----------------------------------------------------------------------------*/
+void Bmp280Emulator::chargeBus(int bytes, int extraBits) {
+   long long bits = m_isSpi? (8LL * bytes) : ((9LL * bytes) + extraBits);
+   long long nanos = (bits * 1000000000LL) / m_clockHz;
+
+   m_time += nanos;
+   ++m_stats.transfers;
+   m_stats.bytes += bytes;
+   m_stats.busTime += nanos;
+}
+
+/*STATIC--------------------------------------Bmp280Emulator::applyResolution-+
+| 16 bits at x1 oversampling, one more bit per oversampling step, up to 20.   |
++----------------------------------------------------------------------------*/
+int32_t Bmp280Emulator::applyResolution(int32_t adc, int oversamp) {
+   if ((oversamp <= 0) || (oversamp >= 5)) {
+      return adc;
+   }else {
+      return adc & ~((1 << (5 - oversamp)) - 1);
+   }
+}
+
+/*STATIC-----------------------------------------------Bmp280Emulator::putRaw-+
+| The 20-bit value, MSB first, left aligned on the XLSB byte                  |
++----------------------------------------------------------------------------*/
+void Bmp280Emulator::putRaw(unsigned char * buf, int32_t adc) {
+   buf[0] = (unsigned char)(adc >> 12);
+   buf[1] = (unsigned char)(adc >> 4);
+   buf[2] = (unsigned char)((adc << 4) & 0xF0);
+}
+
+/*===========================================================================*/
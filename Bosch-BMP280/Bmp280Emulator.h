@@ -0,0 +1,127 @@
+/*
+* Author:  agent
+* Written: 10/16/2026
+*
+* BMP280 - In-process emulation of the device, as a Bmp280Device::Interface
+*
+* The register file (CALIB, CHIP_ID, SOFT_RESET, STATUS, CTRL_MEAS, CONFIG
+* and VALUES) behaves as described in the Bosch datasheet:
+* - FORCED and NORMAL modes, conversion time per oversampling (typical or
+*   maximum), standby time between the NORMAL mode measures;
+* - "measuring" and "im_update" bits of the STATUS register;
+* - IIR filter, and resolution of the raw values per oversampling;
+* - CONFIG writes ignored in NORMAL mode.
+*
+* Time is virtual, in nanoseconds.  It only advances by sleep() and by the
+* bus cost of each transfer (clock frequency and bytes on the wire), so the
+* results do not depend on the host: sample rates and bus time per sample
+* can be measured for every driver mode without any chip.
+*
+* The raw values are derived from the pressure and temperature given to
+* setEnvironment, by inverting the compensation formulas.
+*/
+#ifndef _BMP280EMULATOR_H_
+#define _BMP280EMULATOR_H_
+
+#include "Bmp280Device.h"
+
+class Bmp280Emulator : public Bmp280Device::Interface {
+public:
+   enum TIMING {
+      TIMING_TYPICAL,              // datasheet, 3.8.1: t_measure,typ
+      TIMING_MAXIMUM               // datasheet, 3.8.1: t_measure,max
+   };
+   struct Stats {
+      long long transfers;         // writes and register reads
+      long long bytes;             // on the wire, addresses included
+      long long busTime;           // in nanoseconds
+      long long conversions;       // completed measures
+      long long reads;             // reads of the VALUES registers
+      long long staleReads;        // ... returning an already read measure
+      long long errors;            // rejected transfers
+   };
+
+   Bmp280Emulator(
+      bool isSpi = false,
+      unsigned int clockHz = 0,            // 0: 400 kHz (I2C), 10 MHz (SPI)
+      unsigned char const * calib = 0      // 0: the datasheet example
+   );
+   void setClock(unsigned int clockHz);
+   void setTiming(TIMING timing);
+   void setEnvironment(double pressure, double temperature); // Pa, Celsius
+   long long getTime() const;              // in nanoseconds
+   void advance(long long nanos);
+   void getStats(Stats & stats) const;
+   void resetStats();
+
+   bool isSpi() const;
+   void sleep(int ms);
+   bool write(void const * buf, int len);
+   bool readReg(unsigned char reg, void * buf, int len);
+
+private:
+   enum REG {
+      REG_CALIB = 0x88,
+      REG_CHIP_ID = 0xD0,
+      REG_SOFT_RESET = 0xE0,
+      REG_STATUS = 0xF3,
+      REG_CTRL_MEAS = 0xF4,
+      REG_CONFIG = 0xF5,
+      REG_VALUES = 0xF7
+   };
+   enum {
+      CHIP_ID = 0x58,
+      RESET_WORD = 0xB6,
+      NVM_COPY_TIME = 500000,      // im_update, after a reset (ns)
+      RAW_SKIPPED = 0x80000        // the value of a skipped measure
+   };
+
+   unsigned char m_regs[256];
+   Bmp280DoubleCompensation m_compensation;
+   bool const m_isSpi;
+   TIMING m_timing;
+   unsigned int m_clockHz;
+   long long m_time;
+   long long m_nvmEnd;             // im_update is set until then
+   bool m_isMeasuring;
+   long long m_measureEnd;         // of the current measure
+   long long m_nextStart;          // of the next NORMAL mode measure
+   unsigned char m_measureCtrl;    // CTRL_MEAS at the start of the measure
+   int32_t m_adcPress;             // unfiltered, full resolution
+   int32_t m_adcTmprt;
+   bool m_isFilterPrimed;
+   double m_filterPress;
+   double m_filterTmprt;
+   bool m_isValuesRead;
+   Stats m_stats;
+
+   void reset();
+   void update();
+   void startMeasure(long long start);
+   void endMeasure();
+   long long getMeasureTime(unsigned char ctrlMeas) const;
+   long long getStandbyTime() const;
+   void writeReg(unsigned char reg, unsigned char value);
+   void chargeBus(int bytes, int extraBits);
+   static int32_t applyResolution(int32_t adc, int oversamp);
+   static void putRaw(unsigned char * buf, int32_t adc);
+};
+
+/*--------+
+| INLINES |
++--------*/
+inline bool Bmp280Emulator::isSpi() const {
+   return m_isSpi;
+}
+inline void Bmp280Emulator::setTiming(TIMING timing) {
+   m_timing = timing;
+}
+inline long long Bmp280Emulator::getTime() const {
+   return m_time;
+}
+inline void Bmp280Emulator::getStats(Stats & stats) const {
+   stats = m_stats;
+}
+
+#endif
+/*===========================================================================*/
@@ -0,0 +1,95 @@
+/*
+* Author:  agent
+* Written: 10/16/2026
+*
+* BMP280 - Linux i2c-dev implementation of Bmp280Device::Interface
+*/
+#include <unistd.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <linux/i2c-dev.h>
+#include "Bmp280I2c.h"
+
+/*-------------------------------------Bmp280I2cInterface::Bmp280I2cInterface-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+Bmp280I2cInterface::Bmp280I2cInterface(char const * path, int i2cAddr) :
+m_fd(::open(path, O_RDWR)),
+m_isOwner(true),
+m_addr((unsigned short)i2cAddr)
+{
+   if (m_fd < 0) {
+      printf("Can't open %s\n", path);
+   }
+}
+
+/*-------------------------------------Bmp280I2cInterface::Bmp280I2cInterface-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+Bmp280I2cInterface::Bmp280I2cInterface(int fd, int i2cAddr) :
+m_fd(fd),
+m_isOwner(false),
+m_addr((unsigned short)i2cAddr)
+{}
+
+/*------------------------------------Bmp280I2cInterface::~Bmp280I2cInterface-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+Bmp280I2cInterface::~Bmp280I2cInterface() {
+   if (m_isOwner && (m_fd >= 0)) { ::close(m_fd); m_fd = -1; }
+}
+
+/*--------------------------------------------------Bmp280I2cInterface::sleep-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+void Bmp280I2cInterface::sleep(int ms) {
+   usleep(1000 * ms);
+}
+
+/*--------------------------------------------------Bmp280I2cInterface::write-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+bool Bmp280I2cInterface::write(void const * buf, int len) {
+   struct i2c_msg msg;
+   msg.addr = m_addr;
+   msg.flags = 0;
+   msg.len = (unsigned short)len;
+   msg.buf = (unsigned char *)buf;
+   return transfer(&msg, 1);
+}
+
+/*------------------------------------------------Bmp280I2cInterface::readReg-+
+| Write the register address, then read 'len' bytes after a repeated start    |
++----------------------------------------------------------------------------*/
+bool Bmp280I2cInterface::readReg(unsigned char reg, void * buf, int len) {
+   struct i2c_msg msgs[2];
+   msgs[0].addr = m_addr;
+   msgs[0].flags = 0;
+   msgs[0].len = 1;
+   msgs[0].buf = &reg;
+   msgs[1].addr = m_addr;
+   msgs[1].flags = I2C_M_RD;
+   msgs[1].len = (unsigned short)len;
+   msgs[1].buf = (unsigned char *)buf;
+   return transfer(msgs, 2);
+}
+
+/*-----------------------------------------------Bmp280I2cInterface::transfer-+
+| The messages are separated by repeated starts, with a single STOP at the    |
+| end of the transfer.                                                        |
++----------------------------------------------------------------------------*/
+bool Bmp280I2cInterface::transfer(struct i2c_msg * msgs, int count) {
+   struct i2c_rdwr_ioctl_data data;
+   data.msgs = msgs;
+   data.nmsgs = count;
+   return control(I2C_RDWR, &data) == count;
+}
+
+/*PROTECTED---------------------------------------Bmp280I2cInterface::control-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+int Bmp280I2cInterface::control(unsigned long request, void * arg) {
+   return (m_fd >= 0)? ::ioctl(m_fd, request, arg) : -1;
+}
+/*===========================================================================*/
@@ -0,0 +1,53 @@
+/*
+* Author:  agent
+* Written: 10/16/2026
+*
+* BMP280 - Linux i2c-dev implementation of Bmp280Device::Interface
+*
+* Each register read is a single combined transfer (write the register
+* address, repeated start, read the values) issued by one ioctl(I2C_RDWR),
+* rather than a write() followed by a read().
+*/
+#ifndef _BMP280I2C_H_
+#define _BMP280I2C_H_
+
+#include <linux/i2c.h>
+#include "Bmp280Device.h"
+
+class Bmp280I2cInterface : public Bmp280Device::Interface {
+public:
+   Bmp280I2cInterface(char const * path, int i2cAddr); // ex: "/dev/i2c-1"
+   Bmp280I2cInterface(int fd, int i2cAddr);            // fd is not owned
+   virtual ~Bmp280I2cInterface();
+   bool isOk() const;
+
+   bool isSpi() const;
+   void sleep(int ms);
+   bool write(void const * buf, int len);
+   bool readReg(unsigned char reg, void * buf, int len);
+
+   // several messages in a single ioctl (up to I2C_RDWR_IOCTL_MAX_MSGS)
+   bool transfer(struct i2c_msg * msgs, int count);
+
+protected:
+   // the only system call of a transfer: overridden to count or to emulate
+   virtual int control(unsigned long request, void * arg);
+
+private:
+   int m_fd;
+   bool m_isOwner;
+   unsigned short m_addr;
+};
+
+/*--------+
+| INLINES |
++--------*/
+inline bool Bmp280I2cInterface::isOk() const {
+   return m_fd >= 0;
+}
+inline bool Bmp280I2cInterface::isSpi() const {
+   return false;
+}
+
+#endif
+/*===========================================================================*/
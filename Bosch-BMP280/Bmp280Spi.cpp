@@ -0,0 +1,167 @@
+/*
+* Author:  agent
+* Written: 10/16/2026
+*
+* BMP280 - Linux spidev implementation of Bmp280Device::Interface
+*/
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <linux/spi/spidev.h>
+#include "Bmp280Spi.h"
+
+/*-------------------------------------Bmp280SpiInterface::Bmp280SpiInterface-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+Bmp280SpiInterface::Bmp280SpiInterface(
+   char const * path,
+   unsigned int speedHz,
+   Bmp280Device::VAL_SPI_WIRING wiring
+) :
+m_fd(::open(path, O_RDWR)),
+m_isOwner(true),
+m_isOk(false),
+m_is3Wire(false),
+m_speedHz(speedHz)
+{
+   if (m_fd < 0) {
+      printf("Can't open %s\n", path);
+   }else {
+      init(wiring);
+   }
+}
+
+/*-------------------------------------Bmp280SpiInterface::Bmp280SpiInterface-+
+| With a fd of -1, the subclass overriding control() must call init()         |
++----------------------------------------------------------------------------*/
+Bmp280SpiInterface::Bmp280SpiInterface(
+   int fd,
+   unsigned int speedHz,
+   Bmp280Device::VAL_SPI_WIRING wiring
+) :
+m_fd(fd),
+m_isOwner(false),
+m_isOk(false),
+m_is3Wire(false),
+m_speedHz(speedHz)
+{
+   if (m_fd >= 0) init(wiring);
+}
+
+/*------------------------------------Bmp280SpiInterface::~Bmp280SpiInterface-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+Bmp280SpiInterface::~Bmp280SpiInterface() {
+   if (m_isOwner && (m_fd >= 0)) { ::close(m_fd); m_fd = -1; }
+}
+
+/*PROTECTED------------------------------------------Bmp280SpiInterface::init-+
+| The BMP280 supports the SPI modes '00' and '11'.  The result is kept for    |
+| isOk().                                                                     |
++----------------------------------------------------------------------------*/
+bool Bmp280SpiInterface::init(Bmp280Device::VAL_SPI_WIRING wiring) {
+   unsigned char bits = 8;
+   if (
+      (control(SPI_IOC_WR_BITS_PER_WORD, &bits) < 0) ||
+      (control(SPI_IOC_WR_MAX_SPEED_HZ, &m_speedHz) < 0) ||
+      !setWiring(wiring)
+   ) {
+      printf("Can't set the SPI mode\n");
+      m_isOk = false;
+   }else {
+      m_isOk = true;
+   }
+   return m_isOk;
+}
+
+/*PROTECTED---------------------------------------Bmp280SpiInterface::control-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+int Bmp280SpiInterface::control(unsigned long request, void * arg) {
+   return (m_fd >= 0)? ::ioctl(m_fd, request, arg) : -1;
+}
+
+/*----------------------------------------------Bmp280SpiInterface::setWiring-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+bool Bmp280SpiInterface::setWiring(Bmp280Device::VAL_SPI_WIRING wiring) {
+   unsigned char mode = SPI_MODE_0;
+   if (wiring == Bmp280Device::VAL_SPI_WIRING_3) mode |= SPI_3WIRE;
+   if (control(SPI_IOC_WR_MODE, &mode) >= 0) {
+      m_is3Wire = (wiring == Bmp280Device::VAL_SPI_WIRING_3);
+      return true;
+   }else {
+      return false;
+   }
+}
+
+/*--------------------------------------------------Bmp280SpiInterface::sleep-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+void Bmp280SpiInterface::sleep(int ms) {
+   usleep(1000 * ms);
+}
+
+/*--------------------------------------------------Bmp280SpiInterface::write-+
+| 'buf' is made of (register, value) pairs, written in a single transfer.     |
+| A soft reset sets the 4-wire mode, the CONFIG register may change it.       |
++----------------------------------------------------------------------------*/
+bool Bmp280SpiInterface::write(void const * buf, int len) {
+   struct spi_ioc_transfer xfer;
+   unsigned char const * pairs = (unsigned char const *)buf;
+   bool is3Wire = m_is3Wire;
+
+   memset(&xfer, 0, sizeof xfer);
+   xfer.tx_buf = (unsigned long)buf;
+   xfer.len = len;
+   xfer.speed_hz = m_speedHz;
+   xfer.bits_per_word = 8;
+   if (control(SPI_IOC_MESSAGE(1), &xfer) != len) {
+      return false;
+   }
+   for (int i=0; i+1 < len; i += 2) {
+      if (pairs[i] == 0x60) {       // REG_SOFT_RESET & 0x7F
+         is3Wire = false;
+      }else if (pairs[i] == 0x75) { // REG_CONFIG & 0x7F
+         is3Wire = (pairs[i+1] & 0x01) != 0;
+      }
+   }
+   return (is3Wire == m_is3Wire) || setWiring(
+      is3Wire? Bmp280Device::VAL_SPI_WIRING_3 : Bmp280Device::VAL_SPI_WIRING_4
+   );
+}
+
+/*------------------------------------------------Bmp280SpiInterface::readReg-+
+| 4-wire: a single full-duplex transfer, the values follow the address byte.  |
+| 3-wire: the address, then the values, in the same message (CS kept low.)    |
++----------------------------------------------------------------------------*/
+bool Bmp280SpiInterface::readReg(unsigned char reg, void * buf, int len) {
+   struct spi_ioc_transfer xfer[2];
+
+   if (len > MAXLEN) return false;
+   memset(xfer, 0, sizeof xfer);
+   xfer[0].speed_hz = xfer[1].speed_hz = m_speedHz;
+   xfer[0].bits_per_word = xfer[1].bits_per_word = 8;
+   m_tx[0] = reg;
+   if (m_is3Wire) {
+      xfer[0].tx_buf = (unsigned long)m_tx;
+      xfer[0].len = 1;
+      xfer[1].rx_buf = (unsigned long)buf;
+      xfer[1].len = len;
+      return control(SPI_IOC_MESSAGE(2), xfer) == 1 + len;
+   }else {
+      memset(m_tx+1, 0, len);
+      xfer[0].tx_buf = (unsigned long)m_tx;
+      xfer[0].rx_buf = (unsigned long)m_rx;
+      xfer[0].len = 1 + len;
+      if (control(SPI_IOC_MESSAGE(1), xfer) != 1 + len) {
+         return false;
+      }else {
+         memcpy(buf, m_rx+1, len);
+         return true;
+      }
+   }
+}
+/*===========================================================================*/
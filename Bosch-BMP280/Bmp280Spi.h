@@ -0,0 +1,65 @@
+/*
+* Author:  agent
+* Written: 10/16/2026
+*
+* BMP280 - Linux spidev implementation of Bmp280Device::Interface
+*
+* The register address and the payload are merged in a single transfer.
+* Writes to the CONFIG register are watched to follow the spi3w_en bit
+* (see Bmp280Device::setSpiWiring): in 3-wire mode, reads are half-duplex.
+*/
+#ifndef _BMP280SPI_H_
+#define _BMP280SPI_H_
+
+#include "Bmp280Device.h"
+
+class Bmp280SpiInterface : public Bmp280Device::Interface {
+public:
+   Bmp280SpiInterface(                // ex: "/dev/spidev0.0"
+      char const * path,
+      unsigned int speedHz = 10000000,
+      Bmp280Device::VAL_SPI_WIRING wiring = Bmp280Device::VAL_SPI_WIRING_4
+   );
+   Bmp280SpiInterface(                // fd is not owned
+      int fd,
+      unsigned int speedHz = 10000000,
+      Bmp280Device::VAL_SPI_WIRING wiring = Bmp280Device::VAL_SPI_WIRING_4
+   );
+   virtual ~Bmp280SpiInterface();
+   bool isOk() const;
+   bool setWiring(Bmp280Device::VAL_SPI_WIRING wiring);
+
+   bool isSpi() const;
+   void sleep(int ms);
+   bool write(void const * buf, int len);
+   bool readReg(unsigned char reg, void * buf, int len);
+
+protected:
+   // a stand-in (fd is -1) calls init() from its own constructor
+   bool init(Bmp280Device::VAL_SPI_WIRING wiring);
+   // the only system call: overridden to count or to emulate
+   virtual int control(unsigned long request, void * arg);
+
+private:
+   enum { MAXLEN = 32 };           // the largest read is the calibration
+   int m_fd;
+   bool m_isOwner;
+   bool m_isOk;
+   bool m_is3Wire;
+   unsigned int m_speedHz;
+   unsigned char m_tx[1 + MAXLEN];
+   unsigned char m_rx[1 + MAXLEN];
+};
+
+/*--------+
+| INLINES |
++--------*/
+inline bool Bmp280SpiInterface::isOk() const {
+   return m_isOk;
+}
+inline bool Bmp280SpiInterface::isSpi() const {
+   return true;
+}
+
+#endif
+/*===========================================================================*/
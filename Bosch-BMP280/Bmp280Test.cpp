@@ -6,50 +6,53 @@
 *
 * An implementation example to demonstrate the Bmp280Device class.
 *
+* Without argument, reads the BMP280 at 0x76 on /dev/i2c-1.
+* No hardware is needed for:
+* - "Bmp280Test check": correctness checks, exit code 1 on failure;
+* - "Bmp280Test bench": benchmarks.
+*
 * Compile with:
-* g++ Bmp280Device.cpp Bmp280Test.cpp -o Bmp280Test
+* g++ -O2 Bmp280Device.cpp Bmp280Calibration.cpp Bmp280Capture.cpp \
+*    Bmp280I2c.cpp Bmp280Spi.cpp Bmp280Emulator.cpp Bmp280Test.cpp \
+*    -o Bmp280Test
+* Add -mavx2 (x86) to build, and check, the vector batch compensation.
 */
 #include <unistd.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <fcntl.h>
-#include <sys/types.h>
-#include <sys/stat.h>
-#include <sys/ioctl.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
 #include <linux/i2c-dev.h>
+#include <linux/spi/spidev.h>
 #include "Bmp280Device.h"
+#include "Bmp280Config.h"
+#include "Bmp280I2c.h"
+#include "Bmp280Spi.h"
+#include "Bmp280Emulator.h"
 
-class MyInterface: public Bmp280Device::Interface {
-public:
-   MyInterface(int i2cAddr) {
-      if (((m_fd = ::open("/dev/i2c-1", O_RDWR)) < 0) ||
-         (ioctl(m_fd, I2C_SLAVE, i2cAddr) < 0)) {
-         printf("Can't open I2C at address %d\n", i2cAddr);
-         exit(2);
-      }
-   }
-   virtual ~MyInterface() {
-      if (m_fd >= 0) { ::close(m_fd); m_fd = -1; }
-   }
-   bool isSpi() const { return false; } // it's an I2C interface
-   void sleep(int ms) { usleep(1000 * ms); }
-   bool write(void const * buf, int len) {
-      return (m_fd >= 0)? ::write(m_fd, buf, len) == len : false;
-   }
-   bool readReg(unsigned char reg, void * buf, int len) {
-      return (
-         ((m_fd >= 0) && (::write(m_fd, &reg, 1)==1)) ?
-         (::read(m_fd, buf, len)==len) : false
-      );
-   }
-private:
-   int m_fd;
-};
+#if defined __x86_64__ || defined __i386__
+#include <x86intrin.h>
+#define HAS_TSC
+#endif
+
+static bool check();
+static void bench();
 
 int main(int argc, char const * const * argv)
 {
+   if ((argc == 2) && (strcmp(argv[1], "check") == 0)) {
+      return check()? 0 : 1;
+   }else if ((argc == 2) && (strcmp(argv[1], "bench") == 0)) {
+      bench();
+      return 0;
+   }
+
    // 0x76 is the I2C address; it can be 0x77, depending on the chip wiring
-   MyInterface interface(0x76);
+   Bmp280I2cInterface interface("/dev/i2c-1", 0x76);
+   if (!interface.isOk()) {
+      exit(2);
+   }
    Bmp280Device device(interface);
    int outDataPeriod;
    double temperature;
@@ -80,4 +83,1158 @@ int main(int argc, char const * const * argv)
    }
    return 0;
 }
+
+// trimming parameters of the datasheet example (3.12), little endian
+static unsigned char const exampleCalib[24] = {
+   0x70, 0x6B, 0x43, 0x67, 0x18, 0xFC,             // T1..T3
+   0x7D, 0x8E, 0x43, 0xD6, 0xD0, 0x0B, 0x27, 0x0B, // P1..P4
+   0x8C, 0x00, 0xF9, 0xFF, 0x8C, 0x3C, 0xF8, 0xC6, // P5..P8
+   0x70, 0x17                                      // P9
+};
+
+/*------------------------------------------------------------ class BoschRef-+
+| The Bosch reference formulas, as printed in the datasheet (3.11.3 and 8.2), |
+| to check the fixed point engines against.                                   |
++----------------------------------------------------------------------------*/
+class BoschRef {
+public:
+   BoschRef(unsigned char const * buf);
+   int32_t compensate_T_int32(int32_t adc_T);
+   uint32_t compensate_P_int64(int32_t adc_P);
+   uint32_t compensate_P_int32(int32_t adc_P);
+private:
+   uint16_t dig_T1;
+   int16_t dig_T2, dig_T3;
+   uint16_t dig_P1;
+   int16_t dig_P2, dig_P3, dig_P4, dig_P5, dig_P6, dig_P7, dig_P8, dig_P9;
+   int32_t t_fine;
+};
+
+BoschRef::BoschRef(unsigned char const * buf) {
+   int16_t * const dig[] = {
+      (int16_t *)&dig_T1, &dig_T2, &dig_T3, (int16_t *)&dig_P1,
+      &dig_P2, &dig_P3, &dig_P4, &dig_P5, &dig_P6, &dig_P7, &dig_P8, &dig_P9
+   };
+   for (int i=0; i < 12; ++i) {
+      *dig[i] = (int16_t)(buf[2*i] | (buf[2*i+1] << 8));
+   }
+   t_fine = 0;
+}
+
+int32_t BoschRef::compensate_T_int32(int32_t adc_T) {
+   int32_t var1, var2, T;
+   var1 = ((((adc_T>>3) - ((int32_t)dig_T1<<1))) * ((int32_t)dig_T2)) >> 11;
+   var2 = (((((adc_T>>4) - ((int32_t)dig_T1)) *
+      ((adc_T>>4) - ((int32_t)dig_T1))) >> 12) * ((int32_t)dig_T3)) >> 14;
+   t_fine = var1 + var2;
+   T = (t_fine * 5 + 128) >> 8;
+   return T;
+}
+
+uint32_t BoschRef::compensate_P_int64(int32_t adc_P) {
+   int64_t var1, var2, p;
+   var1 = ((int64_t)t_fine) - 128000;
+   var2 = var1 * var1 * (int64_t)dig_P6;
+   var2 = var2 + ((var1*(int64_t)dig_P5)<<17);
+   var2 = var2 + (((int64_t)dig_P4)<<35);
+   var1 = ((var1 * var1 * (int64_t)dig_P3)>>8) +
+      ((var1 * (int64_t)dig_P2)<<12);
+   var1 = (((((int64_t)1)<<47)+var1))*((int64_t)dig_P1)>>33;
+   if (var1 == 0) {
+      return 0; // avoid exception caused by division by zero
+   }
+   p = 1048576-adc_P;
+   p = (((p<<31)-var2)*3125)/var1;
+   var1 = (((int64_t)dig_P9) * (p>>13) * (p>>13)) >> 25;
+   var2 = (((int64_t)dig_P8) * p) >> 19;
+   p = ((p + var1 + var2) >> 8) + (((int64_t)dig_P7)<<4);
+   return (uint32_t)p;
+}
+
+uint32_t BoschRef::compensate_P_int32(int32_t adc_P) {
+   int32_t var1, var2;
+   uint32_t p;
+   var1 = (((int32_t)t_fine)>>1) - (int32_t)64000;
+   var2 = (((var1>>2) * (var1>>2)) >> 11 ) * ((int32_t)dig_P6);
+   var2 = var2 + ((var1*((int32_t)dig_P5))<<1);
+   var2 = (var2>>2)+(((int32_t)dig_P4)<<16);
+   var1 = (((dig_P3 * (((var1>>2) * (var1>>2)) >> 13 )) >> 3) +
+      ((((int32_t)dig_P2) * var1)>>1))>>18;
+   var1 =((((32768+var1))*((int32_t)dig_P1))>>15);
+   if (var1 == 0) {
+      return 0; // avoid exception caused by division by zero
+   }
+   p = (((uint32_t)(((int32_t)1048576)-adc_P)-(var2>>12)))*3125;
+   if (p < 0x80000000) {
+      p = (p << 1) / ((uint32_t)var1);
+   }else {
+      p = (p / (uint32_t)var1) * 2;
+   }
+   var1 = (((int32_t)dig_P9) * ((int32_t)(((p>>3) * (p>>3))>>13)))>>12;
+   var2 = (((int32_t)(p>>2)) * ((int32_t)dig_P8))>>13;
+   p = (uint32_t)((int32_t)p + ((var1 + var2 + dig_P7) >> 4));
+   return p;
+}
+
+/*-----------------------------------------------------------------nextRandom-+
+| xorshift32: repeatable pseudo-random values                                 |
++----------------------------------------------------------------------------*/
+static uint32_t nextRandom(uint32_t & state) {
+   state ^= state << 13;
+   state ^= state >> 17;
+   state ^= state << 5;
+   return state;
+}
+
+/*-------------------------------------------------------------------getNanos-+
+| CLOCK_MONOTONIC, in nanoseconds                                             |
++----------------------------------------------------------------------------*/
+static long long getNanos() {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (ts.tv_sec * 1000000000LL) + ts.tv_nsec;
+}
+
+/*------------------------------------------------------ class RealTimeBmp280-+
+| The emulator, following the real time: sleep() sleeps, and each transfer    |
+| takes its bus time for real.                                                |
++----------------------------------------------------------------------------*/
+class RealTimeBmp280 : public Bmp280Emulator {
+public:
+   RealTimeBmp280(unsigned int clockHz) :
+   Bmp280Emulator(false, clockHz), m_start(getNanos()) {}
+   void sleep(int ms) { usleep(1000 * ms); sync(); }
+   bool write(void const * buf, int len) {
+      sync();
+      bool isOk = Bmp280Emulator::write(buf, len);
+      wait();
+      return isOk;
+   }
+   bool readReg(unsigned char reg, void * buf, int len) {
+      sync();
+      bool isOk = Bmp280Emulator::readReg(reg, buf, len);
+      wait();
+      return isOk;
+   }
+private:
+   long long m_start;
+   void sync() { advance(getNanos() - m_start - getTime()); }
+   void wait() {
+      long long ahead = getTime() - (getNanos() - m_start);
+      if (ahead > 0) usleep(ahead / 1000);
+   }
+};
+
+/*-----------------------------------------------------------checkCalibration-+
+| 1) The fixed point engines are bit-exact with the Bosch formulas: all the   |
+|    20-bit raw temperatures, and all the raw pressures at 5 temperatures,    |
+|    for the datasheet trimming and 7 random ones.                            |
+| 2) Against the double precision engine, within the realistic range          |
+|    (-40 to 85 C, 300 to 1100 hPa): 0.01 C, 0.5 Pa for int64 and 8 Pa for    |
+|    int32 (its formula truncates more: 6.4 Pa measured.)                     |
+| 3) With P1 == 0 (zero divisor), all the engines return the raw pressure.    |
++----------------------------------------------------------------------------*/
+static bool checkCalibration() {
+   static int32_t const adcTmprts[] = {
+      400000, 470000, 519888, 560000, 620000
+   };
+   uint32_t state = 2018;
+   long long mismatches = 0;
+   double maxTmprt = 0;
+   double maxPress32 = 0;
+   double maxPress64 = 0;
+
+   for (int k=0; k < 8; ++k) {
+      unsigned char calib[24];
+      memcpy(calib, exampleCalib, sizeof calib);
+      if (k > 0) {                 // P1 must not be 0, nor T1, T2
+         for (int i=0; i < 24; ++i) calib[i] ^= nextRandom(state) & 0x0F;
+      }
+      BoschRef ref(calib);
+      Bmp280Int32Compensation int32;
+      Bmp280Int64Compensation int64;
+      int32.populate(calib);
+      int64.populate(calib);
+      for (int32_t adcT=0; adcT < 0x100000; ++adcT) {
+         int32_t tFine32;
+         int32_t tFine64;
+         int32_t t = ref.compensate_T_int32(adcT);
+         if (
+            (int32.compensateTmprt(adcT, tFine32) != t) ||
+            (int64.compensateTmprt(adcT, tFine64) != t)
+         ) {
+            ++mismatches;
+         }
+      }
+      for (unsigned int j=0; j < sizeof adcTmprts / sizeof *adcTmprts; ++j) {
+         int32_t tFine;
+         ref.compensate_T_int32(adcTmprts[j]);
+         int32.compensateTmprt(adcTmprts[j], tFine);
+         for (int32_t adcP=0; adcP < 0x100000; ++adcP) {
+            if (
+               (int32.compensatePress(adcP, tFine) !=
+                  ref.compensate_P_int32(adcP)) ||
+               (int64.compensatePress(adcP, tFine) !=
+                  ref.compensate_P_int64(adcP))
+            ) {
+               ++mismatches;
+            }
+         }
+      }
+   }
+   printf(
+      "Calibration: %lld mismatch(es) with the Bosch formulas\n", mismatches
+   );
+
+   Bmp280DoubleCompensation dbl;
+   Bmp280Int32Compensation int32;
+   Bmp280Int64Compensation int64;
+   dbl.populate(exampleCalib);
+   int32.populate(exampleCalib);
+   int64.populate(exampleCalib);
+   for (int32_t adcT=0; adcT < 0x100000; adcT += 61) {
+      for (int32_t adcP=0; adcP < 0x100000; adcP += 59) {
+         double p;
+         double t;
+         double p32;
+         double t32;
+         double p64;
+         double t64;
+         dbl.compensate(adcP, adcT, p, t);
+         if ((t < -40) || (t > 85) || (p < 30000) || (p > 110000)) continue;
+         int32.compensate(adcP, adcT, p32, t32);
+         int64.compensate(adcP, adcT, p64, t64);
+         if (fabs(t32 - t) > maxTmprt) maxTmprt = fabs(t32 - t);
+         if (fabs(p32 - p) > maxPress32) maxPress32 = fabs(p32 - p);
+         if (fabs(p64 - p) > maxPress64) maxPress64 = fabs(p64 - p);
+      }
+   }
+   printf(
+      "Calibration: max differences with the double precision engine: "
+      "%.4f C, %.3f Pa (int32), %.3f Pa (int64)\n",
+      maxTmprt, maxPress32, maxPress64
+   );
+
+   // zero divisor (P1 == 0): all the engines return the raw pressure
+   unsigned char calib[24];
+   memcpy(calib, exampleCalib, sizeof calib);
+   calib[6] = calib[7] = 0;
+   dbl.populate(calib);
+   int32.populate(calib);
+   int64.populate(calib);
+   double p;
+   double p32;
+   double p64;
+   double t;
+   dbl.compensate(415148, 519888, p, t);
+   int32.compensate(415148, 519888, p32, t);
+   int64.compensate(415148, 519888, p64, t);
+   bool isZeroDivOk = (p == 415148) && (p32 == 415148) && (p64 == 415148);
+   printf(
+      "Calibration: zero divisor gives %.0f, %.0f (int32), %.0f (int64)\n",
+      p, p32, p64
+   );
+   return (
+      (mismatches == 0) && isZeroDivOk && (maxTmprt <= 0.01) &&
+      (maxPress32 <= 8.0) && (maxPress64 <= 0.5)
+   );
+}
+
+/*-----------------------------------------------------------------checkBatch-+
+| The batch compensation (vector code, if built with -mavx2 or for aarch64)   |
+| must give exactly the results of the one sample compensation.  1003         |
+| samples: the vector loop, and a tail for the scalar one.                    |
++----------------------------------------------------------------------------*/
+template <class Engine> static int countBatchMismatches(
+   int32_t const * adcPress,
+   int32_t const * adcTmprt,
+   int n
+) {
+   Engine engine;
+   double * press = new double[n];
+   double * tmprt = new double[n];
+   int mismatches = 0;
+
+   engine.populate(exampleCalib);
+   engine.compensate(n, adcPress, adcTmprt, press, tmprt);
+   for (int i=0; i < n; ++i) {
+      double p;
+      double t;
+      engine.compensate(adcPress[i], adcTmprt[i], p, t);
+      if ((p != press[i]) || (t != tmprt[i])) ++mismatches;
+   }
+   delete [] press;
+   delete [] tmprt;
+   return mismatches;
+}
+
+static bool checkBatch() {
+   enum { SAMPLES = 1003 };
+   int32_t * adcPress = new int32_t[SAMPLES];
+   int32_t * adcTmprt = new int32_t[SAMPLES];
+   uint32_t state = 1003;
+   int mismatches[3];
+
+   for (int i=0; i < SAMPLES; ++i) {  // from 300 to 1100 hPa, -40 to 85 C
+      adcPress[i] = 250000 + (int32_t)(nextRandom(state) % 400000);
+      adcTmprt[i] = 400000 + (int32_t)(nextRandom(state) % 250000);
+   }
+   mismatches[0] = countBatchMismatches<Bmp280DoubleCompensation>(
+      adcPress, adcTmprt, SAMPLES
+   );
+   mismatches[1] = countBatchMismatches<Bmp280Int32Compensation>(
+      adcPress, adcTmprt, SAMPLES
+   );
+   mismatches[2] = countBatchMismatches<Bmp280Int64Compensation>(
+      adcPress, adcTmprt, SAMPLES
+   );
+   delete [] adcPress;
+   delete [] adcTmprt;
+   printf(
+      "Batch (%s): %d, %d (int32), %d (int64) mismatch(es) with one by one\n",
+#if defined __AVX2__
+      "AVX2",
+#elif defined __ARM_NEON && defined __aarch64__
+      "NEON",
+#else
+      "scalar",
+#endif
+      mismatches[0], mismatches[1], mismatches[2]
+   );
+   return (mismatches[0] == 0) && (mismatches[1] == 0) && (mismatches[2] == 0);
+}
+
+/*---------------------------------------------------------------checkCapture-+
+| With a full capture buffer, captureValues drops the sample before starting  |
+| a measure: no conversion, no bus traffic.                                   |
++----------------------------------------------------------------------------*/
+static bool checkCapture() {
+   Bmp280Emulator emulator;
+   Bmp280Device device(emulator);
+   Bmp280Capture capture(4);
+   Bmp280Emulator::Stats stats;
+   bool isOk = true;
+
+   device.setMode(Bmp280Device::VAL_MODE_FORCED);
+   for (unsigned int i=0; i < capture.getCapacity(); ++i) {
+      isOk = device.captureValues(capture) && isOk;
+   }
+   emulator.resetStats();
+   isOk = !device.captureValues(capture) && isOk;
+   emulator.getStats(stats);
+   isOk = isOk && (stats.transfers == 0) && (capture.getOverruns() == 1);
+   printf(
+      "Capture: full buffer, %lld transfer(s), %lld conversion(s), "
+      "%lu overrun(s)\n",
+      stats.transfers, stats.conversions, capture.getOverruns()
+   );
+   return isOk;
+}
+
+/*-------------------------------------------------------------checkMaxTiming-+
+| A part taking the maximum conversion time of the datasheet: every FORCED    |
+| mode read must return a fresh measure, not the previous or reset values.    |
++----------------------------------------------------------------------------*/
+static bool checkMaxTiming() {
+   enum { READS = 10 };
+   Bmp280Emulator emulator;
+   Bmp280Device device(emulator);
+   Bmp280Emulator::Stats stats;
+   double pressure;
+   double temperature;
+   int wrong = 0;
+
+   emulator.setTiming(Bmp280Emulator::TIMING_MAXIMUM);
+   emulator.setEnvironment(101325.0, 22.5);
+   device.setMode(Bmp280Device::VAL_MODE_FORCED);
+   device.setOversampPress(Bmp280Device::VAL_OVERSAMP_16X);
+   device.setOversampTmprt(Bmp280Device::VAL_OVERSAMP_2X);
+   emulator.resetStats();
+   for (int i=0; i < READS; ++i) {
+      if (
+         !device.readValues(pressure, temperature) ||
+         (fabs(pressure - 101325.0) > 1) || (fabs(temperature - 22.5) > 0.01)
+      ) {
+         ++wrong;
+      }
+   }
+   emulator.getStats(stats);
+   printf(
+      "Maximum conversion time: %d wrong read(s), %lld stale, out of %d\n",
+      wrong, stats.staleReads, READS
+   );
+   return (wrong == 0) && (stats.staleReads == 0);
+}
+
+/*--------------------------------------------------------- class RegisterLog-+
+| The emulator, logging the registers written: the (register, value) pairs    |
+| of each write, and the soft resets among them.                              |
++----------------------------------------------------------------------------*/
+class RegisterLog : public Bmp280Emulator {
+public:
+   enum { MAX_PAIRS = 32 };
+   RegisterLog() : m_pairs(0), m_resets(0) {}
+   void clear() { m_pairs = m_resets = 0; }
+   bool write(void const * buf, int len) {
+      unsigned char const * cp = (unsigned char const *)buf;
+      for (int i=0; i+1 < len; i += 2) {
+         if ((cp[i] == 0xE0) && (cp[i+1] == 0xB6)) ++m_resets;
+         if (m_pairs < MAX_PAIRS) {
+            m_regs[m_pairs] = cp[i];
+            m_values[m_pairs] = cp[i+1];
+         }
+         ++m_pairs;
+      }
+      return Bmp280Emulator::write(buf, len);
+   }
+   int getLast(unsigned char reg) const { // -1: not written
+      int value = -1;
+      for (int i=0; (i < m_pairs) && (i < MAX_PAIRS); ++i) {
+         if (m_regs[i] == reg) value = m_values[i];
+      }
+      return value;
+   }
+   int m_pairs;
+   int m_resets;
+   unsigned char m_regs[MAX_PAIRS];
+   unsigned char m_values[MAX_PAIRS];
+};
+
+/*-----------------------------------------------------------checkLeaveNormal-+
+| From NORMAL mode (x16/x2), at 9 points of the measure cycle, to FORCED mode |
+| (x1): the device must be soft reset, and the first FORCED read must return  |
+| the new environment, not the reset value or the last NORMAL mode measure.   |
++----------------------------------------------------------------------------*/
+static bool checkLeaveNormal() {
+   enum { OFFSETS = 9, STEP = 5 }; // ms after a read, within the cycle
+   int resets = 0;
+   int wrong = 0;
+
+   for (int offset=0; offset < OFFSETS * STEP; offset += STEP) {
+      RegisterLog emulator;
+      Bmp280Device device(emulator);
+      double pressure;
+      double temperature;
+
+      emulator.setEnvironment(95000.0, 15.0);
+      device.setMode(Bmp280Device::VAL_MODE_NORMAL);
+      device.setStandbyTime(Bmp280Device::VAL_STANDBY_0_5_MS);
+      device.setOversampPress(Bmp280Device::VAL_OVERSAMP_16X);
+      device.setOversampTmprt(Bmp280Device::VAL_OVERSAMP_2X);
+      for (int i=0; i < 3; ++i) {
+         device.readValues(pressure, temperature);
+         emulator.sleep(device.getOutDataPeriod());
+      }
+      emulator.sleep(offset);
+      emulator.setEnvironment(101325.0, 22.5);
+      emulator.clear();
+      device.setMode(Bmp280Device::VAL_MODE_FORCED);
+      device.setOversampPress(Bmp280Device::VAL_OVERSAMP_1X);
+      device.setOversampTmprt(Bmp280Device::VAL_OVERSAMP_1X);
+      if (
+         !device.readValues(pressure, temperature) ||
+         (fabs(pressure - 101325.0) > 5) || (fabs(temperature - 22.5) > 0.05)
+      ) {
+         ++wrong;
+      }
+      resets += emulator.m_resets;
+   }
+   printf(
+      "NORMAL to FORCED: %d soft reset(s), %d wrong read(s), out of %d\n",
+      resets, wrong, OFFSETS
+   );
+   return (resets == OFFSETS) && (wrong == 0);
+}
+
+/*---------------------------------------------------------checkMinimalWrites-+
+| One option changed: only the register holding it is written, in FORCED or   |
+| NORMAL mode, without a soft reset.  An option set back to its value before  |
+| the options were written: nothing is written.                               |
++----------------------------------------------------------------------------*/
+static bool checkMinimalWrites() {
+   RegisterLog emulator;
+   Bmp280Device device(emulator);
+   bool isOk = true;
+
+   device.setMode(Bmp280Device::VAL_MODE_FORCED);
+   device.setOversampPress(Bmp280Device::VAL_OVERSAMP_16X);
+   device.setOversampTmprt(Bmp280Device::VAL_OVERSAMP_2X);
+   device.getOutDataPeriod();
+
+   emulator.clear();               // FORCED, oversampling
+   device.setOversampPress(Bmp280Device::VAL_OVERSAMP_4X);
+   device.getOutDataPeriod();
+   isOk = isOk && (emulator.m_pairs == 1) && (emulator.m_regs[0] == 0xF4);
+
+   emulator.clear();               // FORCED, filter
+   device.setFilter(Bmp280Device::VAL_FILTER_COEFF_2);
+   device.getOutDataPeriod();
+   isOk = isOk && (emulator.m_pairs == 1) && (emulator.m_regs[0] == 0xF5);
+
+   device.setMode(Bmp280Device::VAL_MODE_NORMAL);
+   device.getOutDataPeriod();
+   emulator.clear();               // NORMAL, oversampling
+   device.setOversampTmprt(Bmp280Device::VAL_OVERSAMP_1X);
+   device.getOutDataPeriod();
+   isOk = isOk && (emulator.m_pairs == 1) && (emulator.m_regs[0] == 0xF4) &&
+      ((emulator.m_values[0] & 0x03) == 0x03);
+
+   emulator.clear();               // unchanged
+   device.setOversampPress(Bmp280Device::VAL_OVERSAMP_8X);
+   device.setOversampPress(Bmp280Device::VAL_OVERSAMP_4X);
+   device.getOutDataPeriod();
+   isOk = isOk && (emulator.m_pairs == 0) && (emulator.m_resets == 0);
+   printf("Minimal writes: %s\n", isOk? "ok" : "FAILED");
+   return isOk;
+}
+
+/*---------------------------------------------------------------isSameConfig-+
+| setConfig<Config> and the run time setters, each on a device just out of    |
+| reset: the same CTRL_MEAS and CONFIG values must be written, and the same   |
+| output data period found.                                                   |
++----------------------------------------------------------------------------*/
+template <class Config> static bool isSameConfig() {
+   RegisterLog byConfig;
+   RegisterLog bySetters;
+   Bmp280Device deviceByConfig(byConfig);
+   Bmp280Device deviceBySetters(bySetters);
+   bool isOk;
+
+   deviceBySetters.setMode((Bmp280Device::VAL_MODE)Config::MODE);
+   deviceBySetters.setFilter((Bmp280Device::VAL_FILTER)Config::FILTER);
+   deviceBySetters.setOversampPress(
+      (Bmp280Device::VAL_OVERSAMP)Config::OVERSAMP_PRESS
+   );
+   deviceBySetters.setOversampTmprt(
+      (Bmp280Device::VAL_OVERSAMP)Config::OVERSAMP_TMPRT
+   );
+   deviceBySetters.setStandbyTime(
+      (Bmp280Device::VAL_STANDBY)Config::STANDBY_TIME
+   );
+   deviceBySetters.setSpiWiring(
+      (Bmp280Device::VAL_SPI_WIRING)Config::SPI_WIRING
+   );
+   isOk = deviceByConfig.setConfig<Config>() && (
+      deviceByConfig.getOutDataPeriod() == deviceBySetters.getOutDataPeriod()
+   ) && (
+      byConfig.getLast(0xF4) == bySetters.getLast(0xF4)
+   ) && (
+      byConfig.getLast(0xF5) == bySetters.getLast(0xF5)
+   );
+   printf(
+      "Config: CTRL_MEAS 0x%02X, CONFIG 0x%02X, period %d ms: %s\n",
+      Config::CTRL_MEAS, Config::CONFIG, deviceByConfig.getOutDataPeriod(),
+      isOk? "same as the setters" : "DIFFERENT from the setters"
+   );
+   return isOk;
+}
+
+/*----------------------------------------------------------------checkConfig-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+static bool checkConfig() {
+   typedef Bmp280Config<
+      Bmp280Device::VAL_MODE_NORMAL,
+      Bmp280Device::VAL_FILTER_COEFF_2,
+      Bmp280Device::VAL_OVERSAMP_16X,
+      Bmp280Device::VAL_OVERSAMP_4X,
+      Bmp280Device::VAL_STANDBY_1000_MS
+   > Normal;
+   typedef Bmp280Config<
+      Bmp280Device::VAL_MODE_NORMAL,
+      Bmp280Device::VAL_FILTER_COEFF_16,
+      Bmp280Device::VAL_OVERSAMP_8X,
+      Bmp280Device::VAL_OVERSAMP_2X,
+      Bmp280Device::VAL_STANDBY_0_5_MS,
+      Bmp280Device::VAL_SPI_WIRING_3
+   > NormalSpi3;
+   typedef Bmp280Config<
+      Bmp280Device::VAL_MODE_FORCED,
+      Bmp280Device::VAL_FILTER_OFF,
+      Bmp280Device::VAL_OVERSAMP_1X,
+      Bmp280Device::VAL_OVERSAMP_1X,
+      Bmp280Device::VAL_STANDBY_0_5_MS
+   > Forced;
+   typedef Bmp280Config<
+      Bmp280Device::VAL_MODE_FORCED,
+      Bmp280Device::VAL_FILTER_COEFF_4,
+      Bmp280Device::VAL_OVERSAMP_NONE,
+      Bmp280Device::VAL_OVERSAMP_16X,
+      Bmp280Device::VAL_STANDBY_125_MS
+   > ForcedNoPress;
+   bool isOk = true;
+
+   isOk = isSameConfig<Normal>() && isOk;
+   isOk = isSameConfig<NormalSpi3>() && isOk;
+   isOk = isSameConfig<Forced>() && isOk;
+   isOk = isSameConfig<ForcedNoPress>() && isOk;
+   return isOk;
+}
+
+/*---------------------------------------------------------------checkPolling-+
+| FORCED mode, on a slow bus (10 kHz) in real time: the conversion time must  |
+| count the bus time, not only the polling intervals.                         |
+| NORMAL mode: readValuesWhenReady fails at once, without polling.            |
++----------------------------------------------------------------------------*/
+static bool checkPolling() {
+   enum { READS = 3, MEASURE_TIME = 37 };  // typical, x16/x2: 37.5 ms
+   bool isOk = true;
+   double pressure;
+   double temperature;
+   {
+      RealTimeBmp280 emulator(10000);
+      Bmp280Device device(emulator);
+      Bmp280Emulator::Stats stats;
+
+      emulator.setEnvironment(101325.0, 22.5);
+      device.setMode(Bmp280Device::VAL_MODE_FORCED);
+      device.setOversampPress(Bmp280Device::VAL_OVERSAMP_16X);
+      device.setOversampTmprt(Bmp280Device::VAL_OVERSAMP_2X);
+      emulator.resetStats();
+      for (int i=0; i < READS; ++i) {
+         isOk = isOk &&
+            device.readValuesWhenReady(pressure, temperature) &&
+            (fabs(pressure - 101325.0) < 1) &&
+            (device.getConversionTime() >= MEASURE_TIME) &&
+            (device.getConversionTime() < 2 * MEASURE_TIME);
+      }
+      emulator.getStats(stats);
+      isOk = isOk && (stats.staleReads == 0);
+      printf(
+         "Polling: FORCED, conversion time %d ms (at least %d), %lld stale\n",
+         device.getConversionTime(), MEASURE_TIME, stats.staleReads
+      );
+   }
+   {
+      Bmp280Emulator emulator;
+      Bmp280Device device(emulator);
+      bool isRead;
+
+      device.setMode(Bmp280Device::VAL_MODE_NORMAL);
+      device.setStandbyTime(Bmp280Device::VAL_STANDBY_0_5_MS);
+      device.setOversampPress(Bmp280Device::VAL_OVERSAMP_16X);
+      device.setOversampTmprt(Bmp280Device::VAL_OVERSAMP_2X);
+      device.readValues(pressure, temperature);    // sets the options
+      long long start = emulator.getTime();
+      isRead = device.readValuesWhenReady(pressure, temperature);
+      long long elapsed = emulator.getTime() - start;
+      printf(
+         "Polling: NORMAL, %s after %.2f ms\n",
+         isRead? "READ" : "refused", elapsed / 1e6
+      );
+      isOk = isOk && !isRead && (elapsed < 1000000);
+   }
+   return isOk;
+}
+
+/*--------------------------------------------------------- class CountingI2c-+
+| The i2c-dev interface, with its ioctl served by the emulator.               |
+| Counts the system calls, and the messages they carry: a driver doing a      |
+| write() then a read() per register read makes one system call per message.  |
++----------------------------------------------------------------------------*/
+class CountingI2c : public Bmp280I2cInterface {
+public:
+   CountingI2c(Bmp280Emulator & emulator);
+   void sleep(int ms);
+   long long m_syscalls;
+   long long m_messages;
+protected:
+   int control(unsigned long request, void * arg);
+private:
+   Bmp280Emulator & m_emulator;
+};
+
+CountingI2c::CountingI2c(Bmp280Emulator & emulator) :
+Bmp280I2cInterface(-1, 0x76),
+m_syscalls(0),
+m_messages(0),
+m_emulator(emulator)
+{}
+
+void CountingI2c::sleep(int ms) {
+   m_emulator.sleep(ms);
+}
+
+int CountingI2c::control(unsigned long request, void * arg) {
+   struct i2c_rdwr_ioctl_data * data = (struct i2c_rdwr_ioctl_data *)arg;
+   struct i2c_msg * msgs = data->msgs;
+   bool isOk;
+
+   ++m_syscalls;
+   m_messages += data->nmsgs;
+   if (request != I2C_RDWR) {
+      isOk = false;
+   }else if ((data->nmsgs == 1) && !(msgs[0].flags & I2C_M_RD)) {
+      isOk = m_emulator.write(msgs[0].buf, msgs[0].len);
+   }else if (
+      (data->nmsgs == 2) && (msgs[0].len == 1) && (msgs[1].flags & I2C_M_RD)
+   ) {
+      isOk = m_emulator.readReg(msgs[0].buf[0], msgs[1].buf, msgs[1].len);
+   }else {
+      isOk = false;
+   }
+   return isOk? (int)data->nmsgs : -1;
+}
+
+/*--------------------------------------------------------------countSyscalls-+
+| Start up, then read 100 samples in FORCED mode, through CountingI2c.        |
++----------------------------------------------------------------------------*/
+static bool countSyscalls(
+   long long & syscalls,
+   long long & messages,
+   long long & transfers
+) {
+   Bmp280Emulator emulator;
+   CountingI2c interface(emulator);
+   Bmp280Device device(interface);
+   Bmp280Emulator::Stats stats;
+   double pressure;
+   double temperature;
+   bool isOk = device.isOperational();
+
+   device.setMode(Bmp280Device::VAL_MODE_FORCED);
+   for (int i=0; i < 100; ++i) {
+      isOk = device.readValues(pressure, temperature) && isOk;
+   }
+   emulator.getStats(stats);
+   syscalls = interface.m_syscalls;
+   messages = interface.m_messages;
+   transfers = stats.transfers;
+   return isOk;
+}
+
+/*-------------------------------------------------------------------checkI2c-+
+| One system call per register access                                         |
++----------------------------------------------------------------------------*/
+static bool checkI2c() {
+   long long syscalls;
+   long long messages;
+   long long transfers;
+   bool isOk = countSyscalls(syscalls, messages, transfers);
+
+   isOk = isOk && (syscalls == transfers);
+   printf(
+      "I2C: %lld ioctl(s) for %lld register access(es)\n", syscalls, transfers
+   );
+   return isOk;
+}
+
+/*--------------------------------------------------------- class LoopbackSpi-+
+| The spidev interface, with its ioctls served by the emulator in SPI mode.   |
+| The wiring of the device (spi3w_en, in its CONFIG register) and the mode of |
+| the bus must agree: a full-duplex read in 3-wire mode, or a half-duplex one |
+| in 4-wire mode, fails.                                                      |
++----------------------------------------------------------------------------*/
+class LoopbackSpi : public Bmp280SpiInterface {
+public:
+   LoopbackSpi(
+      Bmp280Emulator & emulator,
+      Bmp280Device::VAL_SPI_WIRING wiring,
+      bool isBroken = false        // SPI_IOC_WR_MODE fails
+   );
+   void sleep(int ms);
+protected:
+   int control(unsigned long request, void * arg);
+private:
+   Bmp280Emulator & m_emulator;
+   bool m_isBroken;
+   bool m_is3WireBus;
+   bool is3WireDevice();
+};
+
+LoopbackSpi::LoopbackSpi(
+   Bmp280Emulator & emulator,
+   Bmp280Device::VAL_SPI_WIRING wiring,
+   bool isBroken
+) :
+Bmp280SpiInterface(-1, 10000000, wiring),
+m_emulator(emulator),
+m_isBroken(isBroken),
+m_is3WireBus(false)
+{
+   init(wiring);
+}
+
+void LoopbackSpi::sleep(int ms) {
+   m_emulator.sleep(ms);
+}
+
+bool LoopbackSpi::is3WireDevice() {
+   unsigned char config;
+   return m_emulator.readReg(0xF5, &config, 1) && (config & 0x01);
+}
+
+int LoopbackSpi::control(unsigned long request, void * arg) {
+   struct spi_ioc_transfer * xfer = (struct spi_ioc_transfer *)arg;
+   unsigned char const * tx = (unsigned char const *)xfer[0].tx_buf;
+
+   if ((request == SPI_IOC_WR_BITS_PER_WORD) ||
+       (request == SPI_IOC_WR_MAX_SPEED_HZ)) {
+      return 0;
+   }else if (request == SPI_IOC_WR_MODE) {
+      m_is3WireBus = (*(unsigned char *)arg & SPI_3WIRE) != 0;
+      return m_isBroken? -1 : 0;
+   }else if ((request == SPI_IOC_MESSAGE(1)) && !xfer[0].rx_buf) {
+      return m_emulator.write(tx, xfer[0].len)? (int)xfer[0].len : -1;
+   }else if (
+      (request == SPI_IOC_MESSAGE(1)) &&  // full-duplex
+      !m_is3WireBus && !is3WireDevice() &&
+      m_emulator.readReg(
+         tx[0], (unsigned char *)xfer[0].rx_buf + 1, xfer[0].len - 1
+      )
+   ) {
+      return xfer[0].len;
+   }else if (
+      (request == SPI_IOC_MESSAGE(2)) &&  // half-duplex
+      m_is3WireBus && is3WireDevice() && (xfer[0].len == 1) &&
+      m_emulator.readReg(tx[0], (void *)xfer[1].rx_buf, xfer[1].len)
+   ) {
+      return 1 + xfer[1].len;
+   }else {
+      return -1;
+   }
+}
+
+/*-------------------------------------------------------------------checkSpi-+
+| isOk() reports a failed init, and the driver reads the right values, in     |
+| 4-wire and in 3-wire mode, through the emulator.                            |
++----------------------------------------------------------------------------*/
+static bool checkSpi() {
+   static Bmp280Device::VAL_SPI_WIRING const wirings[] = {
+      Bmp280Device::VAL_SPI_WIRING_4, Bmp280Device::VAL_SPI_WIRING_3
+   };
+   bool isOk = true;
+   {
+      Bmp280Emulator emulator(true);
+      LoopbackSpi broken(emulator, Bmp280Device::VAL_SPI_WIRING_4, true);
+      isOk = !broken.isOk() && isOk;
+   }
+   for (int i=0; i < 2; ++i) {
+      Bmp280Emulator emulator(true);
+      LoopbackSpi interface(emulator, Bmp280Device::VAL_SPI_WIRING_4);
+      Bmp280Device device(interface);
+      Bmp280Emulator::Stats stats;
+      double pressure = 0;
+      double temperature = 0;
+      int count = 0;
+
+      emulator.setEnvironment(98765.4, 21.5);
+      device.setSpiWiring(wirings[i]);
+      device.setMode(Bmp280Device::VAL_MODE_FORCED);
+      device.setOversampPress(Bmp280Device::VAL_OVERSAMP_16X);
+      device.setOversampTmprt(Bmp280Device::VAL_OVERSAMP_2X);
+      for (int j=0; j < 10; ++j) {
+         if (
+            device.readValues(pressure, temperature) &&
+            (fabs(pressure - 98765.4) < 1) && (fabs(temperature - 21.5) < 0.01)
+         ) {
+            ++count;
+         }
+      }
+      emulator.getStats(stats);
+      printf(
+         "SPI %d-wire: %d/10 good read(s), %lld rejected transfer(s), "
+         "T=%.2f C, P=%.2f Pa\n",
+         i? 3 : 4, count, stats.errors, temperature, pressure
+      );
+      isOk = interface.isOk() && (count == 10) && (stats.errors == 0) && isOk;
+   }
+   return isOk;
+}
+
+/*----------------------------------------------------------------startDevice-+
+| Start up a device on 'emulator', with a calibration cache.                  |
+| Returns the virtual time it took (in us), and its first reading.            |
++----------------------------------------------------------------------------*/
+static double startDevice(
+   Bmp280Emulator & emulator,
+   char const * cachePath,
+   double & pressure,
+   double & temperature,
+   long long & bytes
+) {
+   Bmp280Emulator::Stats stats;
+   long long start = emulator.getTime();
+
+   emulator.resetStats();
+   Bmp280Device device(emulator, cachePath, "/dev/i2c-1", 0x76);
+   double elapsed = (emulator.getTime() - start) / 1e3;
+   emulator.getStats(stats);
+   bytes = stats.bytes;
+   device.setMode(Bmp280Device::VAL_MODE_FORCED);
+   device.setOversampPress(Bmp280Device::VAL_OVERSAMP_16X);
+   device.setOversampTmprt(Bmp280Device::VAL_OVERSAMP_2X);
+   if (!device.readValues(pressure, temperature)) pressure = temperature = 0;
+   return elapsed;
+}
+
+/*-----------------------------------------------------------------checkCache-+
+| A cache written for a part must not be used for another one, on the same    |
+| bus and at the same address: the values read must stay right.               |
++----------------------------------------------------------------------------*/
+static bool checkCache() {
+   char path[] = "/tmp/bmp280-cache-XXXXXX";
+   int fd = mkstemp(path);
+   unsigned char otherCalib[24];
+   double pressure;
+   double temperature;
+   long long bytes;
+   bool isOk = true;
+
+   if (fd < 0) return false;
+   close(fd);
+   unlink(path);
+   memcpy(otherCalib, exampleCalib, sizeof otherCalib);
+   otherCalib[0] ^= 0x10;          // dig_T1
+   otherCalib[6] ^= 0x10;          // dig_P1
+   {
+      Bmp280Emulator emulator;     // writes the cache
+      startDevice(emulator, path, pressure, temperature, bytes);
+   }
+   for (int i=0; i < 2; ++i) {     // the other part, then the cache hit
+      Bmp280Emulator emulator(false, 0, otherCalib);
+      emulator.setEnvironment(98765.4, 21.5);
+      startDevice(emulator, path, pressure, temperature, bytes);
+      printf(
+         "Cache: %s, T=%.2f C, P=%.2f Pa\n",
+         i? "same part" : "swapped part", temperature, pressure
+      );
+      isOk = isOk &&
+         (fabs(pressure - 98765.4) < 1) && (fabs(temperature - 21.5) < 0.01);
+   }
+   unlink(path);
+   return isOk;
+}
+
+/*-----------------------------------------------------------------benchCache-+
+| Start up time, in virtual time (bus and sleeps) and bytes on the I2C bus    |
++----------------------------------------------------------------------------*/
+static void benchCache() {
+   char path[] = "/tmp/bmp280-cache-XXXXXX";
+   int fd = mkstemp(path);
+   double pressure;
+   double temperature;
+   long long bytes;
+
+   if (fd < 0) return;
+   close(fd);
+   unlink(path);
+   printf("Start up (I2C at 400 kHz):\n");
+   for (int i=0; i < 3; ++i) {
+      Bmp280Emulator emulator;
+      double elapsed = startDevice(
+         emulator, i? path : 0, pressure, temperature, bytes
+      );
+      printf(
+         "   %-22s %8.1f us, %3lld bytes\n",
+         (i == 0)? "no cache" : (i == 1)? "cache miss (writes it)" : "cache hit",
+         elapsed, bytes
+      );
+   }
+   unlink(path);
+}
+
+/*-----------------------------------------------------------------benchModes-+
+| Sweep the driver modes on the emulator (typical conversion times, I2C at    |
+| 400 kHz, pressure x16, temperature x2): for a given number of calls, the    |
+| fresh samples per second of virtual time, the bus time per fresh sample,    |
+| the stale reads (the same measure read again) and the conversions made.     |
++----------------------------------------------------------------------------*/
+static void benchModes() {
+   enum DRIVE {
+      DRIVE_READ,                  // readValues
+      DRIVE_POLL,                  // readValuesWhenReady
+      DRIVE_CAPTURE                // captureValues, then drainValues
+   };
+   enum { CALLS = 200, PERIOD = -1 };  // PERIOD: the output data period
+   static struct {
+      char const * name;
+      Bmp280Device::VAL_MODE mode;
+      DRIVE drive;
+      int sleepMs;                 // between the calls
+   } const sweep[] = {
+      {
+         "FORCED, sleep measure time",
+         Bmp280Device::VAL_MODE_FORCED, DRIVE_READ, 0
+      },{
+         "FORCED, poll STATUS",
+         Bmp280Device::VAL_MODE_FORCED, DRIVE_POLL, 0
+      },{
+         "FORCED, capture",
+         Bmp280Device::VAL_MODE_FORCED, DRIVE_CAPTURE, 0
+      },{
+         "NORMAL, every period",
+         Bmp280Device::VAL_MODE_NORMAL, DRIVE_READ, PERIOD
+      },{
+         "NORMAL, every 10 ms",
+         Bmp280Device::VAL_MODE_NORMAL, DRIVE_READ, 10
+      },{
+         "NORMAL, capture every period",
+         Bmp280Device::VAL_MODE_NORMAL, DRIVE_CAPTURE, PERIOD
+      }
+   };
+   double pressures[CALLS];
+   double temperatures[CALLS];
+
+   printf(
+      "Driver modes, %d calls (I2C 400 kHz, pressure x16, temperature x2):\n"
+      "   %-28s %9s %14s %6s %12s\n",
+      CALLS, "", "samples/s", "bus us/sample", "stale", "conversions"
+   );
+   for (unsigned int i=0; i < sizeof sweep / sizeof sweep[0]; ++i) {
+      Bmp280Emulator emulator;
+      Bmp280Emulator::Stats stats;
+      Bmp280Capture capture(CALLS);
+      Bmp280Device device(emulator);
+      int sleepMs = sweep[i].sleepMs;
+      long long start;
+      long long fresh;
+      double seconds;
+
+      emulator.setTiming(Bmp280Emulator::TIMING_TYPICAL);
+      device.setOversampPress(Bmp280Device::VAL_OVERSAMP_16X);
+      device.setOversampTmprt(Bmp280Device::VAL_OVERSAMP_2X);
+      device.setStandbyTime(Bmp280Device::VAL_STANDBY_0_5_MS);
+      device.setMode(sweep[i].mode);
+      if (sleepMs == PERIOD) sleepMs = device.getOutDataPeriod();
+      emulator.resetStats();
+      start = emulator.getTime();
+      for (int call=0; call < CALLS; ++call) {
+         switch (sweep[i].drive) {
+         case DRIVE_READ:
+            device.readValues(pressures[call], temperatures[call]);
+            break;
+         case DRIVE_POLL:
+            device.readValuesWhenReady(pressures[call], temperatures[call]);
+            break;
+         case DRIVE_CAPTURE:
+            device.captureValues(capture);
+            break;
+         }
+         if (sleepMs > 0) emulator.sleep(sleepMs);
+      }
+      device.drainValues(capture, pressures, temperatures, 0, CALLS);
+      emulator.getStats(stats);
+      seconds = (emulator.getTime() - start) / 1e9;
+      fresh = stats.reads - stats.staleReads;
+      printf(
+         "   %-28s %9.1f %14.1f %6lld %12lld\n",
+         sweep[i].name,
+         (seconds > 0)? fresh / seconds : 0.0,
+         fresh? (stats.busTime / 1e3) / fresh : 0.0,
+         stats.staleReads,
+         stats.conversions
+      );
+   }
+}
+
+/*-----------------------------------------------------------benchCalibration-+
+| Time per sample of each engine: one at a time, and in batches of 64.        |
+| Cycles are TSC ticks (x86 only.)                                            |
++----------------------------------------------------------------------------*/
+template <class Engine> static void benchEngine(
+   char const * name,
+   int32_t const * adcPress,
+   int32_t const * adcTmprt,
+   int n
+) {
+   enum { BATCH = 64, ROUNDS = 200 };
+   Engine engine;
+   double * press = new double[n];
+   double * tmprt = new double[n];
+   double sum = 0;
+
+   engine.populate(exampleCalib);
+   for (int isBatch=0; isBatch < 2; ++isBatch) {
+      long long start = getNanos();
+#ifdef HAS_TSC
+      unsigned long long startTsc = __rdtsc();
+#endif
+      for (int round=0; round < ROUNDS; ++round) {
+         if (isBatch) {
+            for (int i=0; i < n; i += BATCH) {
+               engine.compensate(
+                  BATCH, adcPress+i, adcTmprt+i, press+i, tmprt+i
+               );
+            }
+         }else {
+            for (int i=0; i < n; ++i) {
+               engine.compensate(adcPress[i], adcTmprt[i], press[i], tmprt[i]);
+            }
+         }
+         sum += press[round % n] + tmprt[round % n];
+      }
+      long long samples = (long long)ROUNDS * n;
+      printf(
+         "   %-6s %-7s %7.2f ns/sample",
+         name, isBatch? "batch" : "single",
+         (double)(getNanos() - start) / samples
+      );
+#ifdef HAS_TSC
+      printf(", %7.2f cycles/sample", (double)(__rdtsc()-startTsc) / samples);
+#endif
+      printf("\n");
+   }
+   if (sum == 0) printf("(never printed: keeps the results alive)\n");
+   delete [] press;
+   delete [] tmprt;
+}
+
+static void benchCalibration() {
+   enum { SAMPLES = 4096 };        // a multiple of 64
+   int32_t * adcPress = new int32_t[SAMPLES];
+   int32_t * adcTmprt = new int32_t[SAMPLES];
+   uint32_t state = 2018;
+
+   for (int i=0; i < SAMPLES; ++i) {  // around 1000 hPa and 25 C
+      adcPress[i] = 415148 + (int32_t)(nextRandom(state) % 20000) - 10000;
+      adcTmprt[i] = 519888 + (int32_t)(nextRandom(state) % 20000) - 10000;
+   }
+   printf("Compensation, per sample:\n");
+   benchEngine<Bmp280DoubleCompensation>("double", adcPress, adcTmprt, SAMPLES);
+   benchEngine<Bmp280Int32Compensation>("int32", adcPress, adcTmprt, SAMPLES);
+   benchEngine<Bmp280Int64Compensation>("int64", adcPress, adcTmprt, SAMPLES);
+   delete [] adcPress;
+   delete [] adcTmprt;
+}
+
+/*----------------------------------------------------------------------check-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+static bool check() {
+   bool isOk = true;
+   isOk = checkCalibration() && isOk;
+   isOk = checkBatch() && isOk;
+   isOk = checkCapture() && isOk;
+   isOk = checkMaxTiming() && isOk;
+   isOk = checkPolling() && isOk;
+   isOk = checkLeaveNormal() && isOk;
+   isOk = checkMinimalWrites() && isOk;
+   isOk = checkConfig() && isOk;
+   isOk = checkI2c() && isOk;
+   isOk = checkSpi() && isOk;
+   isOk = checkCache() && isOk;
+   printf("%s\n", isOk? "All checks passed" : "CHECK FAILED");
+   return isOk;
+}
+
+/*----------------------------------------------------------------------bench-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+static void bench() {
+   long long syscalls;
+   long long messages;
+   long long transfers;
+
+   benchCalibration();
+   benchCache();
+   benchModes();
+   countSyscalls(syscalls, messages, transfers);
+   printf(
+      "I2C system calls, start up and 100 FORCED mode reads:\n"
+      "   combined transfers (ioctl I2C_RDWR): %lld\n"
+      "   write() then read(), per message:    %lld\n",
+      syscalls, messages
+   );
+}
 /*===========================================================================*/
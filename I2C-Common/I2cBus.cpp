@@ -0,0 +1,187 @@
+/*
+* Author:  agent
+* Written: 10/16/2026
+*
+* I2cBus - One Linux i2c-dev bus, shared by several device drivers
+*/
+#include <unistd.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/ioctl.h>
+#include <linux/i2c-dev.h>
+#include "I2cBus.h"
+
+/*-------------------------------------------------------------I2cBus::I2cBus-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+I2cBus::I2cBus(char const * path) :
+m_fd(::open(path, O_RDWR)),
+m_mutex(PTHREAD_MUTEX_INITIALIZER),
+m_cond(PTHREAD_COND_INITIALIZER),
+m_waiters(0),
+m_nextTicket(0),
+m_isBusy(false),
+m_wirePriority(PRIORITY_NORMAL)
+{
+   if (m_fd < 0) {
+      printf("Can't open %s\n", path);
+   }
+}
+
+/*PROTECTED----------------------------------------------------I2cBus::I2cBus-+
+| A stand-in, with no device file, passes -1 and realizes control()           |
++----------------------------------------------------------------------------*/
+I2cBus::I2cBus(int fd) :
+m_fd(fd),
+m_mutex(PTHREAD_MUTEX_INITIALIZER),
+m_cond(PTHREAD_COND_INITIALIZER),
+m_waiters(0),
+m_nextTicket(0),
+m_isBusy(false),
+m_wirePriority(PRIORITY_NORMAL)
+{}
+
+/*------------------------------------------------------------I2cBus::~I2cBus-+
+| All ports must be gone, or at least idle.                                   |
++----------------------------------------------------------------------------*/
+I2cBus::~I2cBus() {
+   if (m_fd >= 0) { ::close(m_fd); m_fd = -1; }
+   pthread_cond_destroy(&m_cond);
+   pthread_mutex_destroy(&m_mutex);
+}
+
+/*-----------------------------------------------------------I2cBus::transfer-+
+| One ioctl(I2C_RDWR): a single STOP, at the end of the transaction.          |
+| If 'port' is given, it is charged of the wait and occupancy times.          |
++----------------------------------------------------------------------------*/
+bool I2cBus::transfer(
+   struct i2c_msg * msgs,
+   int count,
+   PRIORITY priority,
+   Port * port
+) {
+   struct i2c_rdwr_ioctl_data data;
+   Waiter waiter;
+   long long const start = now();
+   long long granted;
+   bool isOk;
+
+   data.msgs = msgs;
+   data.nmsgs = count;
+   waiter.priority = priority;
+   acquire(waiter);
+   granted = now();
+   isOk = (control(I2C_RDWR, &data) == count);
+   release();
+   if (port) {
+      long long end = now();
+      port->m_transactions.fetch_add(1, std::memory_order_relaxed);
+      if (!isOk) port->m_failures.fetch_add(1, std::memory_order_relaxed);
+      port->m_waitMicros.fetch_add(
+         granted - start, std::memory_order_relaxed
+      );
+      port->m_occupancyMicros.fetch_add(
+         end - granted, std::memory_order_relaxed
+      );
+   }
+   return isOk;
+}
+
+/*PROTECTED---------------------------------------------------I2cBus::control-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+int I2cBus::control(unsigned long request, void * arg) {
+   if (m_fd < 0) return -1;
+   return ::ioctl(m_fd, request, arg);
+}
+
+/*---------------------------------------------------------I2cBus::getWaiting-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+int I2cBus::getWaiting() {
+   int count = 0;
+   pthread_mutex_lock(&m_mutex);
+   for (Waiter * p = m_waiters; p; p = p->next) ++count;
+   pthread_mutex_unlock(&m_mutex);
+   return count;
+}
+
+/*------------------------------------------------------------I2cBus::acquire-+
+| Queue the waiter (by priority, then ticket: FIFO within a priority) and     |
+| wait until the bus is free, and the waiter heads the queue.                 |
++----------------------------------------------------------------------------*/
+void I2cBus::acquire(Waiter & waiter) {
+   pthread_mutex_lock(&m_mutex);
+   waiter.ticket = m_nextTicket++;
+   Waiter ** pp = &m_waiters;
+   while (*pp && ((*pp)->priority <= waiter.priority)) {
+      pp = &(*pp)->next;
+   }
+   waiter.next = *pp;
+   *pp = &waiter;
+   while (m_isBusy || (m_waiters != &waiter)) {
+      pthread_cond_wait(&m_cond, &m_mutex);
+   }
+   m_waiters = waiter.next;
+   m_isBusy = true;
+   m_wirePriority = waiter.priority;
+   pthread_mutex_unlock(&m_mutex);
+}
+
+/*------------------------------------------------------------I2cBus::release-+
+| Wake all the waiters: only the new head of the queue goes on.               |
++----------------------------------------------------------------------------*/
+void I2cBus::release() {
+   pthread_mutex_lock(&m_mutex);
+   m_isBusy = false;
+   if (m_waiters) pthread_cond_broadcast(&m_cond);
+   pthread_mutex_unlock(&m_mutex);
+}
+
+/*STATIC----------------------------------------------------------I2cBus::now-+
+| CLOCK_MONOTONIC, in microseconds                                            |
++----------------------------------------------------------------------------*/
+long long I2cBus::now() {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (ts.tv_sec * 1000000LL) + (ts.tv_nsec / 1000);
+}
+
+/*---------------------------------------------------------I2cBus::Port::Port-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+I2cBus::Port::Port(I2cBus & bus, int i2cAddr, PRIORITY priority) :
+m_bus(bus),
+m_addr((unsigned short)i2cAddr),
+m_priority(priority),
+m_transactions(0),
+m_failures(0),
+m_occupancyMicros(0),
+m_waitMicros(0)
+{}
+
+/*---------------------------------------------------------I2cBus::Port::send-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+bool I2cBus::Port::send(void const * buf, int len, PRIORITY priority) {
+   struct i2c_msg msg;
+   msg.addr = m_addr;
+   msg.flags = 0;
+   msg.len = (unsigned short)len;
+   msg.buf = (unsigned char *)buf;
+   return m_bus.transfer(&msg, 1, priority, this);
+}
+
+/*------------------------------------------------------I2cBus::Port::receive-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+bool I2cBus::Port::receive(void * buf, int len, PRIORITY priority) {
+   struct i2c_msg msg;
+   msg.addr = m_addr;
+   msg.flags = I2C_M_RD;
+   msg.len = (unsigned short)len;
+   msg.buf = (unsigned char *)buf;
+   return m_bus.transfer(&msg, 1, priority, this);
+}
+/*===========================================================================*/
@@ -0,0 +1,158 @@
+/*
+* Author:  agent
+* Written: 10/16/2026
+*
+* I2cBus - One Linux i2c-dev bus, shared by several device drivers
+*
+* The bus owns the file descriptor.  Each device gets a Port, at its own
+* I2C address, realizing the Interface its driver expects.  Every port
+* transaction is a single ioctl(I2C_RDWR) (addresses are per message: no
+* I2C_SLAVE), and transactions are serialized, by priority first, then in
+* order of arrival.  A transaction already on the wire is never cut: a
+* high priority one only overtakes those still waiting.
+*
+* Each port accounts its number of transactions, the time it occupied
+* the bus, and the time it waited for it.
+*
+* The bus knows no driver: the adapters, deriving from Port, live beside
+* each driver (Bmp280BusPort, Sgp30BusPort.)
+*/
+#ifndef _I2C_BUS_H_
+#define _I2C_BUS_H_
+
+#include <pthread.h>
+#include <atomic>
+#include <linux/i2c.h>
+
+class I2cBus {
+public:
+   enum PRIORITY {
+      PRIORITY_HIGH,               // e.g. the 1 Hz SGP30 tick
+      PRIORITY_NORMAL,
+      PRIORITY_LOW                 // bulk work, e.g. SGP30 measure_test
+   };
+   class Port;
+
+   I2cBus(char const * path);      // ex: "/dev/i2c-1"
+   virtual ~I2cBus();
+   bool isOk() const;
+
+   // messages separated by repeated starts, in one exclusive transaction
+   bool transfer(struct i2c_msg * msgs, int count, PRIORITY priority);
+
+   int getWaiting();               // transactions queued for the bus
+
+protected:
+   I2cBus(int fd);                 // fd is owned; -1: control() realized
+
+   // the only system call of a transaction: overridden to count or emulate
+   virtual int control(unsigned long request, void * arg);
+   // within control(): the priority of the transaction on the wire
+   PRIORITY getWirePriority() const;
+
+private:
+   struct Waiter {
+      PRIORITY priority;
+      unsigned long long ticket;
+      Waiter * next;
+   };
+   int m_fd;
+   pthread_mutex_t m_mutex;
+   pthread_cond_t m_cond;
+   Waiter * m_waiters;             // sorted by priority, then ticket
+   unsigned long long m_nextTicket;
+   bool m_isBusy;
+   PRIORITY m_wirePriority;        // of the transaction holding the bus
+
+   friend class Port;
+   bool transfer(
+      struct i2c_msg * msgs, int count, PRIORITY priority, Port * port
+   );
+   void acquire(Waiter & waiter);
+   void release();
+   static long long now();
+
+   I2cBus(I2cBus const &);         // no copy
+   I2cBus & operator=(I2cBus const &);
+};
+
+/*---------------------------------------------------------class I2cBus::Port-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+class I2cBus::Port {
+public:
+   Port(I2cBus & bus, int i2cAddr, PRIORITY priority = PRIORITY_NORMAL);
+   int getAddress() const;
+   PRIORITY getPriority() const;
+   void setPriority(PRIORITY priority);
+
+   // readable from any thread
+   long long getTransactions() const;
+   long long getFailures() const;
+   long long getOccupancyMicros() const;   // holding the bus
+   long long getWaitMicros() const;        // waiting for the bus
+
+protected:
+   I2cBus & m_bus;
+   unsigned short const m_addr;
+   PRIORITY m_priority;
+
+   bool send(void const * buf, int len, PRIORITY priority);
+   bool receive(void * buf, int len, PRIORITY priority);
+   bool transfer(struct i2c_msg * msgs, int count, PRIORITY priority);
+
+private:
+   friend class I2cBus;
+   std::atomic<long long> m_transactions;
+   std::atomic<long long> m_failures;
+   std::atomic<long long> m_occupancyMicros;
+   std::atomic<long long> m_waitMicros;
+};
+
+/*--------+
+| INLINES |
++--------*/
+inline bool I2cBus::isOk() const {
+   return m_fd >= 0;
+}
+inline I2cBus::PRIORITY I2cBus::getWirePriority() const {
+   return m_wirePriority;
+}
+inline bool I2cBus::transfer(
+   struct i2c_msg * msgs,
+   int count,
+   PRIORITY priority
+) {
+   return transfer(msgs, count, priority, 0);
+}
+inline bool I2cBus::Port::transfer(
+   struct i2c_msg * msgs,
+   int count,
+   PRIORITY priority
+) {
+   return m_bus.transfer(msgs, count, priority, this);
+}
+inline int I2cBus::Port::getAddress() const {
+   return m_addr;
+}
+inline I2cBus::PRIORITY I2cBus::Port::getPriority() const {
+   return m_priority;
+}
+inline void I2cBus::Port::setPriority(PRIORITY priority) {
+   m_priority = priority;
+}
+inline long long I2cBus::Port::getTransactions() const {
+   return m_transactions.load(std::memory_order_relaxed);
+}
+inline long long I2cBus::Port::getFailures() const {
+   return m_failures.load(std::memory_order_relaxed);
+}
+inline long long I2cBus::Port::getOccupancyMicros() const {
+   return m_occupancyMicros.load(std::memory_order_relaxed);
+}
+inline long long I2cBus::Port::getWaitMicros() const {
+   return m_waitMicros.load(std::memory_order_relaxed);
+}
+
+#endif
+/*===========================================================================*/
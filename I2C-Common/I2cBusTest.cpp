@@ -0,0 +1,230 @@
+/*
+* Author:  agent
+* Written: 10/16/2026
+*
+* Checks of I2cBus, without any hardware: "I2cBusTest" (or
+* "I2cBusTest check") exits with 1 on failure.
+*
+* Compile with:
+* g++ -O2 -Wall -std=c++0x -pthread I2cBus.cpp I2cBusTest.cpp -o I2cBusTest
+*/
+#include <unistd.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <linux/i2c-dev.h>
+#include "I2cBus.h"
+
+static bool check();
+
+int main(int argc, char const * const * argv)
+{
+   (void)argc;
+   (void)argv;
+   return check()? 0 : 1;
+}
+
+/*------------------------------------------------------------- class GateBus-+
+| A stand-in bus: each transaction records the address of its first message.  |
+| The first one is held on the wire until open() is called, so the others     |
+| pile up in the queue, in a known order.                                     |
++----------------------------------------------------------------------------*/
+class GateBus : public I2cBus {
+public:
+   enum { MAX_ADDRESSES = 16 };
+   GateBus();
+   void waitHeld();
+   void open();
+   int getCount() const;
+   int getAddress(int i) const;
+protected:
+   int control(unsigned long request, void * arg);
+private:
+   pthread_mutex_t m_gateMutex;
+   pthread_cond_t m_gateCond;
+   bool m_isHeld;
+   bool m_isOpen;
+   int m_count;
+   int m_addresses[MAX_ADDRESSES];
+};
+
+GateBus::GateBus() :
+I2cBus(-1),
+m_gateMutex(PTHREAD_MUTEX_INITIALIZER),
+m_gateCond(PTHREAD_COND_INITIALIZER),
+m_isHeld(false),
+m_isOpen(false),
+m_count(0)
+{}
+
+void GateBus::waitHeld() {
+   pthread_mutex_lock(&m_gateMutex);
+   while (!m_isHeld) pthread_cond_wait(&m_gateCond, &m_gateMutex);
+   pthread_mutex_unlock(&m_gateMutex);
+}
+
+void GateBus::open() {
+   pthread_mutex_lock(&m_gateMutex);
+   m_isOpen = true;
+   pthread_cond_broadcast(&m_gateCond);
+   pthread_mutex_unlock(&m_gateMutex);
+}
+
+int GateBus::getCount() const {
+   return m_count;
+}
+
+int GateBus::getAddress(int i) const {
+   return m_addresses[i];
+}
+
+int GateBus::control(unsigned long request, void * arg) {
+   struct i2c_rdwr_ioctl_data * data = (struct i2c_rdwr_ioctl_data *)arg;
+   (void)request;
+   pthread_mutex_lock(&m_gateMutex);
+   if (m_count < MAX_ADDRESSES) m_addresses[m_count] = data->msgs[0].addr;
+   if (m_count++ == 0) {
+      m_isHeld = true;
+      pthread_cond_broadcast(&m_gateCond);
+      while (!m_isOpen) pthread_cond_wait(&m_gateCond, &m_gateMutex);
+   }
+   pthread_mutex_unlock(&m_gateMutex);
+   return data->nmsgs;
+}
+
+/*------------------------------------------------------------ class PingPort-+
+| A port sending one byte, from its own thread                                |
++----------------------------------------------------------------------------*/
+class PingPort : public I2cBus::Port {
+public:
+   PingPort(I2cBus & bus, int i2cAddr, I2cBus::PRIORITY priority);
+   bool start();
+   bool join();
+private:
+   pthread_t m_thread;
+   bool m_isStarted;
+   bool m_isOk;
+   static void * run(void * arg);
+};
+
+PingPort::PingPort(I2cBus & bus, int i2cAddr, I2cBus::PRIORITY priority) :
+Port(bus, i2cAddr, priority),
+m_isStarted(false),
+m_isOk(false)
+{}
+
+bool PingPort::start() {
+   m_isStarted = (pthread_create(&m_thread, 0, run, this) == 0);
+   return m_isStarted;
+}
+
+bool PingPort::join() {
+   if (!m_isStarted) return false;
+   pthread_join(m_thread, 0);
+   m_isStarted = false;
+   return m_isOk;
+}
+
+void * PingPort::run(void * arg) {
+   PingPort * port = (PingPort *)arg;
+   unsigned char byte = 0;
+   port->m_isOk = port->send(&byte, 1, port->m_priority);
+   return 0;
+}
+
+/*----------------------------------------------------------------waitWaiting-+
+| Poll, for at most 2 seconds, until 'count' transactions are queued          |
++----------------------------------------------------------------------------*/
+static bool waitWaiting(I2cBus & bus, int count) {
+   for (int i=0; i < 2000; ++i) {
+      if (bus.getWaiting() == count) return true;
+      usleep(1000);
+   }
+   return false;
+}
+
+/*-----------------------------------------------------------------checkOrder-+
+| While the first transaction holds the bus, queue the others one by one:     |
+| they must go high first, then normal, then low, each priority in order of   |
+| arrival.                                                                    |
++----------------------------------------------------------------------------*/
+static bool checkOrder() {
+   enum { PORTS = 6 };
+   static struct {
+      int address;
+      I2cBus::PRIORITY priority;
+   } const queue[PORTS] = {
+      { 0x10, I2cBus::PRIORITY_NORMAL },   // holds the bus
+      { 0x11, I2cBus::PRIORITY_LOW },
+      { 0x12, I2cBus::PRIORITY_NORMAL },
+      { 0x13, I2cBus::PRIORITY_HIGH },
+      { 0x14, I2cBus::PRIORITY_NORMAL },
+      { 0x15, I2cBus::PRIORITY_HIGH }
+   };
+   static int const expected[PORTS] = { 0x10, 0x13, 0x15, 0x12, 0x14, 0x11 };
+   GateBus bus;
+   PingPort * ports[PORTS];
+   bool isOk = true;
+
+   for (int i=0; i < PORTS; ++i) {
+      ports[i] = new PingPort(bus, queue[i].address, queue[i].priority);
+   }
+   if (!ports[0]->start()) {
+      printf("I2cBus: can't start a thread\n");
+      isOk = false;
+   }else {
+      bus.waitHeld();
+      for (int i=1; i < PORTS; ++i) {
+         if (!ports[i]->start()) {
+            printf("I2cBus: can't start a thread\n");
+            isOk = false;
+         }else if (!waitWaiting(bus, i)) {
+            printf("I2cBus: transaction %d not queued\n", i);
+            isOk = false;
+         }
+      }
+      bus.open();
+   }
+   for (int i=0; i < PORTS; ++i) {
+      if (!ports[i]->join() && isOk) {
+         printf("I2cBus: transaction to 0x%02x failed\n", queue[i].address);
+         isOk = false;
+      }
+   }
+   if (isOk && (bus.getCount() != PORTS)) {
+      printf("I2cBus: %d transactions, expected %d\n", bus.getCount(), PORTS);
+      isOk = false;
+   }
+   for (int i=0; isOk && (i < PORTS); ++i) {
+      if (bus.getAddress(i) != expected[i]) {
+         printf(
+            "I2cBus: transaction %d went to 0x%02x, expected 0x%02x\n",
+            i, bus.getAddress(i), expected[i]
+         );
+         isOk = false;
+      }
+   }
+   for (int i=0; isOk && (i < PORTS); ++i) {
+      if (
+         (ports[i]->getTransactions() != 1) ||
+         (ports[i]->getFailures() != 0) ||
+         ((i > 0) && (ports[i]->getWaitMicros() <= 0))
+      ) {
+         printf("I2cBus: bad counters for 0x%02x\n", queue[i].address);
+         isOk = false;
+      }
+   }
+   for (int i=0; i < PORTS; ++i) delete ports[i];
+   if (isOk) printf("I2cBus: priority then arrival order, ok\n");
+   return isOk;
+}
+
+/*----------------------------------------------------------------------check-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+static bool check() {
+   bool isOk = true;
+   isOk = checkOrder() && isOk;
+   printf("%s\n", isOk? "All checks passed" : "CHECK FAILED");
+   return isOk;
+}
+/*===========================================================================*/
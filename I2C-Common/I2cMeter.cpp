@@ -0,0 +1,322 @@
+/*
+* Author:  agent
+* Written: 10/16/2026
+*
+* I2cMeter - Per operation counters and latency histograms of a driver
+*/
+#include <stdio.h>
+#include <time.h>
+#include "I2cMeter.h"
+
+/*---------------------------------------------------------I2cMeter::I2cMeter-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+I2cMeter::I2cMeter(char const * name, bool isSpi) :
+m_name(name),
+m_isSpi(isSpi),
+m_start(now()),
+m_count(0),
+m_overflows(0),
+m_sleeps(0),
+m_sleepMicros(0)
+{
+   for (int i=0; i < MAX_OPERATIONS; ++i) {
+      Operation & operation = m_operations[i];
+      operation.key.store(0, std::memory_order_relaxed);
+      operation.count.store(0, std::memory_order_relaxed);
+      operation.bytes.store(0, std::memory_order_relaxed);
+      operation.bits.store(0, std::memory_order_relaxed);
+      operation.failures.store(0, std::memory_order_relaxed);
+      operation.nanosSum.store(0, std::memory_order_relaxed);
+      for (int j=0; j < BUCKETS; ++j) {
+         operation.histogram[j].store(0, std::memory_order_relaxed);
+      }
+   }
+}
+
+/*-----------------------------------------------------I2cMeter::getSnapshots-+
+| Copy the counters of up to 'max' operations.  Returns the number copied.    |
++----------------------------------------------------------------------------*/
+int I2cMeter::getSnapshots(Snapshot * snapshots, int max) const {
+   int count = m_count.load(std::memory_order_acquire);
+   if (count > max) count = max;
+   for (int i=0; i < count; ++i) {
+      Operation const & operation = m_operations[i];
+      Snapshot & snapshot = snapshots[i];
+      unsigned int key = operation.key.load(std::memory_order_relaxed);
+      snapshot.op = (OP)(key >> 16);
+      snapshot.code = (unsigned short)key;
+      snapshot.count = operation.count.load(std::memory_order_relaxed);
+      snapshot.bytes = operation.bytes.load(std::memory_order_relaxed);
+      snapshot.bits = operation.bits.load(std::memory_order_relaxed);
+      snapshot.failures = operation.failures.load(std::memory_order_relaxed);
+      snapshot.nanosSum = operation.nanosSum.load(std::memory_order_relaxed);
+      for (int j=0; j < BUCKETS; ++j) {
+         snapshot.histogram[j] = operation.histogram[j].load(
+            std::memory_order_relaxed
+         );
+      }
+   }
+   return count;
+}
+
+/*STATIC-----------------------------------------I2cMeter::getPercentileNanos-+
+| Upper bound of the bucket holding the percentile (0 if no count.)           |
++----------------------------------------------------------------------------*/
+unsigned long long I2cMeter::getPercentileNanos(
+   Snapshot const & snapshot,
+   int percentile
+) {
+   unsigned long long total = 0;
+   unsigned long long seen = 0;
+   unsigned long long target;
+
+   for (int i=0; i < BUCKETS; ++i) total += snapshot.histogram[i];
+   if (total == 0) return 0;
+   target = ((total * percentile) + 99) / 100;
+   for (int i=0; i < BUCKETS - 1; ++i) {
+      seen += snapshot.histogram[i];
+      if (seen >= target) return getBucketFloor(i + 1);
+   }
+   return getBucketFloor(BUCKETS - 1);
+}
+
+/*-------------------------------------------------I2cMeter::getSessionMicros-+
+| The elapsed time, or the time slept plus the time on the bus at 'clockHz',  |
+| if longer: behind an emulator, a sleep does not take any real time.         |
++----------------------------------------------------------------------------*/
+long long I2cMeter::getSessionMicros(unsigned int clockHz) const {
+   Snapshot snapshots[MAX_OPERATIONS];
+   int count = getSnapshots(snapshots, MAX_OPERATIONS);
+   long long elapsed = getElapsedMicros();
+   long long busy = getSleepMicros();
+
+   for (int i=0; i < count; ++i) busy += getBusMicros(snapshots[i], clockHz);
+   return (busy > elapsed)? busy : elapsed;
+}
+
+/*------------------------------------------------------------I2cMeter::print-+
+| Per operation: the mean and percentiles of the latencies, and the share of  |
+| the session time the bus was occupied, at 100 kHz and 400 kHz.              |
++----------------------------------------------------------------------------*/
+void I2cMeter::print() const {
+   static char const * const opNames[] = { "?", "write", "read", "readReg" };
+   Snapshot snapshots[MAX_OPERATIONS];
+   int count = getSnapshots(snapshots, MAX_OPERATIONS);
+   long long elapsed = getElapsedMicros();
+   long long session100k = getSessionMicros(100000);
+   long long session400k = getSessionMicros(400000);
+
+   if (session100k <= 0) session100k = 1;
+   if (session400k <= 0) session400k = 1;
+   printf(
+      "%s: %lld ms, %llu sleeps (%llu ms%s), %llu not accounted\n",
+      m_name, elapsed / 1000, getSleeps(), getSleepMicros() / 1000,
+      ((long long)getSleepMicros() > elapsed)? ", virtual" : "",
+      getOverflows()
+   );
+   printf(
+      "   op       code    count    bytes failures"
+      "  mean us   p50 us   p99 us bus%%100k bus%%400k\n"
+   );
+   for (int i=0; i < count; ++i) {
+      Snapshot const & snapshot = snapshots[i];
+      printf(
+         "   %-7s 0x%04x %8llu %8llu %8llu %8.1f %8.1f %8.1f %8.2f %8.2f\n",
+         opNames[(snapshot.op <= OP_READ_REG)? snapshot.op : 0],
+         snapshot.code, snapshot.count, snapshot.bytes, snapshot.failures,
+         snapshot.count? (snapshot.nanosSum / 1e3) / snapshot.count : 0.0,
+         getPercentileNanos(snapshot, 50) / 1e3,
+         getPercentileNanos(snapshot, 99) / 1e3,
+         (100.0 * getBusMicros(snapshot, 100000)) / session100k,
+         (100.0 * getBusMicros(snapshot, 400000)) / session400k
+      );
+   }
+}
+
+/*PROTECTED--------------------------------------------------I2cMeter::record-+
+| Account a call started at 'start' (see now.)                                |
+| I2C: 9 bits per byte, the address byte first; the repeated start of a       |
+| register read sends the address again.  A NACK only costs the address.      |
+| SPI: 8 bits per byte, the register address first for a read.                |
+| The bytes of a failed call are not transferred.                             |
++----------------------------------------------------------------------------*/
+void I2cMeter::record(
+   OP op,
+   unsigned short code,
+   int len,
+   bool isOk,
+   long long start
+) {
+   unsigned long long nanos = now() - start;
+   Operation * operation = find(((unsigned int)op << 16) | code);
+   unsigned long long bits;
+
+   if (!operation) {
+      m_overflows.fetch_add(1, std::memory_order_relaxed);
+      return;
+   }
+   if (len < 0) len = 0;
+   if (m_isSpi) {
+      bits = 8 * (len + ((op == OP_WRITE)? 0 : 1));
+   }else if (!isOk) {
+      bits = 9 + 2;
+   }else if (op == OP_READ_REG) {
+      bits = (9 * (3 + len)) + 3;
+   }else {
+      bits = (9 * (1 + len)) + 2;
+   }
+   operation->count.fetch_add(1, std::memory_order_relaxed);
+   if (isOk) operation->bytes.fetch_add(len, std::memory_order_relaxed);
+   operation->bits.fetch_add(bits, std::memory_order_relaxed);
+   if (!isOk) operation->failures.fetch_add(1, std::memory_order_relaxed);
+   operation->nanosSum.fetch_add(nanos, std::memory_order_relaxed);
+   operation->histogram[getBucket(nanos)].fetch_add(
+      1, std::memory_order_relaxed
+   );
+}
+
+/*PROTECTED---------------------------------------------I2cMeter::recordSleep-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+void I2cMeter::recordSleep(unsigned long long micros) {
+   m_sleeps.fetch_add(1, std::memory_order_relaxed);
+   m_sleepMicros.fetch_add(micros, std::memory_order_relaxed);
+}
+
+/*STATIC--------------------------------------------------------I2cMeter::now-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+long long I2cMeter::now() {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (ts.tv_sec * 1000000000LL) + ts.tv_nsec;
+}
+
+/*-------------------------------------------------------------I2cMeter::find-+
+| The operation of 'key', added if new (0 if the table is full.)              |
+| Only the writer adds operations: a new one is published by the release      |
+| store of m_count, once its key is set.                                      |
++----------------------------------------------------------------------------*/
+I2cMeter::Operation * I2cMeter::find(unsigned int key) {
+   int count = m_count.load(std::memory_order_relaxed);
+   for (int i=0; i < count; ++i) {
+      if (m_operations[i].key.load(std::memory_order_relaxed) == key) {
+         return &m_operations[i];
+      }
+   }
+   if (count == MAX_OPERATIONS) return 0;
+   m_operations[count].key.store(key, std::memory_order_relaxed);
+   m_count.store(count + 1, std::memory_order_release);
+   return &m_operations[count];
+}
+
+/*STATIC--------------------------------------------------I2cMeter::getBucket-+
+| Log-linear: 0 to 3 ns have their own bucket, then each power of 2 is split  |
+| in 4 buckets, by the 2 bits following the most significant one.             |
++----------------------------------------------------------------------------*/
+int I2cMeter::getBucket(unsigned long long nanos) {
+   if (nanos < 4) {
+      return (int)nanos;
+   }else {
+      int msb = 63 - __builtin_clzll(nanos);
+      int bucket = (4 * (msb - 1)) + (int)((nanos >> (msb - 2)) & 3);
+      return (bucket < BUCKETS)? bucket : BUCKETS - 1;
+   }
+}
+
+/*STATIC---------------------------------------------I2cMeter::getBucketFloor-+
+| The lowest value held by 'bucket'                                           |
++----------------------------------------------------------------------------*/
+unsigned long long I2cMeter::getBucketFloor(int bucket) {
+   if (bucket < 4) {
+      return bucket;
+   }else {
+      return (4ULL + (bucket & 3)) << ((bucket / 4) - 1);
+   }
+}
+
+/*-----------------------------------------I2cMeter::Bmp280Meter::Bmp280Meter-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+I2cMeter::Bmp280Meter::Bmp280Meter(
+   Bmp280Device::Interface & inner,
+   char const * name
+) :
+I2cMeter(name, inner.isSpi()),
+m_inner(inner)
+{}
+
+/*-----------------------------------------------I2cMeter::Bmp280Meter::sleep-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+void I2cMeter::Bmp280Meter::sleep(int ms) {
+   m_inner.sleep(ms);
+   recordSleep(1000ULL * ms);
+}
+
+/*-----------------------------------------------I2cMeter::Bmp280Meter::write-+
+| Accounted to the first register written                                     |
++----------------------------------------------------------------------------*/
+bool I2cMeter::Bmp280Meter::write(void const * buf, int len) {
+   long long start = now();
+   bool isOk = m_inner.write(buf, len);
+   record(
+      OP_WRITE, (len > 0)? *(unsigned char const *)buf : 0, len, isOk, start
+   );
+   return isOk;
+}
+
+/*---------------------------------------------I2cMeter::Bmp280Meter::readReg-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+bool I2cMeter::Bmp280Meter::readReg(unsigned char reg, void * buf, int len) {
+   long long start = now();
+   bool isOk = m_inner.readReg(reg, buf, len);
+   record(OP_READ_REG, reg, len, isOk, start);
+   return isOk;
+}
+
+/*-------------------------------------------I2cMeter::Sgp30Meter::Sgp30Meter-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+I2cMeter::Sgp30Meter::Sgp30Meter(
+   Sgp30Device::Interface & inner,
+   char const * name
+) :
+I2cMeter(name),
+m_inner(inner),
+m_lastCode(0)
+{}
+
+/*------------------------------------------------I2cMeter::Sgp30Meter::sleep-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+void I2cMeter::Sgp30Meter::sleep(int us) {
+   m_inner.sleep(us);
+   recordSleep(us);
+}
+
+/*------------------------------------------------I2cMeter::Sgp30Meter::write-+
+| The command code is in the first 2 bytes (datasheet, v0.9, table 9)         |
++----------------------------------------------------------------------------*/
+bool I2cMeter::Sgp30Meter::write(void const * buf, int len) {
+   unsigned char const * cp = (unsigned char const *)buf;
+   long long start = now();
+   bool isOk = m_inner.write(buf, len);
+   m_lastCode = (len >= 2)? (unsigned short)((cp[0] << 8) | cp[1]) : 0;
+   record(OP_WRITE, m_lastCode, len, isOk, start);
+   return isOk;
+}
+
+/*-------------------------------------------------I2cMeter::Sgp30Meter::read-+
+| Accounted to the last command written: a NACK means "still measuring".      |
++----------------------------------------------------------------------------*/
+bool I2cMeter::Sgp30Meter::read(void * buf, int len) {
+   long long start = now();
+   bool isOk = m_inner.read(buf, len);
+   record(OP_READ, m_lastCode, len, isOk, start);
+   return isOk;
+}
+
+/*===========================================================================*/
@@ -0,0 +1,165 @@
+/*
+* Author:  agent
+* Written: 10/16/2026
+*
+* I2cMeter - Per operation counters and latency histograms of a driver
+*
+* A meter is put between a driver and its Interface.  Each write, read or
+* readReg is timed and accounted to its operation: the register (BMP280),
+* or the command (SGP30, the read going to the command last written.)
+* Per operation: count, bytes, failures, bits on the wire and a log-linear
+* histogram of the latencies (4 buckets per power of 2 nanoseconds.)
+*
+* The bits on the wire give the bus occupancy at any clock frequency, e.g.
+* 100 or 400 kHz: 9 bits per I2C byte (address included), plus the start,
+* repeated start and stop conditions.  A NACK only costs the address byte.
+* The occupancy is a share of the session time: the elapsed time or, if
+* longer, the time slept plus the time on the bus.  Behind an emulator, the
+* sleeps only advance a virtual clock, and the session lasts longer than
+* the wall clock says: the share still never goes above 100%.
+*
+* All the counters are relaxed atomics: another thread reads them at any
+* time, without any lock (a snapshot may be off by the call in progress.)
+* One thread at a time calls the Interface, as for the driver itself.
+*/
+#ifndef _I2C_METER_H_
+#define _I2C_METER_H_
+
+#include <atomic>
+#include "Bmp280Device.h"
+#include "Sgp30Device.h"
+
+class I2cMeter {
+public:
+   enum OP {
+      OP_WRITE = 1,
+      OP_READ = 2,
+      OP_READ_REG = 3
+   };
+   enum {
+      BUCKETS = 144,               // up to 2**37 ns (137 s)
+      MAX_OPERATIONS = 32
+   };
+   struct Snapshot {
+      OP op;
+      unsigned short code;         // register, or command
+      unsigned long long count;
+      unsigned long long bytes;    // payload transferred
+      unsigned long long bits;     // on the wire
+      unsigned long long failures;
+      unsigned long long nanosSum;
+      unsigned long long histogram[BUCKETS];
+   };
+   class Bmp280Meter;
+   class Sgp30Meter;
+
+   I2cMeter(char const * name, bool isSpi = false);
+   char const * getName() const;
+
+   // readable from any thread
+   int getSnapshots(Snapshot * snapshots, int max) const;
+   unsigned long long getOverflows() const;   // operations not accounted
+   unsigned long long getSleeps() const;
+   unsigned long long getSleepMicros() const;
+   long long getElapsedMicros() const;        // since the meter creation
+   long long getSessionMicros(unsigned int clockHz) const;
+   static unsigned long long getBusMicros(
+      Snapshot const & snapshot, unsigned int clockHz
+   );
+   static unsigned long long getPercentileNanos(
+      Snapshot const & snapshot, int percentile
+   );
+   void print() const;
+
+protected:
+   void record(
+      OP op, unsigned short code, int len, bool isOk, long long start
+   );
+   void recordSleep(unsigned long long micros);
+   static long long now();         // CLOCK_MONOTONIC, in nanoseconds
+
+private:
+   struct Operation {
+      std::atomic<unsigned int> key;   // (op << 16) | code, once published
+      std::atomic<unsigned long long> count;
+      std::atomic<unsigned long long> bytes;
+      std::atomic<unsigned long long> bits;
+      std::atomic<unsigned long long> failures;
+      std::atomic<unsigned long long> nanosSum;
+      std::atomic<unsigned long long> histogram[BUCKETS];
+   };
+   char const * m_name;
+   bool const m_isSpi;
+   long long const m_start;
+   std::atomic<int> m_count;       // published operations
+   std::atomic<unsigned long long> m_overflows;
+   std::atomic<unsigned long long> m_sleeps;
+   std::atomic<unsigned long long> m_sleepMicros;
+   Operation m_operations[MAX_OPERATIONS];
+
+   Operation * find(unsigned int key);
+   static int getBucket(unsigned long long nanos);
+   static unsigned long long getBucketFloor(int bucket);
+
+   I2cMeter(I2cMeter const &);     // no copy
+   I2cMeter & operator=(I2cMeter const &);
+};
+
+/*------------------------------------------------class I2cMeter::Bmp280Meter-+
+| Operations: the register read, or the first register written.               |
++----------------------------------------------------------------------------*/
+class I2cMeter::Bmp280Meter : public I2cMeter, public Bmp280Device::Interface {
+public:
+   Bmp280Meter(Bmp280Device::Interface & inner, char const * name);
+   bool isSpi() const;
+   void sleep(int ms);
+   bool write(void const * buf, int len);
+   bool readReg(unsigned char reg, void * buf, int len);
+private:
+   Bmp280Device::Interface & m_inner;
+};
+
+/*-------------------------------------------------class I2cMeter::Sgp30Meter-+
+| Operations: the command written, and the read of its values.                |
++----------------------------------------------------------------------------*/
+class I2cMeter::Sgp30Meter : public I2cMeter, public Sgp30Device::Interface {
+public:
+   Sgp30Meter(Sgp30Device::Interface & inner, char const * name);
+   void sleep(int us);
+   bool write(void const * buf, int len);
+   bool read(void * buf, int len);
+private:
+   Sgp30Device::Interface & m_inner;
+   unsigned short m_lastCode;      // of the last command written
+};
+
+/*--------+
+| INLINES |
++--------*/
+inline char const * I2cMeter::getName() const {
+   return m_name;
+}
+inline unsigned long long I2cMeter::getOverflows() const {
+   return m_overflows.load(std::memory_order_relaxed);
+}
+inline unsigned long long I2cMeter::getSleeps() const {
+   return m_sleeps.load(std::memory_order_relaxed);
+}
+inline unsigned long long I2cMeter::getSleepMicros() const {
+   return m_sleepMicros.load(std::memory_order_relaxed);
+}
+inline long long I2cMeter::getElapsedMicros() const {
+   return (now() - m_start) / 1000;
+}
+inline unsigned long long I2cMeter::getBusMicros(
+   Snapshot const & snapshot,
+   unsigned int clockHz
+) {
+   return (snapshot.bits * 1000000ULL) / clockHz;
+}
+inline bool I2cMeter::Bmp280Meter::isSpi() const {
+   return m_inner.isSpi();
+}
+
+#endif
+/*===========================================================================*/
@@ -0,0 +1,207 @@
+/*
+* Author:  agent
+* Written: 10/16/2026
+*
+* Checks of I2cMeter, without any hardware: the meters wrap the emulators,
+* and the calls are known.  "I2cMeterTest" exits with 1 on failure.
+*
+* Compile with:
+* g++ -O2 -Wall -std=c++0x -I. -I../Bosch-BMP280 -I../Sensirion-SGP30
+*  I2cMeter.cpp I2cMeterTest.cpp
+*  ../Bosch-BMP280/Bmp280Calibration.cpp ../Bosch-BMP280/Bmp280Emulator.cpp
+*  ../Sensirion-SGP30/Sgp30Crc.cpp ../Sensirion-SGP30/Sgp30Emulator.cpp
+*  -o I2cMeterTest
+*/
+#include <stdio.h>
+#include "I2cMeter.h"
+#include "Bmp280Emulator.h"
+#include "Sgp30Emulator.h"
+
+static bool check();
+
+int main(int argc, char const * const * argv)
+{
+   (void)argc;
+   (void)argv;
+   return check()? 0 : 1;
+}
+
+/*-------------------------------------------------------------------Expected-+
+| The counters an operation must have                                         |
++----------------------------------------------------------------------------*/
+struct Expected {
+   I2cMeter::OP op;
+   unsigned short code;
+   unsigned long long count;
+   unsigned long long bytes;
+   unsigned long long bits;
+   unsigned long long failures;
+};
+
+/*--------------------------------------------------------------checkCounters-+
+| All the operations of the meter, and only them, with their counters.  The   |
+| latency histogram must hold each call.  At any clock, the session is at     |
+| least the time slept, and the bus occupancy of all the operations never     |
+| goes above 100%.                                                            |
++----------------------------------------------------------------------------*/
+static bool checkCounters(
+   I2cMeter const & meter,
+   Expected const * expected,
+   int expectedCount,
+   unsigned long long sleepMicros
+) {
+   static unsigned int const clocks[] = { 100000, 400000, 10000000 };
+   static I2cMeter::Snapshot snapshots[I2cMeter::MAX_OPERATIONS];
+   int count = meter.getSnapshots(snapshots, I2cMeter::MAX_OPERATIONS);
+   bool isOk = true;
+
+   if ((count != expectedCount) || (meter.getOverflows() != 0)) {
+      printf(
+         "Meter: %s, %d operation(s), expected %d\n",
+         meter.getName(), count, expectedCount
+      );
+      return false;
+   }
+   for (int i=0; i < expectedCount; ++i) {
+      Expected const & e = expected[i];
+      I2cMeter::Snapshot const * s = 0;
+      unsigned long long calls = 0;
+      for (int j=0; j < count; ++j) {
+         if ((snapshots[j].op == e.op) && (snapshots[j].code == e.code)) {
+            s = &snapshots[j];
+         }
+      }
+      if (!s) {
+         printf("Meter: %s, no op %d 0x%04x\n", meter.getName(), e.op, e.code);
+         isOk = false;
+         continue;
+      }
+      for (int j=0; j < I2cMeter::BUCKETS; ++j) calls += s->histogram[j];
+      if (
+         (s->count != e.count) || (s->bytes != e.bytes) ||
+         (s->bits != e.bits) || (s->failures != e.failures) ||
+         (calls != e.count)
+      ) {
+         printf(
+            "Meter: %s, op %d 0x%04x: count %llu, bytes %llu, bits %llu, "
+            "failures %llu, histogram %llu; expected %llu, %llu, %llu, %llu\n",
+            meter.getName(), e.op, e.code, s->count, s->bytes, s->bits,
+            s->failures, calls, e.count, e.bytes, e.bits, e.failures
+         );
+         isOk = false;
+      }
+   }
+   if ((meter.getSleepMicros() != sleepMicros) || (meter.getSleeps() != 1)) {
+      printf(
+         "Meter: %s, %llu sleep(s) of %llu us, expected 1 of %llu us\n",
+         meter.getName(), meter.getSleeps(), meter.getSleepMicros(),
+         sleepMicros
+      );
+      isOk = false;
+   }
+   for (unsigned int i=0; i < sizeof clocks / sizeof clocks[0]; ++i) {
+      unsigned long long bus = 0;
+      long long session = meter.getSessionMicros(clocks[i]);
+      for (int j=0; j < count; ++j) {
+         bus += I2cMeter::getBusMicros(snapshots[j], clocks[i]);
+      }
+      if ((session < (long long)(sleepMicros + bus))) {
+         printf(
+            "Meter: %s, at %u Hz, a session of %lld us, for %llu us slept "
+            "and %llu us on the bus\n",
+            meter.getName(), clocks[i], session, sleepMicros, bus
+         );
+         isOk = false;
+      }
+   }
+   return isOk;
+}
+
+/*-------------------------------------------------------------checkBmp280I2c-+
+| I2C: 9 bits per byte, with the address, plus start and stop (2 bits); a     |
+| register read writes the register, then reads after a repeated start (3     |
+| bits.)  A write of an odd length is NACK'ed by the emulator.                |
++----------------------------------------------------------------------------*/
+static bool checkBmp280I2c() {
+   static unsigned char const options[] = { 0xF5, 0x00, 0xF4, 0x25 };
+   static Expected const expected[] = {
+      { I2cMeter::OP_READ_REG, 0xD0, 3,  3, 3 * ((9 * (3 + 1)) + 3), 0 },
+      { I2cMeter::OP_WRITE,    0xF5, 2,  8, 2 * ((9 * (1 + 4)) + 2), 0 },
+      { I2cMeter::OP_WRITE,    0xF4, 1,  0, 9 + 2, 1 },
+      { I2cMeter::OP_READ_REG, 0xF7, 4, 24, 4 * ((9 * (3 + 6)) + 3), 0 }
+   };
+   Bmp280Emulator emulator;
+   I2cMeter::Bmp280Meter meter(emulator, "bmp280 i2c");
+   unsigned char buf[6];
+
+   for (int i=0; i < 3; ++i) meter.readReg(0xD0, buf, 1);
+   for (int i=0; i < 2; ++i) meter.write(options, sizeof options);
+   meter.write(options + 2, 1);
+   meter.sleep(10);
+   for (int i=0; i < 4; ++i) meter.readReg(0xF7, buf, 6);
+   return checkCounters(
+      meter, expected, sizeof expected / sizeof expected[0], 10000
+   );
+}
+
+/*-------------------------------------------------------------checkBmp280Spi-+
+| SPI: 8 bits per byte, and a read sends the register first.                  |
++----------------------------------------------------------------------------*/
+static bool checkBmp280Spi() {
+   static unsigned char const options[] = { 0x74, 0x25 };
+   static Expected const expected[] = {
+      { I2cMeter::OP_WRITE,    0x74, 1, 2, 8 * 2, 0 },
+      { I2cMeter::OP_READ_REG, 0xF7, 2, 12, 2 * 8 * (1 + 6), 0 }
+   };
+   Bmp280Emulator emulator(true);
+   I2cMeter::Bmp280Meter meter(emulator, "bmp280 spi");
+   unsigned char buf[6];
+
+   meter.write(options, sizeof options);
+   meter.sleep(10);
+   for (int i=0; i < 2; ++i) meter.readReg(0xF7, buf, 6);
+   return checkCounters(
+      meter, expected, sizeof expected / sizeof expected[0], 10000
+   );
+}
+
+/*-----------------------------------------------------------------checkSgp30-+
+| A read is accounted to the command last written.  Read while the command    |
+| runs, it is NACK'ed: only the address goes on the wire, nothing is read.    |
++----------------------------------------------------------------------------*/
+static bool checkSgp30() {
+   static unsigned char const measureTest[] = { 0x20, 0x32 };
+   static unsigned char const iaqInit[] = { 0x20, 0x03 };
+   static Expected const expected[] = {
+      { I2cMeter::OP_WRITE, 0x2032, 1, 2, (9 * (1 + 2)) + 2, 0 },
+      { I2cMeter::OP_READ,  0x2032, 2, 3, (9 + 2) + ((9 * (1 + 3)) + 2), 1 },
+      { I2cMeter::OP_WRITE, 0x2003, 1, 2, (9 * (1 + 2)) + 2, 0 }
+   };
+   Sgp30Emulator emulator;
+   I2cMeter::Sgp30Meter meter(emulator, "sgp30");
+   unsigned char buf[3];
+
+   emulator.setTiming(Sgp30Emulator::TIMING_MAXIMUM);
+   meter.write(measureTest, sizeof measureTest);
+   meter.read(buf, sizeof buf);    // still measuring
+   meter.sleep(220000);
+   meter.read(buf, sizeof buf);
+   meter.write(iaqInit, sizeof iaqInit);
+   return checkCounters(
+      meter, expected, sizeof expected / sizeof expected[0], 220000
+   );
+}
+
+/*----------------------------------------------------------------------check-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+static bool check() {
+   bool isOk = true;
+   isOk = checkBmp280I2c() && isOk;
+   isOk = checkBmp280Spi() && isOk;
+   isOk = checkSgp30() && isOk;
+   if (isOk) printf("Meter: counts, bytes and bits on the wire, ok\n");
+   printf("%s\n", isOk? "All checks passed" : "CHECK FAILED");
+   return isOk;
+}
+/*===========================================================================*/
@@ -0,0 +1,224 @@
+/*
+* Author:  agent
+* Written: 10/16/2026
+*
+* Checks of the driver ports of I2cBus (Bmp280BusPort, Sgp30BusPort), on a
+* stand-in bus answering with the emulators: "I2cPortTest" exits with 1 on
+* failure.
+*
+* Compile with:
+* g++ -O2 -Wall -std=c++0x -pthread -I. -I../Bosch-BMP280
+*  -I../Sensirion-SGP30 I2cBus.cpp I2cPortTest.cpp
+*  ../Bosch-BMP280/Bmp280BusPort.cpp ../Bosch-BMP280/Bmp280Device.cpp
+*  ../Bosch-BMP280/Bmp280Calibration.cpp ../Bosch-BMP280/Bmp280Capture.cpp
+*  ../Bosch-BMP280/Bmp280Emulator.cpp
+*  ../Sensirion-SGP30/Sgp30BusPort.cpp ../Sensirion-SGP30/Sgp30Device.cpp
+*  ../Sensirion-SGP30/Sgp30Features.cpp ../Sensirion-SGP30/Sgp30Crc.cpp
+*  ../Sensirion-SGP30/Sgp30Latency.cpp ../Sensirion-SGP30/Sgp30Humidity.cpp
+*  ../Sensirion-SGP30/Sgp30Emulator.cpp
+*  -o I2cPortTest
+*/
+#include <stdio.h>
+#include <time.h>
+#include <linux/i2c-dev.h>
+#include "I2cBus.h"
+#include "Bmp280BusPort.h"
+#include "Bmp280Emulator.h"
+#include "Sgp30BusPort.h"
+#include "Sgp30Emulator.h"
+
+static bool check();
+
+int main(int argc, char const * const * argv)
+{
+   (void)argc;
+   (void)argv;
+   return check()? 0 : 1;
+}
+
+/*--------------------------------------------------------- class EmulatorBus-+
+| A stand-in bus: the BMP280 and the SGP30 emulators answer at their address, |
+| their virtual time following the wall clock (the ports really sleep.)       |
+| Each transaction records its address, its direction, the command written    |
+| (SGP30) and the priority it went out with.                                  |
++----------------------------------------------------------------------------*/
+class EmulatorBus : public I2cBus {
+public:
+   enum {
+      BMP280_ADDR = 0x76,
+      SGP30_ADDR = 0x58,
+      MAX_TRANSACTIONS = 64
+   };
+   struct Transaction {
+      int address;
+      bool isRead;
+      unsigned short command;      // SGP30 write, as on the datasheet
+      PRIORITY priority;
+   };
+   EmulatorBus() : I2cBus(-1), m_time(now()), m_count(0) {}
+   int getCount() const { return m_count; }
+   Transaction const & get(int i) const { return m_transactions[i]; }
+protected:
+   int control(unsigned long request, void * arg);
+private:
+   Bmp280Emulator m_bmp280;
+   Sgp30Emulator m_sgp30;
+   long long m_time;
+   int m_count;
+   Transaction m_transactions[MAX_TRANSACTIONS];
+   static long long now() {
+      struct timespec ts;
+      clock_gettime(CLOCK_MONOTONIC, &ts);
+      return (ts.tv_sec * 1000000LL) + (ts.tv_nsec / 1000);
+   }
+};
+
+int EmulatorBus::control(unsigned long request, void * arg) {
+   struct i2c_rdwr_ioctl_data * data = (struct i2c_rdwr_ioctl_data *)arg;
+   struct i2c_msg * msgs = data->msgs;
+   long long time = now();
+   bool isOk = false;
+   (void)request;
+   m_bmp280.advance(1000 * (time - m_time));
+   m_sgp30.advance(time - m_time);
+   m_time = time;
+   if (m_count < MAX_TRANSACTIONS) {
+      Transaction & transaction = m_transactions[m_count++];
+      transaction.address = msgs[0].addr;
+      transaction.isRead = (msgs[data->nmsgs-1].flags & I2C_M_RD) != 0;
+      transaction.command = (
+         (!transaction.isRead && (msgs[0].len >= 2))?
+         ((msgs[0].buf[0] << 8) | msgs[0].buf[1]) : 0
+      );
+      transaction.priority = getWirePriority();
+   }
+   if (msgs[0].addr == BMP280_ADDR) {
+      if (data->nmsgs == 1) {
+         isOk = m_bmp280.write(msgs[0].buf, msgs[0].len);
+      }else if ((data->nmsgs == 2) && (msgs[0].len == 1)) {
+         isOk = m_bmp280.readReg(msgs[0].buf[0], msgs[1].buf, msgs[1].len);
+      }
+   }else if ((msgs[0].addr == SGP30_ADDR) && (data->nmsgs == 1)) {
+      if (msgs[0].flags & I2C_M_RD) {
+         isOk = m_sgp30.read(msgs[0].buf, msgs[0].len);
+      }else {
+         isOk = m_sgp30.write(msgs[0].buf, msgs[0].len);
+      }
+   }
+   return isOk? data->nmsgs : -1;
+}
+
+/*-----------------------------------------------------------------checkPorts-+
+| Both drivers share the stand-in bus.  The SGP30 "measure air quality" and   |
+| its read must go out at high priority, "measure test" and its read at low   |
+| priority, any other SGP30 command, and all the BMP280 transactions, at      |
+| the priority of their port.                                                 |
++----------------------------------------------------------------------------*/
+static bool checkPorts() {
+   static I2cBus::PRIORITY const SGP30_PRIORITY = I2cBus::PRIORITY_NORMAL;
+   static I2cBus::PRIORITY const BMP280_PRIORITY = I2cBus::PRIORITY_LOW;
+   EmulatorBus bus;
+   Sgp30BusPort sgpPort(bus, EmulatorBus::SGP30_ADDR, SGP30_PRIORITY);
+   Bmp280BusPort bmpPort(bus, EmulatorBus::BMP280_ADDR, BMP280_PRIORITY);
+   Sgp30Device sgp(sgpPort);
+   Bmp280Device bmp(bmpPort);
+   Sgp30Device::AirQuality airQuality;
+   unsigned short testResult = 0;
+   double pressure = 0;
+   double temperature = 0;
+   I2cBus::PRIORITY commandPriority = SGP30_PRIORITY;
+   int counts[2][2] = { { 0, 0 }, { 0, 0 } };  // [measure][isRead]
+   int bmpCount = 0;
+   bool isOk = true;
+
+   if (!sgp.isOperational() || !bmp.isOperational()) {
+      printf("I2cPort: the drivers can't start on the stand-in bus\n");
+      return false;
+   }
+   bmp.setMode(Bmp280Device::VAL_MODE_FORCED);
+   if (
+      !sgp.initAirQuality() ||
+      !sgp.measureAirQuality(airQuality) ||
+      !bmp.readValuesWhenReady(pressure, temperature) ||
+      !sgp.measureTest(&testResult) ||
+      !sgp.measureAirQuality(airQuality)
+   ) {
+      printf("I2cPort: a measure failed\n");
+      isOk = false;
+   }
+   if (isOk && (testResult != 0xD400)) {
+      printf("I2cPort: measure test gave 0x%04x\n", testResult);
+      isOk = false;
+   }
+   if (isOk && (bus.getCount() >= EmulatorBus::MAX_TRANSACTIONS)) {
+      printf("I2cPort: too many transactions to check\n");
+      isOk = false;
+   }
+   for (int i=0; isOk && (i < bus.getCount()); ++i) {
+      EmulatorBus::Transaction const & transaction = bus.get(i);
+      I2cBus::PRIORITY expected = BMP280_PRIORITY;
+      if (transaction.address == EmulatorBus::BMP280_ADDR) {
+         ++bmpCount;
+      }else {
+         if (!transaction.isRead) {
+            switch (transaction.command) {
+            case 0x2008:               // iaq_measure (datasheet, table 9)
+               commandPriority = I2cBus::PRIORITY_HIGH;
+               ++counts[0][0];
+               break;
+            case 0x2032:               // measure_test
+               commandPriority = I2cBus::PRIORITY_LOW;
+               ++counts[1][0];
+               break;
+            default:
+               commandPriority = SGP30_PRIORITY;
+               break;
+            }
+         }else if (commandPriority == I2cBus::PRIORITY_HIGH) {
+            ++counts[0][1];
+         }else if (commandPriority == I2cBus::PRIORITY_LOW) {
+            ++counts[1][1];
+         }
+         expected = commandPriority;
+      }
+      if (transaction.priority != expected) {
+         printf(
+            "I2cPort: %s of 0x%04x at 0x%02x had priority %d, expected %d\n",
+            transaction.isRead? "read" : "write", transaction.command,
+            transaction.address, transaction.priority, expected
+         );
+         isOk = false;
+      }
+   }
+   if (
+      isOk && (
+         (counts[0][0] != 2) || (counts[0][1] != 2) ||
+         (counts[1][0] != 1) || (counts[1][1] != 1) || (bmpCount == 0)
+      )
+   ) {
+      printf(
+         "I2cPort: measure air quality %d/%d, measure test %d/%d"
+         " (writes/reads), BMP280 %d\n",
+         counts[0][0], counts[0][1], counts[1][0], counts[1][1], bmpCount
+      );
+      isOk = false;
+   }
+   if (isOk) {
+      printf(
+         "I2cPort: %d transactions, measures at high and low priority, ok\n",
+         bus.getCount()
+      );
+   }
+   return isOk;
+}
+
+/*----------------------------------------------------------------------check-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+static bool check() {
+   bool isOk = true;
+   isOk = checkPorts() && isOk;
+   printf("%s\n", isOk? "All checks passed" : "CHECK FAILED");
+   return isOk;
+}
+/*===========================================================================*/
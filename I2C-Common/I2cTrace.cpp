@@ -0,0 +1,473 @@
+/*
+* Author:  agent
+* Written: 10/16/2026
+*
+* I2cTrace - Record the bus traffic of a driver, and replay it
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include "I2cTrace.h"
+
+char const I2cTrace::s_magic[8] = { 'I', '2', 'C', 'T', 'R', 'A', 'C', 'E' };
+
+/*STATIC--------------------------------------------------I2cTrace::putVarint-+
+| Returns the number of bytes stored in 'buf' (MAX_VARINT at most)            |
++----------------------------------------------------------------------------*/
+int I2cTrace::putVarint(unsigned char * buf, unsigned long long value) {
+   int len = 0;
+   while (value >= 0x80) {
+      buf[len++] = (unsigned char)(value | 0x80);
+      value >>= 7;
+   }
+   buf[len++] = (unsigned char)value;
+   return len;
+}
+
+/*STATIC--------------------------------------------------I2cTrace::getVarint-+
+| Returns the byte after the varint, or 0 if it is truncated or too long.     |
++----------------------------------------------------------------------------*/
+unsigned char const * I2cTrace::getVarint(
+   unsigned char const * cp,
+   unsigned char const * end,
+   unsigned long long & value
+) {
+   value = 0;
+   for (int shift=0; (cp < end) && (shift < 64); shift += 7) {
+      unsigned char byte = *cp++;
+      value |= (unsigned long long)(byte & 0x7F) << shift;
+      if (!(byte & 0x80)) return cp;
+   }
+   return 0;
+}
+
+/*STATIC--------------------------------------------------------I2cTrace::now-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+long long I2cTrace::now() {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (ts.tv_sec * 1000000LL) + (ts.tv_nsec / 1000);
+}
+
+/*STATIC-------------------------------------------------I2cTrace::sleepUntil-+
+| deadline: CLOCK_MONOTONIC, in microseconds                                  |
++----------------------------------------------------------------------------*/
+void I2cTrace::sleepUntil(long long deadline) {
+   struct timespec ts;
+   ts.tv_sec = deadline / 1000000;
+   ts.tv_nsec = (deadline % 1000000) * 1000;
+   while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, 0) == EINTR) {}
+}
+
+/*-----------------------------------------------I2cTrace::Recorder::Recorder-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+I2cTrace::Recorder::Recorder(char const * path, KIND kind, bool isSpi) :
+m_file(fopen(path, "wb")),
+m_lastStamp(now()),
+m_records(0)
+{
+   unsigned char header[HEADER_SIZE] = {};
+
+   memcpy(header, s_magic, sizeof s_magic);
+   header[8] = VERSION;
+   header[9] = (unsigned char)kind;
+   header[10] = isSpi? FLAG_SPI : 0;
+   if (!m_file) {
+      printf("Can't open %s\n", path);
+   }else {
+      setvbuf(m_file, 0, _IOFBF, 1 << 16);
+      if (fwrite(header, 1, sizeof header, m_file) != sizeof header) {
+         printf("Can't write %s\n", path);
+         fclose(m_file);
+         m_file = 0;
+      }
+   }
+}
+
+/*----------------------------------------------I2cTrace::Recorder::~Recorder-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+I2cTrace::Recorder::~Recorder() {
+   if (m_file) { fclose(m_file); m_file = 0; }
+}
+
+/*--------------------------------------------------I2cTrace::Recorder::flush-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+bool I2cTrace::Recorder::flush() {
+   return m_file && (fflush(m_file) == 0);
+}
+
+/*--------------------------------------------I2cTrace::Recorder::recordSleep-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+void I2cTrace::Recorder::recordSleep(long long stamp, unsigned long duration) {
+   unsigned char fields[MAX_VARINT];
+   put(OP_SLEEP, true, stamp, fields, putVarint(fields, duration), 0, 0);
+}
+
+/*--------------------------------------------I2cTrace::Recorder::recordWrite-+
+| The bytes written are always recorded: the Player checks them.              |
++----------------------------------------------------------------------------*/
+void I2cTrace::Recorder::recordWrite(
+   long long stamp,
+   void const * buf,
+   int len,
+   bool isOk
+) {
+   unsigned char fields[MAX_VARINT];
+   if (len < 0) len = 0;
+   put(OP_WRITE, isOk, stamp, fields, putVarint(fields, len), buf, len);
+}
+
+/*---------------------------------------------I2cTrace::Recorder::recordRead-+
+| The bytes read are only recorded if the read succeeded.                     |
++----------------------------------------------------------------------------*/
+void I2cTrace::Recorder::recordRead(
+   long long stamp,
+   void const * buf,
+   int len,
+   bool isOk
+) {
+   unsigned char fields[MAX_VARINT];
+   if (len < 0) len = 0;
+   put(
+      OP_READ, isOk, stamp, fields, putVarint(fields, len),
+      isOk? buf : 0, len
+   );
+}
+
+/*------------------------------------------I2cTrace::Recorder::recordReadReg-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+void I2cTrace::Recorder::recordReadReg(
+   long long stamp,
+   unsigned char reg,
+   void const * buf,
+   int len,
+   bool isOk
+) {
+   unsigned char fields[1 + MAX_VARINT];
+   if (len < 0) len = 0;
+   fields[0] = reg;
+   put(
+      OP_READ_REG, isOk, stamp, fields, 1 + putVarint(fields + 1, len),
+      isOk? buf : 0, len
+   );
+}
+
+/*----------------------------------------------------I2cTrace::Recorder::put-+
+| At the first write error, the recording stops (isOk() returns false.)       |
++----------------------------------------------------------------------------*/
+void I2cTrace::Recorder::put(
+   OP op,
+   bool isOk,
+   long long stamp,
+   unsigned char const * fields,
+   int fieldsLen,
+   void const * buf,
+   int len
+) {
+   unsigned char head[1 + MAX_VARINT];
+   int headLen;
+
+   if (!m_file) return;
+   head[0] = (unsigned char)(op | (isOk? OK_BIT : 0));
+   headLen = 1 + putVarint(
+      head + 1, (stamp > m_lastStamp)? stamp - m_lastStamp : 0
+   );
+   m_lastStamp = stamp;
+   if (
+      (fwrite(head, 1, headLen, m_file) != (size_t)headLen) ||
+      (fwrite(fields, 1, fieldsLen, m_file) != (size_t)fieldsLen) ||
+      (buf && len && (fwrite(buf, 1, len, m_file) != (size_t)len))
+   ) {
+      printf("Can't write the trace: recording stopped\n");
+      fclose(m_file);
+      m_file = 0;
+   }else {
+      ++m_records;
+   }
+}
+
+/*---------------------------------------------------I2cTrace::Player::Player-+
+| The whole trace is loaded in memory.                                        |
++----------------------------------------------------------------------------*/
+I2cTrace::Player::Player(char const * path, KIND kind, MODE mode) :
+m_trace(0),
+m_end(0),
+m_cursor(0),
+m_mode(mode),
+m_isSpi(false),
+m_isDiverged(false),
+m_stamp(0),
+m_origin(0),
+m_records(0)
+{
+   FILE * file = fopen(path, "rb");
+   long size = -1;
+
+   if (!file) {
+      printf("Can't open %s\n", path);
+      return;
+   }
+   if (fseek(file, 0, SEEK_END) == 0) size = ftell(file);
+   if ((size >= HEADER_SIZE) && (fseek(file, 0, SEEK_SET) == 0)) {
+      m_trace = (unsigned char *)malloc(size);
+      if (m_trace && (fread(m_trace, 1, size, file) != (size_t)size)) {
+         free(m_trace);
+         m_trace = 0;
+      }
+   }
+   fclose(file);
+   if (
+      !m_trace || memcmp(m_trace, s_magic, sizeof s_magic) ||
+      (m_trace[8] != VERSION) || (m_trace[9] != (unsigned char)kind)
+   ) {
+      printf("%s is not a valid trace\n", path);
+      free(m_trace);
+      m_trace = 0;
+   }else {
+      m_isSpi = (m_trace[10] & FLAG_SPI) != 0;
+      m_end = m_trace + size;
+      rewind();
+   }
+}
+
+/*--------------------------------------------------I2cTrace::Player::~Player-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+I2cTrace::Player::~Player() {
+   free(m_trace);
+}
+
+/*---------------------------------------------------I2cTrace::Player::rewind-+
+| Replay again, from the first record                                         |
++----------------------------------------------------------------------------*/
+void I2cTrace::Player::rewind() {
+   m_cursor = m_trace? m_trace + HEADER_SIZE : 0;
+   m_isDiverged = false;
+   m_stamp = 0;
+   m_records = 0;
+}
+
+/*---------------------------------------------------I2cTrace::Player::expect-+
+| Get the next record, which must be an 'op' operation.                       |
++----------------------------------------------------------------------------*/
+bool I2cTrace::Player::expect(OP op, Record & record) {
+   if (m_isDiverged) {
+      return false;
+   }else if (!next(record) || (record.op != op)) {
+      return diverge();
+   }else {
+      return true;
+   }
+}
+
+/*--------------------------------------------------I2cTrace::Player::diverge-+
+| Stop the replay.  Always returns false.                                     |
++----------------------------------------------------------------------------*/
+bool I2cTrace::Player::diverge() {
+   if (!m_isDiverged) {
+      m_isDiverged = true;
+      printf("Replay diverges at record %llu\n", m_records);
+   }
+   return false;
+}
+
+/*----------------------------------------------I2cTrace::Player::replaySleep-+
+| At full speed, does not sleep.  In real time, the next record waits.        |
++----------------------------------------------------------------------------*/
+void I2cTrace::Player::replaySleep(unsigned long duration) {
+   Record record;
+   if (expect(OP_SLEEP, record) && (record.value != duration)) {
+      diverge();
+   }
+}
+
+/*----------------------------------------------I2cTrace::Player::replayWrite-+
+| The bytes written must be those recorded.                                   |
++----------------------------------------------------------------------------*/
+bool I2cTrace::Player::replayWrite(void const * buf, int len) {
+   Record record;
+   if (!expect(OP_WRITE, record)) {
+      return false;
+   }else if (
+      (record.value != (unsigned long long)len) ||
+      memcmp(record.data, buf, len)
+   ) {
+      return diverge();
+   }else {
+      return record.isOk;
+   }
+}
+
+/*-----------------------------------------------I2cTrace::Player::replayRead-+
+| OP_READ, or OP_READ_REG: the register must then be the one recorded.        |
++----------------------------------------------------------------------------*/
+bool I2cTrace::Player::replayRead(
+   OP op,
+   unsigned char reg,
+   void * buf,
+   int len
+) {
+   Record record;
+   if (!expect(op, record)) {
+      return false;
+   }else if (
+      ((op == OP_READ_REG) && (record.reg != reg)) ||
+      (record.value != (unsigned long long)len)
+   ) {
+      return diverge();
+   }else {
+      if (record.isOk) memcpy(buf, record.data, len);
+      return record.isOk;
+   }
+}
+
+/*-----------------------------------------------------I2cTrace::Player::next-+
+| Decode the record at the cursor.  In real time, wait until its time: the    |
+| first record sets the origin.                                               |
++----------------------------------------------------------------------------*/
+bool I2cTrace::Player::next(Record & record) {
+   unsigned char const * cp = m_cursor;
+   unsigned long long delta;
+
+   if (!cp || (cp == m_end)) return false;
+   record.op = (OP)(*cp & ~OK_BIT);
+   record.isOk = (*cp++ & OK_BIT) != 0;
+   record.reg = 0;
+   record.data = 0;
+   if ((cp = getVarint(cp, m_end, delta)) == 0) return false;
+   if (record.op == OP_READ_REG) {
+      if (cp == m_end) return false;
+      record.reg = *cp++;
+   }
+   if ((cp = getVarint(cp, m_end, record.value)) == 0) return false;
+   switch (record.op) {
+   case OP_SLEEP:
+      break;
+   case OP_READ:
+   case OP_READ_REG:
+      if (!record.isOk) break;
+      // fall through
+   case OP_WRITE:
+      if (record.value > (unsigned long long)(m_end - cp)) return false;
+      record.data = cp;
+      cp += record.value;
+      break;
+   default:
+      return false;
+   }
+   m_cursor = cp;
+   m_stamp += delta;
+   if (m_records++ == 0) {
+      m_origin = now() - m_stamp;
+   }else if (m_mode == MODE_REAL_TIME) {
+      sleepUntil(m_origin + m_stamp);
+   }
+   return true;
+}
+
+/*-----------------------------------I2cTrace::Bmp280Recorder::Bmp280Recorder-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+I2cTrace::Bmp280Recorder::Bmp280Recorder(
+   Bmp280Device::Interface & inner,
+   char const * path
+) :
+Recorder(path, KIND_BMP280, inner.isSpi()),
+m_inner(inner)
+{}
+
+/*--------------------------------------------I2cTrace::Bmp280Recorder::sleep-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+void I2cTrace::Bmp280Recorder::sleep(int ms) {
+   long long stamp = now();
+   m_inner.sleep(ms);
+   recordSleep(stamp, ms);
+}
+
+/*--------------------------------------------I2cTrace::Bmp280Recorder::write-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+bool I2cTrace::Bmp280Recorder::write(void const * buf, int len) {
+   long long stamp = now();
+   bool isOk = m_inner.write(buf, len);
+   recordWrite(stamp, buf, len, isOk);
+   return isOk;
+}
+
+/*------------------------------------------I2cTrace::Bmp280Recorder::readReg-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+bool I2cTrace::Bmp280Recorder::readReg(
+   unsigned char reg,
+   void * buf,
+   int len
+) {
+   long long stamp = now();
+   bool isOk = m_inner.readReg(reg, buf, len);
+   recordReadReg(stamp, reg, buf, len, isOk);
+   return isOk;
+}
+
+/*-------------------------------------I2cTrace::Sgp30Recorder::Sgp30Recorder-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+I2cTrace::Sgp30Recorder::Sgp30Recorder(
+   Sgp30Device::Interface & inner,
+   char const * path
+) :
+Recorder(path, KIND_SGP30, false),
+m_inner(inner)
+{}
+
+/*---------------------------------------------I2cTrace::Sgp30Recorder::sleep-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+void I2cTrace::Sgp30Recorder::sleep(int us) {
+   long long stamp = now();
+   m_inner.sleep(us);
+   recordSleep(stamp, us);
+}
+
+/*---------------------------------------------I2cTrace::Sgp30Recorder::write-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+bool I2cTrace::Sgp30Recorder::write(void const * buf, int len) {
+   long long stamp = now();
+   bool isOk = m_inner.write(buf, len);
+   recordWrite(stamp, buf, len, isOk);
+   return isOk;
+}
+
+/*----------------------------------------------I2cTrace::Sgp30Recorder::read-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+bool I2cTrace::Sgp30Recorder::read(void * buf, int len) {
+   long long stamp = now();
+   bool isOk = m_inner.read(buf, len);
+   recordRead(stamp, buf, len, isOk);
+   return isOk;
+}
+
+/*---------------------------------------I2cTrace::Bmp280Player::Bmp280Player-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+I2cTrace::Bmp280Player::Bmp280Player(char const * path, MODE mode) :
+Player(path, KIND_BMP280, mode)
+{}
+
+/*-----------------------------------------I2cTrace::Sgp30Player::Sgp30Player-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+I2cTrace::Sgp30Player::Sgp30Player(char const * path, MODE mode) :
+Player(path, KIND_SGP30, mode)
+{}
+/*===========================================================================*/
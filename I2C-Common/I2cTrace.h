@@ -0,0 +1,265 @@
+/*
+* Author:  agent
+* Written: 10/16/2026
+*
+* I2cTrace - Record the bus traffic of a driver, and replay it
+*
+* A Recorder is put between a driver and its Interface: each sleep, write,
+* read or readReg is forwarded, then appended to a compact binary trace,
+* with its time stamp, its result and its bytes.
+* A Player realizes the same Interface from a trace: the recorded answers
+* are fed back, in order, either at full speed (the sleeps return at once)
+* or in real time (each call returns at its recorded time.)  The calls of
+* the driver are checked against the trace: at the first difference, the
+* replay stops (isDiverged) and all the following calls fail.
+*
+* Trace format: a 16-byte header ("I2CTRACE", version, kind, flags), then
+* one record per call:
+* - a byte: the operation, bit 7 set if the call succeeded;
+* - the microseconds elapsed since the previous record (varint);
+* - SLEEP: the duration, as given to sleep() (varint);
+* - WRITE: the length (varint) and the bytes written;
+* - READ: the length (varint) and, if successful, the bytes read;
+* - READ_REG: the register, then as READ.
+* Varints are LEB128: 7 bits per byte, least significant first.
+*
+* The Recorder and the Player are not thread-safe: one per device.
+*/
+#ifndef _I2C_TRACE_H_
+#define _I2C_TRACE_H_
+
+#include <stdio.h>
+#include "Bmp280Device.h"
+#include "Sgp30Device.h"
+
+class I2cTrace {
+public:
+   enum KIND {
+      KIND_BMP280 = 'B',
+      KIND_SGP30 = 'S'
+   };
+   enum OP {
+      OP_SLEEP = 1,
+      OP_WRITE = 2,
+      OP_READ = 3,
+      OP_READ_REG = 4
+   };
+   enum MODE {
+      MODE_FULL_SPEED,
+      MODE_REAL_TIME
+   };
+   class Recorder;
+   class Player;
+   class Bmp280Recorder;
+   class Sgp30Recorder;
+   class Bmp280Player;
+   class Sgp30Player;
+
+private:
+   enum {
+      HEADER_SIZE = 16,
+      VERSION = 1,
+      FLAG_SPI = 0x01,
+      OK_BIT = 0x80,
+      MAX_VARINT = 10              // bytes, for 64 bits
+   };
+   static char const s_magic[8];
+
+   static int putVarint(unsigned char * buf, unsigned long long value);
+   static unsigned char const * getVarint(
+      unsigned char const * cp, unsigned char const * end,
+      unsigned long long & value
+   );
+   static long long now();         // CLOCK_MONOTONIC, in microseconds
+   static void sleepUntil(long long deadline);
+};
+
+/*---------------------------------------------------class I2cTrace::Recorder-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+class I2cTrace::Recorder {
+public:
+   Recorder(char const * path, KIND kind, bool isSpi);
+   ~Recorder();
+   bool isOk() const;
+   bool flush();
+   unsigned long long getRecords() const;
+
+protected:
+   void recordSleep(long long stamp, unsigned long duration);
+   void recordWrite(long long stamp, void const * buf, int len, bool isOk);
+   void recordRead(long long stamp, void const * buf, int len, bool isOk);
+   void recordReadReg(
+      long long stamp, unsigned char reg, void const * buf, int len,
+      bool isOk
+   );
+
+private:
+   FILE * m_file;
+   long long m_lastStamp;
+   unsigned long long m_records;
+
+   void put(
+      OP op, bool isOk, long long stamp,
+      unsigned char const * fields, int fieldsLen,
+      void const * buf, int len
+   );
+
+   Recorder(Recorder const &);     // no copy
+   Recorder & operator=(Recorder const &);
+};
+
+/*-----------------------------------------------------class I2cTrace::Player-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+class I2cTrace::Player {
+public:
+   Player(char const * path, KIND kind, MODE mode = MODE_FULL_SPEED);
+   ~Player();
+   bool isOk() const;
+   bool isSpi() const;
+   bool isDone() const;            // all the records were replayed
+   bool isDiverged() const;        // the driver did not behave as recorded
+   unsigned long long getRecords() const;  // replayed so far
+   void rewind();
+
+protected:
+   struct Record {
+      OP op;
+      bool isOk;
+      unsigned char reg;           // OP_READ_REG
+      unsigned long long value;    // length, or duration (OP_SLEEP)
+      unsigned char const * data;  // 0 if none
+   };
+   bool expect(OP op, Record & record);
+   bool diverge();
+
+   // the driver calls, checked against the trace
+   void replaySleep(unsigned long duration);
+   bool replayWrite(void const * buf, int len);
+   bool replayRead(OP op, unsigned char reg, void * buf, int len);
+
+private:
+   unsigned char * m_trace;
+   unsigned char const * m_end;
+   unsigned char const * m_cursor;
+   MODE const m_mode;
+   bool m_isSpi;
+   bool m_isDiverged;
+   long long m_stamp;              // of the current record, trace time
+   long long m_origin;             // replay time of the trace time 0
+   unsigned long long m_records;
+
+   bool next(Record & record);
+
+   Player(Player const &);         // no copy
+   Player & operator=(Player const &);
+};
+
+/*---------------------------------------------class I2cTrace::Bmp280Recorder-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+class I2cTrace::Bmp280Recorder :
+   public Recorder, public Bmp280Device::Interface {
+public:
+   Bmp280Recorder(Bmp280Device::Interface & inner, char const * path);
+   bool isSpi() const;
+   void sleep(int ms);
+   bool write(void const * buf, int len);
+   bool readReg(unsigned char reg, void * buf, int len);
+private:
+   Bmp280Device::Interface & m_inner;
+};
+
+/*----------------------------------------------class I2cTrace::Sgp30Recorder-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+class I2cTrace::Sgp30Recorder :
+   public Recorder, public Sgp30Device::Interface {
+public:
+   Sgp30Recorder(Sgp30Device::Interface & inner, char const * path);
+   void sleep(int us);
+   bool write(void const * buf, int len);
+   bool read(void * buf, int len);
+private:
+   Sgp30Device::Interface & m_inner;
+};
+
+/*-----------------------------------------------class I2cTrace::Bmp280Player-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+class I2cTrace::Bmp280Player : public Player, public Bmp280Device::Interface {
+public:
+   Bmp280Player(char const * path, MODE mode = MODE_FULL_SPEED);
+   bool isSpi() const;
+   void sleep(int ms);
+   bool write(void const * buf, int len);
+   bool readReg(unsigned char reg, void * buf, int len);
+};
+
+/*------------------------------------------------class I2cTrace::Sgp30Player-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+class I2cTrace::Sgp30Player : public Player, public Sgp30Device::Interface {
+public:
+   Sgp30Player(char const * path, MODE mode = MODE_FULL_SPEED);
+   void sleep(int us);
+   bool write(void const * buf, int len);
+   bool read(void * buf, int len);
+};
+
+/*--------+
+| INLINES |
++--------*/
+inline bool I2cTrace::Recorder::isOk() const {
+   return m_file != 0;
+}
+inline unsigned long long I2cTrace::Recorder::getRecords() const {
+   return m_records;
+}
+inline bool I2cTrace::Player::isOk() const {
+   return m_trace != 0;
+}
+inline bool I2cTrace::Player::isSpi() const {
+   return m_isSpi;
+}
+inline bool I2cTrace::Player::isDone() const {
+   return m_cursor == m_end;
+}
+inline bool I2cTrace::Player::isDiverged() const {
+   return m_isDiverged;
+}
+inline unsigned long long I2cTrace::Player::getRecords() const {
+   return m_records;
+}
+inline bool I2cTrace::Bmp280Recorder::isSpi() const {
+   return m_inner.isSpi();
+}
+inline bool I2cTrace::Bmp280Player::isSpi() const {
+   return Player::isSpi();
+}
+inline void I2cTrace::Bmp280Player::sleep(int ms) {
+   replaySleep(ms);
+}
+inline bool I2cTrace::Bmp280Player::write(void const * buf, int len) {
+   return replayWrite(buf, len);
+}
+inline bool I2cTrace::Bmp280Player::readReg(
+   unsigned char reg,
+   void * buf,
+   int len
+) {
+   return replayRead(OP_READ_REG, reg, buf, len);
+}
+inline void I2cTrace::Sgp30Player::sleep(int us) {
+   replaySleep(us);
+}
+inline bool I2cTrace::Sgp30Player::write(void const * buf, int len) {
+   return replayWrite(buf, len);
+}
+inline bool I2cTrace::Sgp30Player::read(void * buf, int len) {
+   return replayRead(OP_READ, 0, buf, len);
+}
+
+#endif
+/*===========================================================================*/
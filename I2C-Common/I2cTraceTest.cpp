@@ -0,0 +1,227 @@
+/*
+* Author:  agent
+* Written: 10/16/2026
+*
+* Checks of I2cTrace, without any hardware: a session of each driver with
+* its emulator is recorded, then replayed.  "I2cTraceTest" exits with 1 on
+* failure.
+*
+* Compile with:
+* g++ -O2 -Wall -std=c++0x -I. -I../Bosch-BMP280 -I../Sensirion-SGP30
+*  I2cTrace.cpp I2cTraceTest.cpp
+*  ../Bosch-BMP280/Bmp280Device.cpp ../Bosch-BMP280/Bmp280Calibration.cpp
+*  ../Bosch-BMP280/Bmp280Capture.cpp ../Bosch-BMP280/Bmp280Emulator.cpp
+*  ../Sensirion-SGP30/Sgp30Device.cpp ../Sensirion-SGP30/Sgp30Features.cpp
+*  ../Sensirion-SGP30/Sgp30Crc.cpp ../Sensirion-SGP30/Sgp30Latency.cpp
+*  ../Sensirion-SGP30/Sgp30Humidity.cpp ../Sensirion-SGP30/Sgp30Emulator.cpp
+*  -o I2cTraceTest
+*/
+#include <stdio.h>
+#include <unistd.h>
+#include "I2cTrace.h"
+#include "Bmp280Emulator.h"
+#include "Sgp30Emulator.h"
+
+static bool check();
+
+int main(int argc, char const * const * argv)
+{
+   (void)argc;
+   (void)argv;
+   return check()? 0 : 1;
+}
+
+enum { BMP280_READS = 8 };
+
+/*------------------------------------------------------------------runBmp280-+
+| The session recorded and replayed: FORCED mode reads, the environment       |
+| changing in between.  'isChanged' sets another pressure oversampling.       |
+| Returns the number of successful reads.                                     |
++----------------------------------------------------------------------------*/
+static int runBmp280(
+   Bmp280Device::Interface & interface,
+   Bmp280Emulator * emulator,      // 0 on replay
+   double * values,                // [2 * BMP280_READS]
+   bool isChanged = false
+) {
+   Bmp280Device device(interface);
+   int reads = 0;
+
+   if (!device.isOperational()) return 0;
+   device.setMode(Bmp280Device::VAL_MODE_FORCED);
+   if (isChanged) device.setOversampPress(Bmp280Device::VAL_OVERSAMP_16X);
+   for (int i=0; i < BMP280_READS; ++i) {
+      if (emulator) emulator->setEnvironment(100000.0 + 50 * i, 20.0 + i);
+      if (device.readValuesWhenReady(values[2*i], values[2*i+1])) ++reads;
+   }
+   return reads;
+}
+
+/*----------------------------------------------------------------checkBmp280-+
+| Replayed at full speed, the trace gives the values the emulator gave, and   |
+| is consumed to its end.  With an option changed, the driver writes what     |
+| was not recorded: the replay diverges.                                      |
++----------------------------------------------------------------------------*/
+static bool checkBmp280(char const * path) {
+   double recorded[2 * BMP280_READS];
+   double replayed[2 * BMP280_READS];
+   int records = 0;
+   int sames = 0;
+   bool isOk = true;
+   {
+      Bmp280Emulator emulator;
+      I2cTrace::Bmp280Recorder recorder(emulator, path);
+      if (
+         !recorder.isOk() ||
+         (runBmp280(recorder, &emulator, recorded) != BMP280_READS) ||
+         !recorder.flush()
+      ) {
+         printf("Trace: can't record the BMP280 session\n");
+         return false;
+      }
+      records = (int)recorder.getRecords();
+   }
+   {
+      I2cTrace::Bmp280Player player(path);
+      int reads = runBmp280(player, 0, replayed);
+      for (int i=0; i < 2 * BMP280_READS; ++i) {
+         if (replayed[i] == recorded[i]) ++sames;
+      }
+      if (
+         (reads != BMP280_READS) || (sames != 2 * BMP280_READS) ||
+         !player.isDone() || player.isDiverged() ||
+         (player.getRecords() != (unsigned long long)records)
+      ) {
+         printf(
+            "Trace: BMP280 replay, %d read(s), %d same value(s), "
+            "%llu/%d record(s)%s%s\n",
+            reads, sames, player.getRecords(), records,
+            player.isDone()? "" : ", not done",
+            player.isDiverged()? ", diverged" : ""
+         );
+         isOk = false;
+      }
+   }
+   {
+      I2cTrace::Bmp280Player player(path);
+      runBmp280(player, 0, replayed, true);
+      if (!player.isDiverged()) {
+         printf("Trace: BMP280 replay, another option did not diverge\n");
+         isOk = false;
+      }
+   }
+   if (isOk) {
+      printf(
+         "Trace: BMP280, %d records replayed to the same %d values, ok\n",
+         records, 2 * BMP280_READS
+      );
+   }
+   return isOk;
+}
+
+enum { SGP30_MEASURES = 4, SGP30_VALUES = 4 * SGP30_MEASURES + 2 };
+
+/*-------------------------------------------------------------------runSgp30-+
+| The session recorded and replayed: air quality and raw signals, the air     |
+| changing in between, then the baseline.  'isChanged' sets a humidity.       |
+| Returns the number of successful measures.                                  |
++----------------------------------------------------------------------------*/
+static int runSgp30(
+   Sgp30Device::Interface & interface,
+   Sgp30Emulator * emulator,       // 0 on replay
+   unsigned short * values,        // [SGP30_VALUES]
+   bool isChanged = false
+) {
+   Sgp30Device device(interface);
+   int measures = 0;
+   int i;
+
+   if (!device.isOperational() || !device.initAirQuality()) return 0;
+   if (isChanged) device.setHumidityRaw(0x0B80);
+   for (i=0; i < SGP30_MEASURES; ++i) {
+      unsigned short * v = values + 4 * i;
+      interface.sleep(4000000);   // the last one past the warm-up
+      if (emulator) emulator->setAirQuality(400 + 10 * i, 20 * i);
+      if (device.measureAirQuality(v, v + 1)) ++measures;
+      if (device.measureRawSignals(v + 2, v + 3)) ++measures;
+   }
+   if (device.getBaseline(values + 4 * i, values + 4 * i + 1)) ++measures;
+   return measures;
+}
+
+/*-----------------------------------------------------------------checkSgp30-+
+| As checkBmp280: same values, isDone(), and a divergence when a humidity is  |
+| set, that was not in the recorded session.                                  |
++----------------------------------------------------------------------------*/
+static bool checkSgp30(char const * path) {
+   enum { MEASURES = 2 * SGP30_MEASURES + 1 };
+   unsigned short recorded[SGP30_VALUES];
+   unsigned short replayed[SGP30_VALUES];
+   int records = 0;
+   int sames = 0;
+   bool isOk = true;
+   {
+      Sgp30Emulator emulator;
+      I2cTrace::Sgp30Recorder recorder(emulator, path);
+      if (
+         !recorder.isOk() ||
+         (runSgp30(recorder, &emulator, recorded) != MEASURES) ||
+         !recorder.flush()
+      ) {
+         printf("Trace: can't record the SGP30 session\n");
+         return false;
+      }
+      records = (int)recorder.getRecords();
+   }
+   {
+      I2cTrace::Sgp30Player player(path);
+      int measures = runSgp30(player, 0, replayed);
+      for (int i=0; i < SGP30_VALUES; ++i) {
+         if (replayed[i] == recorded[i]) ++sames;
+      }
+      if (
+         (measures != MEASURES) || (sames != SGP30_VALUES) ||
+         !player.isDone() || player.isDiverged() ||
+         (player.getRecords() != (unsigned long long)records)
+      ) {
+         printf(
+            "Trace: SGP30 replay, %d measure(s), %d same value(s), "
+            "%llu/%d record(s)%s%s\n",
+            measures, sames, player.getRecords(), records,
+            player.isDone()? "" : ", not done",
+            player.isDiverged()? ", diverged" : ""
+         );
+         isOk = false;
+      }
+   }
+   {
+      I2cTrace::Sgp30Player player(path);
+      runSgp30(player, 0, replayed, true);
+      if (!player.isDiverged()) {
+         printf("Trace: SGP30 replay, a humidity set did not diverge\n");
+         isOk = false;
+      }
+   }
+   if (isOk) {
+      printf(
+         "Trace: SGP30, %d records replayed to the same %d values, ok\n",
+         records, SGP30_VALUES
+      );
+   }
+   return isOk;
+}
+
+/*----------------------------------------------------------------------check-+
+| The traces go to /tmp, and are removed.                                     |
++----------------------------------------------------------------------------*/
+static bool check() {
+   char path[64];
+   bool isOk = true;
+   snprintf(path, sizeof path, "/tmp/I2cTraceTest-%d.trace", (int)getpid());
+   isOk = checkBmp280(path) && isOk;
+   isOk = checkSgp30(path) && isOk;
+   unlink(path);
+   printf("%s\n", isOk? "All checks passed" : "CHECK FAILED");
+   return isOk;
+}
+/*===========================================================================*/
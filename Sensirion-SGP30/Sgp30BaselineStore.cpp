@@ -0,0 +1,116 @@
+/*
+* Author:  agent
+* Written: 10/16/2026
+*
+* SGP30 - Sensirion Multi-Pixel Gas Sensor - Baseline persistence
+*/
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include "Sgp30BaselineStore.h"
+
+/*
+| The file is a single line of text, so it can be checked by hand:
+|    sgp30 <serial id> <co2eq> <tvoc> <time stamp>
+*/
+static char const FORMAT[] = "sgp30 %012llx %hu %hu %lld\n";
+
+/*---------------------------------------------------Sgp30BaselineStore::load-+
+| Returns false if there is no baseline for this SGP30, or if it can't be     |
+| used anymore.                                                               |
++----------------------------------------------------------------------------*/
+bool Sgp30BaselineStore::load(
+   unsigned long long serialId,
+   unsigned short * co2eq,
+   unsigned short * tvoc,
+   time_t * stamp
+) const {
+   char path[1024];
+   unsigned long long id;
+   long long time;
+   char extra;
+   FILE * file;
+   int count;
+   bool isOk;
+
+   if (!makePath(path, sizeof path, serialId)) return false;
+   if ((file = fopen(path, "r")) == 0) return false;
+   count = fscanf(file, FORMAT, &id, co2eq, tvoc, &time);
+   isOk = (count == 4) && (fscanf(file, " %c", &extra) == EOF);
+   fclose(file);
+   if (!isOk || (id != serialId)) {
+      printf("Baseline %s discarded: malformed\n", path);
+      return false;
+   }
+   switch (getValidity((time_t)time, ::time(0))) {
+   case IN_FUTURE:
+      printf("Baseline %s discarded: dated in the future\n", path);
+      return false;
+   case EXPIRED:
+      printf("Baseline %s discarded: older than a week\n", path);
+      return false;
+   default:
+      *stamp = (time_t)time;
+      return true;
+   }
+}
+
+/*---------------------------------------------------Sgp30BaselineStore::save-+
+| Write a temporary file, then rename it: the store is never half written.    |
++----------------------------------------------------------------------------*/
+bool Sgp30BaselineStore::save(
+   unsigned long long serialId,
+   unsigned short co2eq,
+   unsigned short tvoc,
+   time_t stamp
+) const {
+   char path[1024];
+   char tmpPath[1024];
+   FILE * file;
+   bool isOk = false;
+
+   if (!makePath(path, sizeof path, serialId)) return false;
+   int tmpLen = snprintf(tmpPath, sizeof tmpPath, "%s.tmp", path);
+   if (tmpLen >= (int)sizeof tmpPath) return false;
+   if ((file = fopen(tmpPath, "w")) != 0) {
+      long long time = stamp;
+      isOk = (
+         (fprintf(file, FORMAT, serialId, co2eq, tvoc, time) > 0) &&
+         (fflush(file) == 0) &&
+         (fsync(fileno(file)) == 0)
+      );
+      isOk = (fclose(file) == 0) && isOk;
+   }
+   if (!isOk || (rename(tmpPath, path) != 0)) {
+      printf("Can't write the baseline %s\n", path);
+      remove(tmpPath);
+      return false;
+   }
+   return syncDirectory();
+}
+
+/*------------------------------------------Sgp30BaselineStore::syncDirectory-+
+| The rename is only durable once the directory itself is synced              |
++----------------------------------------------------------------------------*/
+bool Sgp30BaselineStore::syncDirectory() const {
+   int fd = open(m_directory, O_RDONLY | O_DIRECTORY);
+   bool isOk = (fd >= 0) && (fsync(fd) == 0);
+   if (fd >= 0) close(fd);
+   if (!isOk) printf("Can't sync the directory %s\n", m_directory);
+   return isOk;
+}
+
+/*-----------------------------------------------Sgp30BaselineStore::makePath-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+bool Sgp30BaselineStore::makePath(
+   char * path,
+   int size,
+   unsigned long long serialId
+) const {
+   return snprintf(
+      path, size, "%s/sgp30-%012llx.baseline", m_directory, serialId
+   ) < size;
+}
+
+/*===========================================================================*/
@@ -0,0 +1,67 @@
+/*
+* Author:  agent
+* Written: 10/16/2026
+*
+* SGP30 - Sensirion Multi-Pixel Gas Sensor - Baseline persistence
+*
+* One file per SGP30, named after its serial id, holds the last baseline
+* and its time stamp.  A baseline is valid one week (datasheet, v0.9, p8):
+* load() refuses older ones, and ones dated in the future.
+* save() writes a temporary file, syncs it, then renames it and syncs the
+* directory: the store is never half written, even on a power loss.
+*/
+#ifndef _SGP30_BASELINE_STORE_H_
+#define _SGP30_BASELINE_STORE_H_
+
+#include <time.h>
+
+class Sgp30BaselineStore {
+public:
+   enum VALIDITY {
+      VALID,
+      IN_FUTURE,
+      EXPIRED                      // older than a week
+   };
+   static long const VALIDITY_SECONDS = 604800;
+
+   Sgp30BaselineStore(char const * directory);   // not copied
+
+   bool load(
+      unsigned long long serialId,
+      unsigned short * co2eq,
+      unsigned short * tvoc,
+      time_t * stamp
+   ) const;
+   bool save(
+      unsigned long long serialId,
+      unsigned short co2eq,
+      unsigned short tvoc,
+      time_t stamp
+   ) const;
+
+   static VALIDITY getValidity(time_t stamp, time_t now);
+
+private:
+   char const * m_directory;
+
+   bool makePath(char * path, int size, unsigned long long serialId) const;
+   bool syncDirectory() const;
+};
+
+/*--------+
+| INLINES |
++--------*/
+inline Sgp30BaselineStore::Sgp30BaselineStore(char const * directory) :
+   m_directory(directory) {
+}
+inline Sgp30BaselineStore::VALIDITY Sgp30BaselineStore::getValidity(
+   time_t stamp,
+   time_t now
+) {
+   return
+      (stamp > now)? IN_FUTURE :
+      ((now - stamp) > VALIDITY_SECONDS)? EXPIRED :
+      VALID;
+}
+#endif
+/*===========================================================================*/
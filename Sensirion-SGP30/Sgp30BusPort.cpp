@@ -0,0 +1,67 @@
+/*
+* Author:  agent
+* Written: 10/16/2026
+*
+* SGP30 - Sgp30Device::Interface on a port of a shared I2cBus
+*/
+#include <unistd.h>
+#include <string.h>
+#include "Sgp30BusPort.h"
+
+/*-------------------------------------------------------------getWrittenCode-+
+| The code of a command, as Sgp30Device writes it (network byte order), from  |
+| the most complete feature set.  0 is no command.                            |
++----------------------------------------------------------------------------*/
+static unsigned short getWrittenCode(Sgp30Features::ID id) {
+   Sgp30Features::Command const * command = (
+      Sgp30Features::Set::makeSet(0x20)->getCommand(id)
+   );
+   return command? command->m_code : 0;
+}
+
+/*-------------------------------------------------Sgp30BusPort::Sgp30BusPort-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+Sgp30BusPort::Sgp30BusPort(
+   I2cBus & bus,
+   int i2cAddr,
+   I2cBus::PRIORITY priority
+) :
+Port(bus, i2cAddr, priority),
+m_highCode(getWrittenCode(Sgp30Features::MEASURE_AIR_QUALITY)),
+m_lowCode(getWrittenCode(Sgp30Features::MEASURE_TEST)),
+m_lastPriority(priority)
+{}
+
+/*--------------------------------------------------------Sgp30BusPort::sleep-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+void Sgp30BusPort::sleep(int us) {
+   usleep(us);
+}
+
+/*--------------------------------------------------------Sgp30BusPort::write-+
+| The command code is in the first 2 bytes (datasheet, v0.9, table 9)         |
++----------------------------------------------------------------------------*/
+bool Sgp30BusPort::write(void const * buf, int len) {
+   unsigned short code = 0;
+   if (len >= 2) memcpy(&code, buf, sizeof code);
+   if (code == 0) {
+      m_lastPriority = m_priority;
+   }else if (code == m_highCode) {
+      m_lastPriority = I2cBus::PRIORITY_HIGH;
+   }else if (code == m_lowCode) {
+      m_lastPriority = I2cBus::PRIORITY_LOW;
+   }else {
+      m_lastPriority = m_priority;
+   }
+   return send(buf, len, m_lastPriority);
+}
+
+/*---------------------------------------------------------Sgp30BusPort::read-+
+| The read of the results has the priority of the command                     |
++----------------------------------------------------------------------------*/
+bool Sgp30BusPort::read(void * buf, int len) {
+   return receive(buf, len, m_lastPriority);
+}
+/*===========================================================================*/
@@ -0,0 +1,37 @@
+/*
+* Author:  agent
+* Written: 10/16/2026
+*
+* SGP30 - Sgp30Device::Interface on a port of a shared I2cBus
+*
+* The priority follows the command: the 1 Hz "measure air quality" and its
+* read are high, "measure test" and its read are low, others are the port's.
+* The command codes are those of Sgp30Features.
+*
+* Compile with the I2C-Common directory on the include path, and link
+* with I2cBus.cpp and -pthread (see I2C-Common/README.md.)
+*/
+#ifndef _SGP30BUSPORT_H_
+#define _SGP30BUSPORT_H_
+
+#include "I2cBus.h"
+#include "Sgp30Device.h"
+
+class Sgp30BusPort : public I2cBus::Port, public Sgp30Device::Interface {
+public:
+   Sgp30BusPort(
+      I2cBus & bus,
+      int i2cAddr,
+      I2cBus::PRIORITY priority = I2cBus::PRIORITY_NORMAL
+   );
+   void sleep(int us);
+   bool write(void const * buf, int len);
+   bool read(void * buf, int len);
+private:
+   unsigned short const m_highCode;  // network byte order, as written
+   unsigned short const m_lowCode;
+   I2cBus::PRIORITY m_lastPriority;  // of the last command written
+};
+
+#endif
+/*===========================================================================*/
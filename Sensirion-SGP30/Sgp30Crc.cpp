@@ -0,0 +1,86 @@
+/*
+* Author:  agent
+* Written: 10/16/2026
+*
+* SGP30 - Sensirion Multi-Pixel Gas Sensor - CRC-8 of the data words
+*/
+#include "Sgp30Crc.h"
+
+/*STATIC--------------------------------------------------------------crcByte-+
+| CRC of a single byte, bit by bit: P(x)=x^8+x^5+x^4+1, hence 100110001       |
++----------------------------------------------------------------------------*/
+static constexpr unsigned char crcByte(unsigned char crc, int bits = 8) {
+   return (bits == 0)? crc : crcByte(
+      (crc & 0x80)?
+      (unsigned char)((crc << 1) ^ 0x31) : (unsigned char)(crc << 1),
+      bits - 1
+   );
+}
+
+#define CRC_1(i) crcByte(i)
+#define CRC_4(i) CRC_1(i), CRC_1(i+1), CRC_1(i+2), CRC_1(i+3)
+#define CRC_16(i) CRC_4(i), CRC_4(i+4), CRC_4(i+8), CRC_4(i+12)
+#define CRC_64(i) CRC_16(i), CRC_16(i+16), CRC_16(i+32), CRC_16(i+48)
+
+unsigned char const Sgp30Crc::s_table[256] = {
+   CRC_64(0), CRC_64(64), CRC_64(128), CRC_64(192)
+};
+
+/*---------------------------------------------------------Sgp30Crc::validate-+
+| Words are checked four at a time, the table lookups of different words      |
+| being independent.  The first bad word is then located one at a time.       |
++----------------------------------------------------------------------------*/
+int Sgp30Crc::validate(unsigned char const * words, int count) {
+   int i = 0;
+   for (; i+4 <= count; i += 4, words += 12) {
+      if (
+         (s_table[s_table[0xFF ^ words[0]] ^ words[1]] ^ words[2]) |
+         (s_table[s_table[0xFF ^ words[3]] ^ words[4]] ^ words[5]) |
+         (s_table[s_table[0xFF ^ words[6]] ^ words[7]] ^ words[8]) |
+         (s_table[s_table[0xFF ^ words[9]] ^ words[10]] ^ words[11])
+      ) {
+         break;
+      }
+   }
+   for (; i < count; ++i, words += 3) {
+      if (!isValid(words)) break;
+   }
+   return i;
+}
+
+/*---------------------------------------------------Sgp30Crc::computeBitwise-+
+| The former Sgp30Device checksum: the reference for the table, and for the   |
+| benchmark (see Sgp30Test bench.)                                            |
++----------------------------------------------------------------------------*/
+unsigned char Sgp30Crc::computeBitwise(unsigned char const * data, int n) {
+   unsigned short crc = 0xFF;
+   for (int i=0; i < n; ++i) {
+      crc ^= data[i];
+      for (int j=8; j > 0; --j) {
+         crc =  (crc & 0x80)? (crc<<1)^0x131 : (crc << 1);
+      }
+   }
+   return (unsigned char)crc;
+}
+
+/*--------------------------------------------------------Sgp30Crc::selfCheck-+
+| Table and bit by bit CRC of the 65536 words, and the datasheet example:     |
+| CRC(0xBEEF) = 0x92                                                          |
++----------------------------------------------------------------------------*/
+bool Sgp30Crc::selfCheck() {
+   static unsigned char const example[3] = { 0xBE, 0xEF, 0x92 };
+   if ((compute(example, 2) != 0x92) || !isValid(example)) {
+      return false;
+   }
+   for (int i=0; i < 0x10000; ++i) {
+      unsigned char word[3] = {
+         (unsigned char)(i >> 8), (unsigned char)i, 0
+      };
+      word[2] = computeBitwise(word, 2);
+      if ((compute(word, 2) != word[2]) || !isValid(word)) {
+         return false;
+      }
+   }
+   return true;
+}
+/*===========================================================================*/
@@ -0,0 +1,86 @@
+/*
+* Author:  agent
+* Written: 10/16/2026
+*
+* SGP30 - Sensirion Multi-Pixel Gas Sensor - CRC-8 of the data words
+*
+* Each 16-bit word is followed by its CRC-8: polynomial 0x31 (x^8+x^5+x^4+1),
+* initialized to 0xFF.  The CRC is table driven: the 256-entry table is
+* generated at compile time.  selfCheck() verifies it against the bit by
+* bit computation of the datasheet, for all the 16-bit words.
+*/
+#ifndef _SGP30_CRC_H_
+#define _SGP30_CRC_H_
+
+class Sgp30Crc {
+public:
+   static unsigned char compute(unsigned char const * data, int n);
+   // 'word' is 2 data bytes followed by their CRC
+   static bool isValid(unsigned char const * word);
+   // index of the first of 'count' words having a bad CRC, or 'count'
+   static int validate(unsigned char const * words, int count);
+   // check 'count' words, then byte-swap them into 'values' if all are valid
+   static bool decode(
+      unsigned char const * words, unsigned short * values, int count
+   );
+   // the same for 2 words, in a single pass, straight into their fields
+   static bool decode(
+      unsigned char const * words,
+      unsigned short & first,
+      unsigned short & second
+   );
+   // the same as compute(), bit by bit (datasheet, 6.6)
+   static unsigned char computeBitwise(unsigned char const * data, int n);
+   // true if the table agrees with computeBitwise
+   static bool selfCheck();
+private:
+   static unsigned char const s_table[256];
+};
+
+/*--------+
+| INLINES |
++--------*/
+inline unsigned char Sgp30Crc::compute(unsigned char const * data, int n) {
+   unsigned char crc = 0xFF;
+   for (int i=0; i < n; ++i) {
+      crc = s_table[crc ^ data[i]];
+   }
+   return crc;
+}
+inline bool Sgp30Crc::isValid(unsigned char const * word) {
+   return s_table[s_table[0xFF ^ word[0]] ^ word[1]] == word[2];
+}
+inline bool Sgp30Crc::decode(
+   unsigned char const * words,
+   unsigned short * values,
+   int count
+) {
+   unsigned char diff = 0;         // no branch per word
+   for (int i=0; i < count; ++i) {
+      unsigned char const * word = words + 3*i;
+      diff |= s_table[s_table[0xFF ^ word[0]] ^ word[1]] ^ word[2];
+   }
+   if (diff != 0) return false;    // 'values' left untouched
+   for (int i=0; i < count; ++i, words += 3) {
+      values[i] = (unsigned short)((words[0] << 8) | words[1]);
+   }
+   return true;
+}
+inline bool Sgp30Crc::decode(
+   unsigned char const * words,
+   unsigned short & first,
+   unsigned short & second
+) {
+   if (
+      (s_table[s_table[0xFF ^ words[0]] ^ words[1]] ^ words[2]) |
+      (s_table[s_table[0xFF ^ words[3]] ^ words[4]] ^ words[5])
+   ) {
+      return false;                // 'first' and 'second' left untouched
+   }
+   first = (unsigned short)((words[0] << 8) | words[1]);
+   second = (unsigned short)((words[3] << 8) | words[4]);
+   return true;
+}
+
+#endif
+/*===========================================================================*/
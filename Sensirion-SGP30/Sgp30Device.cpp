@@ -9,13 +9,47 @@
 
 #include <math.h>
 #include "Sgp30Device.h"
+#include "Sgp30Crc.h"
 
-static unsigned int checksum(unsigned char const * data, int n);
+/*------------------------------------------------- class Sgp30Device::Words -+
+| Decodes the values into an array of words                                   |
++----------------------------------------------------------------------------*/
+class Sgp30Device::Words {
+public:
+   Words(unsigned short * values) : m_values(values) {}
+   bool decode(unsigned char const * frame, int count) const {
+      return Sgp30Crc::decode(frame, m_values, count);
+   }
+private:
+   unsigned short * m_values;
+};
+
+/*-------------------------------------------------- class Sgp30Device::Pair -+
+| Decodes the two values, in a single pass, straight into the fields of the   |
+| caller's struct (AirQuality, RawSignals.)                                   |
++----------------------------------------------------------------------------*/
+class Sgp30Device::Pair {
+public:
+   Pair(unsigned short & first, unsigned short & second) :
+   m_first(first), m_second(second) {}
+   bool decode(unsigned char const * frame, int count) const {
+      return (count == 2) && Sgp30Crc::decode(frame, m_first, m_second);
+   }
+private:
+   unsigned short & m_first;
+   unsigned short & m_second;
+};
 
 /*---------------------------------------------------Sgp30Device::Sgp30Device-+
 |                                                                             |
 +----------------------------------------------------------------------------*/
-Sgp30Device::Sgp30Device(Interface & interface) : m_interface(interface) {
+Sgp30Device::Sgp30Device(Interface & interface) :
+m_interface(interface),
+m_runningCommand(0),
+m_featureSet(Sgp30Features::Set::makeDefaultSet()),
+m_latency(0),
+m_isOk(false)
+{
    init();
 }
 
@@ -23,20 +57,31 @@ Sgp30Device::Sgp30Device(Interface & interface) : m_interface(interface) {
 | For derived class for which the Interface's virtuals are still pure.        |
 | init() should be called immediately after the construct finishes.           |
 +----------------------------------------------------------------------------*/
-Sgp30Device::Sgp30Device(Interface * interface) : m_interface(*interface) {}
+Sgp30Device::Sgp30Device(Interface * interface) :
+m_interface(*interface),
+m_runningCommand(0),
+m_featureSet(Sgp30Features::Set::makeDefaultSet()),
+m_latency(0),
+m_isOk(false)
+{}
 
 /*PROTECTED-------------------------------------------------Sgp30Device::init-+
 |                                                                             |
 +----------------------------------------------------------------------------*/
 bool Sgp30Device::init() {
-   if (!run(Sgp30Features::GET_SERIAL_ID)) {
+   unsigned short words[3];
+   if (!run(Sgp30Features::GET_SERIAL_ID, Words(words))) {
       return false;
    }else {
-      m_id = (m_buffer[0] << 16) | (m_buffer[1] << 8) | m_buffer[2];
-      if (!run(Sgp30Features::GET_FEATURE_SET_VERSION)) {
+      m_id = (
+         ((unsigned long long)words[0] << 32) |
+         ((unsigned long long)words[1] << 16) |
+         words[2]
+      );
+      if (!run(Sgp30Features::GET_FEATURE_SET_VERSION, Words(words))) {
          return false;
       }else {
-         m_version = m_buffer[0];
+         m_version = words[0];
          m_featureSet = Sgp30Features::Set::makeSet(m_version);
          m_isOk = true;
          return true;
@@ -48,7 +93,16 @@ bool Sgp30Device::init() {
 | This resets the SGP30 baselines                                             |
 +----------------------------------------------------------------------------*/
 bool Sgp30Device::initAirQuality() {
-   return run(Sgp30Features::INIT_AIR_QUALITY);
+   return run(Sgp30Features::INIT_AIR_QUALITY, Words(0));
+}
+
+/*---------------------------------------------Sgp30Device::measureAirQuality-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+bool Sgp30Device::measureAirQuality(AirQuality & values) {
+   return run(
+      Sgp30Features::MEASURE_AIR_QUALITY, Pair(values.co2eq, values.tvoc)
+   );
 }
 
 /*---------------------------------------------Sgp30Device::measureAirQuality-+
@@ -58,11 +112,12 @@ bool Sgp30Device::measureAirQuality(
    unsigned short * co2eq,
    unsigned short * tvoc
 ) {
-   if (!run(Sgp30Features::MEASURE_AIR_QUALITY)) {
+   AirQuality values;
+   if (!measureAirQuality(values)) {
       return false;
    }else {
-      *co2eq = m_buffer[0];
-      *tvoc = m_buffer[1];
+      *co2eq = values.co2eq;
+      *tvoc = values.tvoc;
       return true;
    }
 }
@@ -74,6 +129,15 @@ bool Sgp30Device::measureAirQuality() {
    return (start(Sgp30Features::MEASURE_AIR_QUALITY) != 0);
 }
 
+/*-------------------------------------------------Sgp30Device::getAirQuality-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+bool Sgp30Device::getAirQuality(AirQuality & values) {
+   return getValues(
+      Sgp30Features::MEASURE_AIR_QUALITY, Pair(values.co2eq, values.tvoc)
+   );
+}
+
 /*-------------------------------------------------Sgp30Device::getAirQuality-+
 |                                                                             |
 +----------------------------------------------------------------------------*/
@@ -81,15 +145,25 @@ bool Sgp30Device::getAirQuality(
    unsigned short * co2eq,
    unsigned short * tvoc
 ) {
-   if (!getValues(Sgp30Features::MEASURE_AIR_QUALITY)) {
+   AirQuality values;
+   if (!getAirQuality(values)) {
       return false;
    }else {
-      *co2eq = m_buffer[0];
-      *tvoc = m_buffer[1];
+      *co2eq = values.co2eq;
+      *tvoc = values.tvoc;
       return true;
    }
 }
 
+/*---------------------------------------------Sgp30Device::measureRawSignals-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+bool Sgp30Device::measureRawSignals(RawSignals & values) {
+   return run(
+      Sgp30Features::MEASURE_RAW_SIGNALS, Pair(values.h2, values.ethanol)
+   );
+}
+
 /*---------------------------------------------Sgp30Device::measureRawSignals-+
 |                                                                             |
 +----------------------------------------------------------------------------*/
@@ -97,11 +171,12 @@ bool Sgp30Device::measureRawSignals(
    unsigned short * h2,
    unsigned short * ethanol
 ) {
-   if (!run(Sgp30Features::MEASURE_RAW_SIGNALS)) {
+   RawSignals values;
+   if (!measureRawSignals(values)) {
       return false;
    }else {
-      *h2 = m_buffer[0];
-      *ethanol = m_buffer[1];
+      *h2 = values.h2;
+      *ethanol = values.ethanol;
       return true;
    }
 }
@@ -113,6 +188,15 @@ bool Sgp30Device::measureRawSignals() {
    return (start(Sgp30Features::MEASURE_RAW_SIGNALS) != 0);
 }
 
+/*-------------------------------------------------Sgp30Device::getRawSignals-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+bool Sgp30Device::getRawSignals(RawSignals & values) {
+   return getValues(
+      Sgp30Features::MEASURE_RAW_SIGNALS, Pair(values.h2, values.ethanol)
+   );
+}
+
 /*-------------------------------------------------Sgp30Device::getRawSignals-+
 |                                                                             |
 +----------------------------------------------------------------------------*/
@@ -120,35 +204,61 @@ bool Sgp30Device::getRawSignals(
    unsigned short * h2,
    unsigned short * ethanol
 ) {
-   if (!getValues(Sgp30Features::MEASURE_RAW_SIGNALS)) {
+   RawSignals values;
+   if (!getRawSignals(values)) {
       return false;
    }else {
-      *h2 = m_buffer[0];
-      *ethanol = m_buffer[1];
+      *h2 = values.h2;
+      *ethanol = values.ethanol;
       return true;
    }
 }
+
 /*---------------------------------------------------Sgp30Device::measureTest-+
 |                                                                             |
 +----------------------------------------------------------------------------*/
 bool Sgp30Device::measureTest(unsigned short * result) {
-   if (!run(Sgp30Features::MEASURE_TEST)) {
-      return false;
-   }else {
-      *result = m_buffer[0];
-      return (*result == 0xd400);
-   }
+   return (
+      run(Sgp30Features::MEASURE_TEST, Words(result)) && (*result == 0xd400)
+   );
+}
+
+/*---------------------------------------------------Sgp30Device::measureTest-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+bool Sgp30Device::measureTest() {
+   return (start(Sgp30Features::MEASURE_TEST) != 0);
+}
+
+/*-------------------------------------------------------Sgp30Device::getTest-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+bool Sgp30Device::getTest(unsigned short * result) {
+   return (
+      getValues(Sgp30Features::MEASURE_TEST, Words(result)) &&
+      (*result == 0xd400)
+   );
 }
 
 /*---------------------------------------------------Sgp30Device::getBaseline-+
 | See Sensirion Datasheet, v0.9, p8: Airquality Signals                       |
 +----------------------------------------------------------------------------*/
+bool Sgp30Device::getBaseline(AirQuality & baseline) {
+   return run(
+      Sgp30Features::GET_BASELINE, Pair(baseline.co2eq, baseline.tvoc)
+   );
+}
+
+/*---------------------------------------------------Sgp30Device::getBaseline-+
+|                                                                             |
++----------------------------------------------------------------------------*/
 bool Sgp30Device::getBaseline(unsigned short * co2eq, unsigned short * tvoc) {
-   if (!run(Sgp30Features::GET_BASELINE)) {
+   AirQuality baseline;
+   if (!getBaseline(baseline)) {
       return false;
    }else {
-      *co2eq = m_buffer[0];
-      *tvoc = m_buffer[1];
+      *co2eq = baseline.co2eq;
+      *tvoc = baseline.tvoc;
       return true;
    }
 }
@@ -158,7 +268,7 @@ bool Sgp30Device::getBaseline(unsigned short * co2eq, unsigned short * tvoc) {
 +----------------------------------------------------------------------------*/
 bool Sgp30Device::setBaseline(unsigned short co2eq, unsigned short tvoc) {
    unsigned short const args[] = { tvoc, co2eq };
-   return run(Sgp30Features::SET_BASELINE, 2, args);
+   return run(Sgp30Features::SET_BASELINE, Words(0), 2, args);
 }
 
 /*---------------------------------------------------Sgp30Device::setHumidity-+
@@ -167,14 +277,20 @@ bool Sgp30Device::setBaseline(unsigned short co2eq, unsigned short tvoc) {
 +----------------------------------------------------------------------------*/
 bool Sgp30Device::setHumidity(unsigned long humidity) {
    if (humidity < 256000) {
-      humidity <<= 8;
-      humidity = (humidity/1000) | ((humidity % 1000)/1000);
-      return run(Sgp30Features::SET_HUMIDITY, 1, (unsigned short *)&humidity);
+      return setHumidityRaw((unsigned short)((humidity << 8) / 1000));
    }else {
       return false;
    }
 }
 
+/*------------------------------------------------Sgp30Device::setHumidityRaw-+
+| The humidity value is in g/m**3, as a 8.8 fixed point number (datasheet,    |
+| v0.9, table 11).  If zero, humidity compensation is disabled.               |
++----------------------------------------------------------------------------*/
+bool Sgp30Device::setHumidityRaw(unsigned short humidity) {
+   return run(Sgp30Features::SET_HUMIDITY, Words(0), 1, &humidity);
+}
+
 /*-------------------------------------------Sgp30Device::setRelativeHumidity-+
 | rh: percentage of relative humidity, t: temperature in Celsius degrees      |
 +----------------------------------------------------------------------------*/
@@ -196,15 +312,16 @@ Sgp30Features::Command const * Sgp30Device::start(
 ) {
    Sgp30Features::Command const * command = m_featureSet->getCommand(id);
    if (command) {
-      unsigned char *cp = (unsigned char *)(m_buffer + 1);
+      unsigned short buffer[8];    // large enough
+      unsigned char *cp = (unsigned char *)(buffer + 1);
       while (argc--) {
          *cp++ = *argv >> 8;
          *cp++ = *(argv++);
-         *cp = checksum(cp-2, 2);
+         *cp = Sgp30Crc::compute(cp-2, 2);
          ++cp;
       }
-      m_buffer[0] = command->m_code; // already in network byte order
-      if (m_interface.write(m_buffer, cp-(unsigned char *)m_buffer)) {
+      buffer[0] = command->m_code; // already in network byte order
+      if (m_interface.write(buffer, cp-(unsigned char *)buffer)) {
          m_runningCommand = command;
          return command;
       }
@@ -213,67 +330,78 @@ Sgp30Features::Command const * Sgp30Device::start(
 }
 
 /*-----------------------------------------------------Sgp30Device::getValues-+
-| Get the values of the last issued command                                   |
+| Get the values of the last issued command.                                  |
+| The frame is read on the stack, then decoded by 'output' (see Words, Pair): |
+| the values are not modified on a bad CRC.                                   |
 +----------------------------------------------------------------------------*/
-bool Sgp30Device::getValues(Sgp30Features::ID id) {
-   bool isOk = false;
-   if (m_runningCommand && (m_runningCommand->m_id == id)) {
-      Sgp30Features::Command const * command = m_runningCommand;
-      unsigned short size = command->m_valuesCount * 3;
-      if (!size) {
-         m_runningCommand = 0;
-         isOk = true;
-      }else {
-         unsigned char * data = (unsigned char *)m_buffer;
-         if (m_interface.read(data, size)) {
-            m_runningCommand = 0;
-            for (int i=0, j=0; ; i += 3, j += 2) {
-               if (i == size) {
-                  command->convertValues(m_buffer);
-                  isOk = true;
-                  break;
-               }else if (data[i+2] != checksum(data+i, 2)) {
-                  break;
-               }else {
-                  ((unsigned char *)m_buffer)[j] = data[i];
-                  ((unsigned char *)m_buffer)[j+1] = data[i+1];
-               }
-            }
-         }
+template <class Output> bool Sgp30Device::getValues(
+   Sgp30Features::ID id,
+   Output const & output
+) {
+   Sgp30Features::Command const * command = m_runningCommand;
+   if (!command || (command->m_id != id)) {
+      return false;
+   }else if (!command->m_valuesCount) {
+      m_runningCommand = 0;
+      return true;
+   }else {
+      unsigned char frame[MAX_VALUES * 3];
+      int count = command->m_valuesCount;
+      if (!m_interface.read(frame, count * 3)) {
+         return false;             // NACK: still measuring?
       }
+      m_runningCommand = 0;
+      return output.decode(frame, count);
    }
-   return isOk;
 }
 
 /*-----------------------------------------------------------Sgp30Device::run-+
 | Run a command                                                               |
 +----------------------------------------------------------------------------*/
-bool Sgp30Device::run(
+template <class Output> bool Sgp30Device::run(
    Sgp30Features::ID id,
+   Output const & output,
    int argc, unsigned short const * argv
 ) {
    Sgp30Features::Command const * command = start(id, argc, argv);
    if (!command) {
       return false;
+   }else if (m_latency && command->m_valuesCount) {
+      return runEarly(command, output);
    }else {
       m_interface.sleep(command->m_durationMicros + 5);
-      return getValues(id);
+      return getValues(id, output);
    }
 }
 
-/*STATIC-------------------------------------------------------------checksum-+
-| Compute the checksum of 'n' bytes in 'data' (from 0xFF crc)                 |
-| The polynomial is: P(x)=x^8+x^5+x^4+1, hence 100110001, aka 0x131           |
+/*------------------------------------------------------Sgp30Device::runEarly-+
+| Read at the learned completion time.  While still measuring, the SGP30      |
+| NACKs the read: retry a bit later, but not after the worst case.            |
+| Commands without values can't be probed: run() sleeps the worst case.       |
 +----------------------------------------------------------------------------*/
-unsigned int checksum(unsigned char const * data, int n) {
-   unsigned short crc = 0xFF;
-   for (int i=0; i < n; ++i) {
-      crc ^= data[i];
-      for (int j=8; j > 0; --j) {
-         crc =  (crc & 0x80)? (crc<<1)^0x131 : (crc << 1);
+template <class Output> bool Sgp30Device::runEarly(
+   Sgp30Features::Command const * command,
+   Output const & output
+) {
+   Sgp30Features::ID const id = (Sgp30Features::ID)command->m_id;
+   unsigned long const worst = command->m_durationMicros + 5;
+   unsigned long step;
+   unsigned long elapsed = m_latency->getStartMicros(id, worst, step);
+   int retries = 0;
+
+   m_interface.sleep(elapsed);
+   while (!getValues(id, output)) {
+      if ((m_runningCommand != command) || (elapsed >= worst)) {
+         m_latency->recordFailure(id, retries);  // bad CRC, or no answer
+         return false;
       }
+      unsigned long wait = (worst - elapsed < step)? worst - elapsed : step;
+      m_interface.sleep(wait);
+      elapsed += wait;
+      ++retries;
    }
-   return crc;
+   m_latency->record(id, worst, elapsed, retries);
+   return true;
 }
 
 /*===========================================================================*/
@@ -10,6 +10,7 @@
 #define _SGP30_DEVICE_H_
 
 #include "Sgp30Features.h"
+#include "Sgp30Latency.h"
 
 class Sgp30Device {
 public:
@@ -19,6 +20,14 @@ public:
       virtual bool write(void const * buf, int len) = 0;
       virtual bool read(void * buf, int len) = 0;
    };
+   struct AirQuality {             // also the layout of the baseline
+      unsigned short co2eq;        // ppm
+      unsigned short tvoc;         // ppb
+   };
+   struct RawSignals {
+      unsigned short h2;
+      unsigned short ethanol;
+   };
 public:
    Sgp30Device(Interface & interface);
    bool isOperational() const;
@@ -31,20 +40,39 @@ public:
 
    bool initAirQuality();
 
+   bool measureAirQuality(AirQuality & values);
    bool measureAirQuality(unsigned short * co2eq, unsigned short * tvoc);
    bool measureAirQuality();
+   bool getAirQuality(AirQuality & values);
    bool getAirQuality(unsigned short * co2eq, unsigned short * tvoc);
 
+   bool measureRawSignals(RawSignals & values);
    bool measureRawSignals(unsigned short * h2, unsigned short * ethanol);
    bool measureRawSignals();
+   bool getRawSignals(RawSignals & values);
    bool getRawSignals(unsigned short * h2, unsigned short * ethanol);
 
    bool measureTest(unsigned short * result);
+   bool measureTest();
+   bool getTest(unsigned short * result);
+
+   // duration of the command started, and not yet completed (0 if none)
+   unsigned long getPendingMicros() const;
+   // forget the command started, after its values could not be read
+   void abandon();
+   // worst case duration of a command (0 if not supported by this SGP30)
+   unsigned long getDurationMicros(Sgp30Features::ID id) const;
 
+   // read early, at learned completion times (0: at the worst case)
+   void setAdaptiveLatency(Sgp30Latency * latency);
+   Sgp30Latency * getAdaptiveLatency() const;
+
+   bool getBaseline(AirQuality & baseline);
    bool getBaseline(unsigned short * co2eq, unsigned short * tvoc);
    bool setBaseline(unsigned short co2eq, unsigned short tvoc);
 
    bool setHumidity(unsigned long humidity);
+   bool setHumidityRaw(unsigned short humidity); // g/m**3, 8.8 fixed point
    bool setRelativeHumidity(double rh, double t);
 
 protected:
@@ -52,19 +80,33 @@ protected:
    bool init();
 
 private:
+   enum { MAX_VALUES = 3 };        // see Sgp30Features.cpp
    Interface & m_interface;
-   alignas(unsigned long long) unsigned short m_buffer[10]; // large enough
    unsigned long long m_id;
    Sgp30Features::Command const * m_runningCommand;
    Sgp30Features::Set const * m_featureSet;
+   Sgp30Latency * m_latency;
    unsigned short m_version;
    bool m_isOk;
 
    Sgp30Features::Command const * start(
       Sgp30Features::ID id, int argc=0, unsigned short const * argv=0
    );
-   bool getValues(Sgp30Features::ID id);
-   bool run(Sgp30Features::ID id, int argc=0, unsigned short const * argv=0);
+   // Output decodes the frame read: into an array of Words, or straight
+   // into the two fields of a struct (Pair)
+   class Words;
+   class Pair;
+   template <class Output> bool getValues(
+      Sgp30Features::ID id, Output const & output
+   );
+   template <class Output> bool run(
+      Sgp30Features::ID id,
+      Output const & output,
+      int argc=0, unsigned short const * argv=0
+   );
+   template <class Output> bool runEarly(
+      Sgp30Features::Command const * command, Output const & output
+   );
 };
 
 /*--------+
@@ -73,6 +115,24 @@ private:
 inline bool Sgp30Device::isOperational() const {
    return m_isOk;
 }
+inline unsigned long Sgp30Device::getPendingMicros() const {
+   return m_runningCommand? m_runningCommand->m_durationMicros : 0;
+}
+inline void Sgp30Device::abandon() {
+   m_runningCommand = 0;
+}
+inline unsigned long Sgp30Device::getDurationMicros(
+   Sgp30Features::ID id
+) const {
+   Sgp30Features::Command const * command = m_featureSet->getCommand(id);
+   return command? command->m_durationMicros : 0;
+}
+inline void Sgp30Device::setAdaptiveLatency(Sgp30Latency * latency) {
+   m_latency = latency;
+}
+inline Sgp30Latency * Sgp30Device::getAdaptiveLatency() const {
+   return m_latency;
+}
 inline unsigned long long Sgp30Device::getSerialId() const {
    return m_id;
 }
@@ -0,0 +1,318 @@
+/*
+* Author:  agent
+* Written: 10/16/2026
+*
+* SGP30 - Sensirion Multi-Pixel Gas Sensor - In-process emulation
+*/
+#include <string.h>
+#include <math.h>
+#include "Sgp30Emulator.h"
+#include "Sgp30Crc.h"
+
+/*
+| The signals model (datasheet: c = c_ref * exp((s_ref - s)/512))
+| CLEAN_xxx are the signals of the clean air, also the baseline set by
+| "iaq_init".  Each second, the baseline moves toward the signals: fast when
+| the air is cleaner than it thinks (higher signals), slowly otherwise.
+*/
+static double const SIGNAL_SCALE = 512.0;
+static double const CLEAN_H2 = 13119.0;
+static double const CLEAN_ETHANOL = 18472.0;
+static double const CO2EQ_REF = 400.0;     // ppm
+static double const TVOC_REF = 400.0;      // ppb
+static double const TAU_UP = 60.0;         // seconds
+static double const TAU_DOWN = 43200.0;    // seconds
+
+struct Sgp30Emulator::Command {
+   unsigned short code;
+   int argc;
+   int valuesCount;
+   unsigned long typicalMicros;
+   unsigned long maximumMicros;
+   unsigned short minFeatureSet;
+};
+
+Sgp30Emulator::Command const Sgp30Emulator::s_commands[] = {
+   { 0x2003, 0, 0,   2000,  10000, 0 },    // iaq_init
+   { 0x2008, 0, 2,  10000,  12000, 0 },    // iaq_measure
+   { 0x2015, 0, 2,   1000,  10000, 0 },    // iaq_get_baseline
+   { 0x201e, 2, 0,   1000,  10000, 0 },    // iaq_set_baseline
+   { 0x2061, 1, 0,   1000,  10000, 0x20 }, // set_absolute_humidity
+   { 0x2032, 0, 1, 200000, 220000, 0 },    // measure_test
+   { 0x202f, 0, 1,    500,   1000, 0 },    // get_feature_set_version
+   { 0x2050, 0, 2,  20000,  25000, 0 },    // measure_raw_signals
+   { 0x3682, 0, 3,    500,    500, 0 },    // get_serial_id
+   { 0, 0, 0, 0, 0, 0 }
+};
+
+/*-----------------------------------------------Sgp30Emulator::Sgp30Emulator-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+Sgp30Emulator::Sgp30Emulator(
+   unsigned short featureSet,
+   unsigned long long serialId
+) :
+m_featureSet(featureSet),
+m_serialId(serialId),
+m_timing(TIMING_SPREAD),
+m_random(0),
+m_bitErrorRate(0.0),
+m_time(0),
+m_running(0),
+m_readyTime(0),
+m_wordsCount(0),
+m_isIaqInit(false),
+m_iaqInitTime(0),
+m_baselineTime(0),
+m_humidity(0)
+{
+   m_signals[0] = m_baseline[0] = CLEAN_H2;
+   m_signals[1] = m_baseline[1] = CLEAN_ETHANOL;
+   setBitErrorRate(0.0);
+   resetStats();
+}
+
+/*---------------------------------------------Sgp30Emulator::setBitErrorRate-+
+| 'rate' is the probability for each bit read to be flipped.                  |
+| The seed also drives the spread of the execution times.                     |
++----------------------------------------------------------------------------*/
+void Sgp30Emulator::setBitErrorRate(double rate, unsigned int seed) {
+   m_bitErrorRate = rate;
+   m_random = 0x9E3779B97F4A7C15ULL * (seed | 1);
+}
+
+/*-----------------------------------------------Sgp30Emulator::setAirQuality-+
+| Set the signals which read as these values, for the clean air baseline.     |
++----------------------------------------------------------------------------*/
+void Sgp30Emulator::setAirQuality(unsigned short co2eq, unsigned short tvoc) {
+   update();                       // the baseline, up to now
+   m_signals[0] = CLEAN_H2 - SIGNAL_SCALE * log(
+      ((co2eq < CO2EQ_REF)? CO2EQ_REF : co2eq) / CO2EQ_REF
+   );
+   m_signals[1] = CLEAN_ETHANOL - SIGNAL_SCALE * log(1.0 + (tvoc / TVOC_REF));
+}
+
+/*-----------------------------------------------------Sgp30Emulator::advance-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+void Sgp30Emulator::advance(long long micros) {
+   if (micros > 0) m_time += micros;
+}
+
+/*--------------------------------------------------Sgp30Emulator::resetStats-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+void Sgp30Emulator::resetStats() {
+   memset(&m_stats, 0, sizeof m_stats);
+}
+
+/*-------------------------------------------------------Sgp30Emulator::sleep-+
+| No real sleep: the virtual time just advances.                              |
++----------------------------------------------------------------------------*/
+void Sgp30Emulator::sleep(int us) {
+   advance(us);
+}
+
+/*-------------------------------------------------------Sgp30Emulator::write-+
+| A command word, followed by its arguments (each with its CRC.)              |
+| NACK'ed while a command is running, if the command is unknown (or not in    |
+| the feature set), if the length or an argument CRC is wrong.                |
++----------------------------------------------------------------------------*/
+bool Sgp30Emulator::write(void const * buf, int len) {
+   unsigned char const * bytes = (unsigned char const *)buf;
+   unsigned short args[2];
+   Command const * command = 0;
+
+   update();
+   if (m_running && (m_time < m_readyTime)) {
+      ++m_stats.busy;
+      return false;
+   }
+   if (len >= 2) {
+      unsigned short code = (unsigned short)((bytes[0] << 8) | bytes[1]);
+      for (command = s_commands; command->code; ++command) {
+         if (
+            (command->code == code) &&
+            (m_featureSet >= command->minFeatureSet)
+         ) {
+            break;
+         }
+      }
+   }
+   if (!command || !command->code || (len != 2 + (3 * command->argc))) {
+      ++m_stats.rejected;
+      return false;
+   }
+   for (int i=0; i < command->argc; ++i) {
+      unsigned char const * word = bytes + 2 + (3 * i);
+      if (!Sgp30Crc::isValid(word)) {
+         ++m_stats.rejected;
+         return false;
+      }
+      args[i] = (unsigned short)((word[0] << 8) | word[1]);
+   }
+   m_running = command;
+   m_readyTime = m_time + getDuration(command);
+   execute(args);
+   ++m_stats.commands;
+   return true;
+}
+
+/*--------------------------------------------------------Sgp30Emulator::read-+
+| The values of the last command, as words followed by their CRC.             |
+| NACK'ed until the command is done, and once the values were read.           |
++----------------------------------------------------------------------------*/
+bool Sgp30Emulator::read(void * buf, int len) {
+   unsigned char * bytes = (unsigned char *)buf;
+   unsigned char frame[3 * MAX_WORDS];
+
+   update();
+   if (
+      !m_running || (m_time < m_readyTime) ||
+      (len <= 0) || (len > 3 * m_wordsCount)
+   ) {
+      ++m_stats.nacks;
+      return false;
+   }
+   for (int i=0; i < m_wordsCount; ++i) {
+      frame[3 * i] = (unsigned char)(m_words[i] >> 8);
+      frame[(3 * i) + 1] = (unsigned char)m_words[i];
+      frame[(3 * i) + 2] = Sgp30Crc::compute(frame + (3 * i), 2);
+   }
+   memcpy(bytes, frame, len);
+   if (m_bitErrorRate > 0.0) injectErrors(bytes, len);
+   m_running = 0;
+   m_wordsCount = 0;
+   ++m_stats.reads;
+   return true;
+}
+
+/*------------------------------------------------------Sgp30Emulator::update-+
+| Once the air quality is initialized, update the baseline for each second    |
+| elapsed since the last update.                                              |
++----------------------------------------------------------------------------*/
+void Sgp30Emulator::update() {
+   long long seconds = (m_time - m_baselineTime) / 1000000;
+
+   if (m_isIaqInit && (seconds > 0)) {
+      for (int i=0; i < 2; ++i) {
+         double tau = (m_signals[i] > m_baseline[i])? TAU_UP : TAU_DOWN;
+         m_baseline[i] = m_signals[i] + (
+            (m_baseline[i] - m_signals[i]) * pow(1.0 - (1.0 / tau), seconds)
+         );
+      }
+      m_baselineTime += seconds * 1000000;
+   }
+}
+
+/*-----------------------------------------------------Sgp30Emulator::execute-+
+| Run the command just written.  Its values are ready at m_readyTime.         |
++----------------------------------------------------------------------------*/
+void Sgp30Emulator::execute(unsigned short const * args) {
+   switch (m_running->code) {
+   case 0x2003:                    // iaq_init
+      m_isIaqInit = true;
+      m_iaqInitTime = m_baselineTime = m_time;
+      m_baseline[0] = CLEAN_H2;
+      m_baseline[1] = CLEAN_ETHANOL;
+      break;
+   case 0x2008:                    // iaq_measure
+      getAirQuality(m_words);
+      break;
+   case 0x2015:                    // iaq_get_baseline: co2eq, tvoc
+      m_words[0] = (unsigned short)lround(m_baseline[0]);
+      m_words[1] = (unsigned short)lround(m_baseline[1]);
+      break;
+   case 0x201e:                    // iaq_set_baseline: tvoc, co2eq
+      m_baseline[0] = args[1];
+      m_baseline[1] = args[0];
+      break;
+   case 0x2061:                    // set_absolute_humidity
+      m_humidity = args[0];
+      ++m_stats.humidities;
+      break;
+   case 0x2032:                    // measure_test
+      m_words[0] = 0xD400;
+      break;
+   case 0x202f:                    // get_feature_set_version
+      m_words[0] = m_featureSet;
+      break;
+   case 0x2050:                    // measure_raw_signals
+      m_words[0] = (unsigned short)lround(m_signals[0]);
+      m_words[1] = (unsigned short)lround(m_signals[1]);
+      break;
+   case 0x3682:                    // get_serial_id
+      m_words[0] = (unsigned short)(m_serialId >> 32);
+      m_words[1] = (unsigned short)(m_serialId >> 16);
+      m_words[2] = (unsigned short)m_serialId;
+      break;
+   default:
+      break;
+   }
+   m_wordsCount = m_running->valuesCount;
+}
+
+/*-----------------------------------------------Sgp30Emulator::getAirQuality-+
+| 400 ppm and 0 ppb for 15 seconds after "iaq_init" (datasheet), then the     |
+| concentrations relative to the baseline.                                    |
++----------------------------------------------------------------------------*/
+void Sgp30Emulator::getAirQuality(unsigned short * values) const {
+   double co2eq = CO2EQ_REF;
+   double tvoc = 0.0;
+
+   if (m_isIaqInit && (m_time - m_iaqInitTime >= WARM_UP * 1000000LL)) {
+      co2eq = CO2EQ_REF * exp((m_baseline[0] - m_signals[0]) / SIGNAL_SCALE);
+      tvoc = TVOC_REF * (
+         exp((m_baseline[1] - m_signals[1]) / SIGNAL_SCALE) - 1.0
+      );
+   }
+   values[0] = (unsigned short)lround(
+      (co2eq < CO2EQ_REF)? CO2EQ_REF : (co2eq > 60000.0)? 60000.0 : co2eq
+   );
+   values[1] = (unsigned short)lround(
+      (tvoc < 0.0)? 0.0 : (tvoc > 60000.0)? 60000.0 : tvoc
+   );
+}
+
+/*------------------------------------------------Sgp30Emulator::injectErrors-+
+| Flip each bit with the probability m_bitErrorRate                           |
++----------------------------------------------------------------------------*/
+void Sgp30Emulator::injectErrors(unsigned char * bytes, int len) {
+   for (int i=0; i < len; ++i) {
+      for (int bit=0; bit < 8; ++bit) {
+         double draw = (nextRandom() >> 11) * (1.0 / 9007199254740992.0);
+         if (draw < m_bitErrorRate) {
+            bytes[i] ^= (unsigned char)(1 << bit);
+            ++m_stats.bitErrors;
+         }
+      }
+   }
+}
+
+/*-------------------------------------------------Sgp30Emulator::getDuration-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+unsigned long Sgp30Emulator::getDuration(Command const * command) {
+   unsigned long spread = command->maximumMicros - command->typicalMicros;
+
+   switch (m_timing) {
+   case TIMING_TYPICAL:
+      return command->typicalMicros;
+   case TIMING_MAXIMUM:
+      return command->maximumMicros;
+   default:
+      return command->typicalMicros + (nextRandom() % (spread + 1));
+   }
+}
+
+/*--------------------------------------------------Sgp30Emulator::nextRandom-+
+| xorshift64: fast, and reproducible from the seed                            |
++----------------------------------------------------------------------------*/
+unsigned long long Sgp30Emulator::nextRandom() {
+   m_random ^= m_random << 13;
+   m_random ^= m_random >> 7;
+   m_random ^= m_random << 17;
+   return m_random;
+}
+
+/*===========================================================================*/
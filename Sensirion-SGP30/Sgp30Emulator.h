@@ -0,0 +1,112 @@
+/*
+* Author:  agent
+* Written: 10/16/2026
+*
+* SGP30 - Sensirion Multi-Pixel Gas Sensor - In-process emulation
+*
+* A simulated SGP30, behind Sgp30Device::Interface, to test and load the
+* driver without any hardware:
+* - the command words are decoded, and the CRC of each argument is checked;
+* - each command runs for its execution time (typical, maximum, or spread in
+*   between).  Meanwhile, the device NACKs both reads and writes;
+* - the values are returned as CRC protected words, with bit errors injected
+*   at a configurable rate;
+* - the baseline evolves at 1 Hz, after the air quality initialization;
+* - the feature set is 0x20, or 9 (no humidity compensation.)
+*
+* Time is virtual, in microseconds: only sleep() advances it.
+*
+* The signals follow the datasheet model: c = c_ref * exp((s_ref - s)/512)
+* The baseline is the signal of the clean air (s_ref) as the device
+* estimates it: the air quality is relative to it.
+*/
+#ifndef _SGP30_EMULATOR_H_
+#define _SGP30_EMULATOR_H_
+
+#include "Sgp30Device.h"
+
+class Sgp30Emulator : public Sgp30Device::Interface {
+public:
+   enum TIMING {
+      TIMING_TYPICAL,
+      TIMING_MAXIMUM,
+      TIMING_SPREAD                // uniform, from typical to maximum
+   };
+   struct Stats {
+      unsigned long commands;      // accepted
+      unsigned long rejected;      // unknown command, bad length or CRC
+      unsigned long busy;          // writes NACK'ed: command running
+      unsigned long reads;         // values returned
+      unsigned long nacks;         // reads too early, or with no values
+      unsigned long bitErrors;     // injected
+      unsigned long humidities;    // set_absolute_humidity accepted
+   };
+
+   Sgp30Emulator(
+      unsigned short featureSet = 0x20,    // or 9
+      unsigned long long serialId = 0x0000012345ABULL
+   );
+   void setTiming(TIMING timing);
+   void setBitErrorRate(double rate, unsigned int seed = 1); // per bit read
+   void setAirQuality(unsigned short co2eq, unsigned short tvoc);
+   unsigned short getHumidity() const;     // last set, g/m**3, 8.8
+   long long getTime() const;              // in microseconds
+   void advance(long long micros);
+   void getStats(Stats & stats) const;
+   void resetStats();
+
+   void sleep(int us);
+   bool write(void const * buf, int len);
+   bool read(void * buf, int len);
+
+private:
+   struct Command;
+   enum {
+      MAX_WORDS = 3,
+      WARM_UP = 15                 // seconds of fixed values after init
+   };
+   static Command const s_commands[];
+
+   unsigned short const m_featureSet;
+   unsigned long long const m_serialId;
+   TIMING m_timing;
+   unsigned long long m_random;    // xorshift64 state
+   double m_bitErrorRate;
+   long long m_time;
+   Command const * m_running;
+   long long m_readyTime;          // of the running command
+   int m_wordsCount;               // values ready to be read
+   unsigned short m_words[MAX_WORDS];
+   double m_signals[2];            // h2, ethanol
+   double m_baseline[2];           // clean air signals: h2, ethanol
+   bool m_isIaqInit;
+   long long m_iaqInitTime;
+   long long m_baselineTime;       // of the last 1 Hz update
+   unsigned short m_humidity;      // g/m**3, 8.8 fixed point
+   Stats m_stats;
+
+   void update();
+   void execute(unsigned short const * args);
+   void getAirQuality(unsigned short * values) const;
+   void injectErrors(unsigned char * bytes, int len);
+   unsigned long getDuration(Command const * command);
+   unsigned long long nextRandom();
+};
+
+/*--------+
+| INLINES |
++--------*/
+inline void Sgp30Emulator::setTiming(TIMING timing) {
+   m_timing = timing;
+}
+inline unsigned short Sgp30Emulator::getHumidity() const {
+   return m_humidity;
+}
+inline long long Sgp30Emulator::getTime() const {
+   return m_time;
+}
+inline void Sgp30Emulator::getStats(Stats & stats) const {
+   stats = m_stats;
+}
+#endif
+/*===========================================================================*/
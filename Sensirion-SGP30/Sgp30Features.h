@@ -20,25 +20,23 @@ public:
       MEASURE_TEST,
       GET_FEATURE_SET_VERSION,
       MEASURE_RAW_SIGNALS,
-      GET_SERIAL_ID
+      GET_SERIAL_ID,
+      ID_COUNT                     // (not a command)
    };
    class Command;
    class Value {
-   friend class Command;
    public:
-      Value(char const * name, unsigned short (*convert)(unsigned short));
-   private:
-      char const * m_name;
-      unsigned short (* m_convert)(unsigned short);
+      constexpr Value(char const * name);
+      char const * const m_name;
    };
    class Command {
    public:
-      Command(
+      constexpr Command(
          char const * name,
          ID id,
          unsigned short const code,
          unsigned long durationMicros,
-         Value const ** values,
+         Value const * const * values,
          unsigned short valuesCount
       );
       char const * const m_name;
@@ -47,29 +45,76 @@ public:
       unsigned long const m_durationMicros;
       Value const * const * const m_values;
       unsigned short const m_valuesCount;
-
-      void convertValues(unsigned short * buffer) const;
+   private:
+      static constexpr unsigned short networkByteOrder(unsigned short v);
    };
    class Set {
    public:
       static Set const * makeSet(unsigned short version);
+      static Set const * makeDefaultSet(); // before the version is known
       Command const * getCommand(ID id) const;
    private:
       static Set const set9;
       static Set const set32;
       static Set const setNull;
 
-      Command const ** m_commands;
-      unsigned short m_commandsCount;
+      Command const * const * m_commands; // indexed by ID
       unsigned short const * m_versions;
       unsigned short m_versionsCount;
 
-      Set(
-         Command const ** commands,
-         unsigned short commandsCount,
+      constexpr Set(
+         Command const * const * commands, // ID_COUNT entries
          unsigned short const * versions,
          unsigned short versionsCount
       );
    };
 };
+
+/*--------+
+| INLINES |
++--------*/
+inline constexpr Sgp30Features::Value::Value(char const * name) :
+   m_name(name) {
+}
+inline constexpr Sgp30Features::Command::Command(
+   char const * name,
+   ID id,
+   unsigned short code,
+   unsigned long durationMicros,
+   Value const * const * values,
+   unsigned short valuesCount
+) :
+   m_name(name),
+   m_id(id),
+   m_code(networkByteOrder(code)),
+   m_durationMicros(durationMicros),
+   m_values(values),
+   m_valuesCount(valuesCount)
+{}
+inline constexpr unsigned short Sgp30Features::Command::networkByteOrder(
+   unsigned short v
+) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+   return (unsigned short)((v << 8) | (0xff & (v >> 8)));
+#else
+   return v;
+#endif
+}
+inline constexpr Sgp30Features::Set::Set(
+   Command const * const * commands,
+   unsigned short const * versions,
+   unsigned short versionsCount
+) :
+   m_commands(commands),
+   m_versions(versions),
+   m_versionsCount(versionsCount)
+{}
+inline Sgp30Features::Set const * Sgp30Features::Set::makeDefaultSet() {
+   return &setNull;
+}
+inline Sgp30Features::Command const * Sgp30Features::Set::getCommand(
+   ID id
+) const {
+   return ((unsigned int)id < ID_COUNT)? m_commands[id] : 0;
+}
 #endif
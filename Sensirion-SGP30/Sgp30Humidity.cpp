@@ -0,0 +1,98 @@
+/*
+* Author:  agent
+* Written: 10/16/2026
+*
+* SGP30 - Sensirion Multi-Pixel Gas Sensor - Humidity compensation
+*/
+#include "Sgp30Humidity.h"
+
+/*
+| Saturation vapor density, in g/m**3, from -40 to 85 Celsius degrees:
+|    216.7 * (6.112 * exp((17.62 * t) / (243.12 + t))) / (273.15 + t)
+| (the same Magnus formula as Sgp30Device::setRelativeHumidity.)
+| The linear interpolation error is below 0.05 g/m**3 over the range
+| the SGP30 accepts: 0.042 at worst, at 76.5 Celsius degrees (see
+| checkHumidity in Sgp30Test.)
+*/
+float const Sgp30Humidity::s_saturation[T_MAX - T_MIN + 1] = {
+     0.1768f,   0.1952f,   0.2153f,   0.2373f,   0.2612f,   0.2873f,  // -40
+     0.3157f,   0.3465f,   0.3801f,   0.4165f,   0.4560f,   0.4989f,  // -34
+     0.5452f,   0.5954f,   0.6497f,   0.7084f,   0.7717f,   0.8400f,  // -28
+     0.9136f,   0.9929f,   1.0783f,   1.1701f,   1.2688f,   1.3748f,  // -22
+     1.4886f,   1.6106f,   1.7415f,   1.8816f,   2.0316f,   2.1921f,  // -16
+     2.3637f,   2.5470f,   2.7427f,   2.9516f,   3.1744f,   3.4118f,  // -10
+     3.6647f,   3.9340f,   4.2205f,   4.5251f,   4.8489f,   5.1928f,  // -4
+     5.5579f,   5.9453f,   6.3561f,   6.7915f,   7.2528f,   7.7413f,  // 2
+     8.2582f,   8.8050f,   9.3830f,   9.9939f,  10.6391f,  11.3203f,  // 8
+    12.0391f,  12.7972f,  13.5965f,  14.4387f,  15.3259f,  16.2599f,  // 14
+    17.2428f,  18.2768f,  19.3640f,  20.5066f,  21.7071f,  22.9678f,  // 20
+    24.2911f,  25.6798f,  27.1362f,  28.6633f,  30.2638f,  31.9406f,  // 26
+    33.6966f,  35.5349f,  37.4587f,  39.4711f,  41.5756f,  43.7754f,  // 32
+    46.0741f,  48.4754f,  50.9829f,  53.6003f,  56.3317f,  59.1810f,  // 38
+    62.1523f,  65.2498f,  68.4778f,  71.8408f,  75.3432f,  78.9897f,  // 44
+    82.7850f,  86.7339f,  90.8415f,  95.1129f,  99.5531f, 104.1676f,  // 50
+   108.9618f, 113.9412f, 119.1114f, 124.4784f, 130.0479f, 135.8260f,  // 56
+   141.8190f, 148.0330f, 154.4746f, 161.1502f, 168.0665f, 175.2303f,  // 62
+   182.6486f, 190.3285f, 198.2770f, 206.5017f, 215.0098f, 223.8091f,  // 68
+   232.9073f, 242.3123f, 252.0320f, 262.0747f, 272.4486f, 283.1621f,  // 74
+   294.2239f, 305.6426f, 317.4272f, 329.5865f, 342.1298f, 355.0663f   // 80
+};
+
+/*-----------------------------------------------Sgp30Humidity::Sgp30Humidity-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+Sgp30Humidity::Sgp30Humidity(Sgp30Device & device) :
+m_device(device),
+m_humidity(0),
+m_isSent(false),
+m_sentCount(0),
+m_skippedCount(0)
+{}
+
+/*------------------------------------------------------Sgp30Humidity::update-+
+| Returns false if the SET_HUMIDITY command failed, or isn't supported by     |
+| the feature set of this SGP30.                                              |
++----------------------------------------------------------------------------*/
+bool Sgp30Humidity::update(double rh, double t) {
+   unsigned short humidity = getAbsoluteHumidity(rh, t);
+   if (m_isSent && (humidity == m_humidity)) {
+      ++m_skippedCount;
+      return true;
+   }
+   if (!m_device.setHumidityRaw(humidity)) {
+      m_isSent = false;
+      return false;
+   }
+   m_humidity = humidity;
+   m_isSent = true;
+   ++m_sentCount;
+   return true;
+}
+
+/*STATIC-----------------------------------Sgp30Humidity::getAbsoluteHumidity-+
+| Returns g/m**3 as a 8.8 fixed point number, clamped to [1, 0xffff]: zero    |
+| would disable the compensation.                                             |
++----------------------------------------------------------------------------*/
+unsigned short Sgp30Humidity::getAbsoluteHumidity(double rh, double t) {
+   double x = t - T_MIN;
+   int i;
+   if (x < 0) {
+      x = 0;
+   }else if (x > (T_MAX - T_MIN)) {
+      x = T_MAX - T_MIN;
+   }
+   i = (int)x;                       // x >= 0: same as floor
+   if (i == (T_MAX - T_MIN)) --i;
+   double saturation = s_saturation[i] + (
+      (s_saturation[i+1] - s_saturation[i]) * (x - i)
+   );
+   double humidity = (rh * saturation * 256 / 100) + 0.5;
+   if (humidity < 1) {
+      return 1;
+   }else if (humidity > 0xffff) {
+      return 0xffff;
+   }else {
+      return (unsigned short)humidity;
+   }
+}
+/*===========================================================================*/
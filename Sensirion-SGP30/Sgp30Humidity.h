@@ -0,0 +1,59 @@
+/*
+* Author:  agent
+* Written: 10/16/2026
+*
+* SGP30 - Sensirion Multi-Pixel Gas Sensor - Humidity compensation
+*
+* Feed update() with the temperature (e.g. from Bmp280Device::readValues)
+* and the relative humidity, as often as they are sampled.  The absolute
+* humidity is interpolated from a table, per degree Celsius, of the
+* saturation vapor density: no exp() at each sample.  SET_HUMIDITY is
+* only sent when its 8.8 fixed point value changes.
+*
+* Like any other command, update() must not be called while another
+* thread talks to the same Sgp30Device (e.g. take the Tickler lock).
+*/
+#ifndef _SGP30_HUMIDITY_H_
+#define _SGP30_HUMIDITY_H_
+
+#include "Sgp30Device.h"
+
+class Sgp30Humidity {
+public:
+   Sgp30Humidity(Sgp30Device & device);
+   bool update(double rh, double t); // rh: %, t: Celsius degrees
+   void invalidate();                // resend at next update (after a reset)
+
+   int getSentCount() const;
+   int getSkippedCount() const;
+
+   static unsigned short getAbsoluteHumidity(double rh, double t);
+
+private:
+   enum {
+      T_MIN = -40,                   // SGP30 operating range
+      T_MAX = 85
+   };
+   static float const s_saturation[T_MAX - T_MIN + 1]; // g/m**3 at 100%
+
+   Sgp30Device & m_device;
+   unsigned short m_humidity;        // last sent
+   bool m_isSent;
+   int m_sentCount;
+   int m_skippedCount;
+};
+
+/*--------+
+| INLINES |
++--------*/
+inline void Sgp30Humidity::invalidate() {
+   m_isSent = false;
+}
+inline int Sgp30Humidity::getSentCount() const {
+   return m_sentCount;
+}
+inline int Sgp30Humidity::getSkippedCount() const {
+   return m_skippedCount;
+}
+#endif
+/*===========================================================================*/
@@ -0,0 +1,91 @@
+/*
+* Author:  agent
+* Written: 10/16/2026
+*
+* SGP30 - Sensirion Multi-Pixel Gas Sensor - Command latency tracking
+*/
+#include <string.h>
+#include "Sgp30Latency.h"
+
+/*-------------------------------------------------Sgp30Latency::Sgp30Latency-+
+| percentile: of the completion times, where the first read is attempted      |
++----------------------------------------------------------------------------*/
+Sgp30Latency::Sgp30Latency(int percentile) :
+m_percentile(
+   (percentile < 1)? 1 : (percentile > 100)? 100 : percentile
+) {
+   memset(m_entries, 0, sizeof m_entries);
+}
+
+/*-----------------------------------------------Sgp30Latency::getStartMicros-+
+| When to attempt the first read, for a command just started, and how long    |
+| to wait before each retry ('step').  A probe reads at each bucket edge.     |
++----------------------------------------------------------------------------*/
+unsigned long Sgp30Latency::getStartMicros(
+   Sgp30Features::ID id,
+   unsigned long worst,
+   unsigned long & step
+) {
+   Entry & entry = m_entries[id];
+   if (
+      (entry.count < MIN_SAMPLES) ||
+      ((entry.stats.runs % PROBE_PERIOD) == 0)
+   ) {
+      step = (worst < BUCKETS)? 1 : worst / BUCKETS; // not past an edge
+      return step;
+   }else {
+      step = (worst / STEPS) + 1;
+      return getPercentileMicros(id, worst);
+   }
+}
+
+/*------------------------------------------Sgp30Latency::getPercentileMicros-+
+| Upper edge of the bucket holding the percentile (worst case if no sample)   |
++----------------------------------------------------------------------------*/
+unsigned long Sgp30Latency::getPercentileMicros(
+   Sgp30Features::ID id,
+   unsigned long worst
+) const {
+   Entry const & entry = m_entries[id];
+   unsigned long const target = (entry.count * m_percentile + 99) / 100;
+   unsigned long sum = 0;
+   for (int i=0; i < BUCKETS; ++i) {
+      sum += entry.histogram[i];
+      if ((sum >= target) && (sum > 0)) {
+         return (worst * (i + 1)) / BUCKETS;
+      }
+   }
+   return worst;
+}
+
+/*-------------------------------------------------------Sgp30Latency::record-+
+| elapsed: microseconds slept from the command start to the successful read   |
++----------------------------------------------------------------------------*/
+void Sgp30Latency::record(
+   Sgp30Features::ID id,
+   unsigned long worst,
+   unsigned long elapsed,
+   int retries
+) {
+   Entry & entry = m_entries[id];
+   unsigned long bucket = (elapsed * BUCKETS) / (worst + 1);
+   if (bucket >= BUCKETS) bucket = BUCKETS - 1;
+   ++entry.histogram[bucket];
+   ++entry.count;
+   ++entry.stats.runs;
+   if (retries == 0) ++entry.stats.earlyHits;
+   entry.stats.retries += retries;
+   entry.stats.elapsedSum += elapsed;
+   entry.stats.worstSum += worst;
+}
+
+/*------------------------------------------------Sgp30Latency::recordFailure-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+void Sgp30Latency::recordFailure(Sgp30Features::ID id, int retries) {
+   Entry & entry = m_entries[id];
+   ++entry.stats.runs;
+   ++entry.stats.failures;
+   entry.stats.retries += retries;
+}
+/*===========================================================================*/
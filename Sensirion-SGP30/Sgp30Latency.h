@@ -0,0 +1,78 @@
+/*
+* Author:  agent
+* Written: 10/16/2026
+*
+* SGP30 - Sensirion Multi-Pixel Gas Sensor - Command latency tracking
+*
+* The datasheet durations are worst cases.  While a measurement is still
+* running, the SGP30 NACKs its read header: the Interface read() fails.
+* With a Sgp30Latency attached (Sgp30Device::setAdaptiveLatency), run()
+* reads early, at a learned percentile of the completion times, then
+* retries every 1/16th of the worst case, never beyond it.
+*
+* Per command, an histogram of 32 buckets, each 1/32nd of the worst case,
+* records the time of the first successful read.  It is an upper bound of
+* the completion time: the first 16 runs, then every 16th run, are probes
+* which start at 1/32nd of the worst case and retry every 1/32nd, so that
+* the percentile can decrease as well, down to the bucket width.
+*/
+#ifndef _SGP30_LATENCY_H_
+#define _SGP30_LATENCY_H_
+
+#include "Sgp30Features.h"
+
+class Sgp30Latency {
+public:
+   enum {
+      BUCKETS = 32,
+      STEPS = 16,                  // retry period: worst case / STEPS
+      MIN_SAMPLES = 16,            // before trusting the percentile
+      PROBE_PERIOD = 16            // runs between two probes
+   };
+   struct Stats {
+      unsigned long runs;
+      unsigned long earlyHits;     // values read on the first attempt
+      unsigned long retries;       // NACK'ed reads
+      unsigned long failures;      // no values, even at the worst case
+      unsigned long long elapsedSum;  // microseconds, successful runs
+      unsigned long long worstSum;    // same runs, at the worst case
+   };
+
+   Sgp30Latency(int percentile = 90);
+
+   unsigned long getStartMicros(
+      Sgp30Features::ID id, unsigned long worst, unsigned long & step
+   );
+   unsigned long getPercentileMicros(
+      Sgp30Features::ID id, unsigned long worst
+   ) const;
+   void record(
+      Sgp30Features::ID id,
+      unsigned long worst,
+      unsigned long elapsed,
+      int retries
+   );
+   void recordFailure(Sgp30Features::ID id, int retries);
+   void getStats(Sgp30Features::ID id, Stats & stats) const;
+
+private:
+   struct Entry {
+      unsigned long histogram[BUCKETS];
+      unsigned long count;         // samples in the histogram
+      Stats stats;
+   };
+   Entry m_entries[Sgp30Features::ID_COUNT];
+   int m_percentile;
+};
+
+/*--------+
+| INLINES |
++--------*/
+inline void Sgp30Latency::getStats(
+   Sgp30Features::ID id,
+   Stats & stats
+) const {
+   stats = m_entries[id].stats;
+}
+#endif
+/*===========================================================================*/
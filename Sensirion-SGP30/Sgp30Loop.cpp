@@ -0,0 +1,155 @@
+/*
+* Author:  agent
+* Written: 10/16/2026
+*
+* SGP30 - Sensirion Multi-Pixel Gas Sensor - Non-blocking command engine
+*/
+#include <unistd.h>
+#include <stdio.h>
+#include <time.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include "Sgp30Loop.h"
+
+/*-------------------------------------------------------Sgp30Loop::Sgp30Loop-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+Sgp30Loop::Sgp30Loop(int capacity) :
+m_pendings(new Pending[capacity]),
+m_capacity(capacity),
+m_count(0),
+m_epollFd(epoll_create1(EPOLL_CLOEXEC)),
+m_timerFd(timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC))
+{
+   struct epoll_event event;
+   event.events = EPOLLIN;
+   event.data.fd = m_timerFd;
+   if (
+      !isOk() ||
+      (epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_timerFd, &event) != 0)
+   ) {
+      perror("Sgp30Loop");
+   }
+}
+
+/*------------------------------------------------------Sgp30Loop::~Sgp30Loop-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+Sgp30Loop::~Sgp30Loop() {
+   if (m_timerFd >= 0) ::close(m_timerFd);
+   if (m_epollFd >= 0) ::close(m_epollFd);
+   delete [] m_pendings;
+}
+
+/*----------------------------------------------------------Sgp30Loop::submit-+
+| Start the command.  Fails if the device is already running a command.       |
++----------------------------------------------------------------------------*/
+bool Sgp30Loop::submit(Sgp30Device & device, OPERATION op, Handler & handler) {
+   bool isStarted = false;
+
+   if ((m_count == m_capacity) || device.getPendingMicros()) {
+      return false;
+   }
+   switch (op) {
+   case AIR_QUALITY:
+      isStarted = device.measureAirQuality();
+      break;
+   case RAW_SIGNALS:
+      isStarted = device.measureRawSignals();
+      break;
+   case TEST:
+      isStarted = device.measureTest();
+      break;
+   }
+   if (!isStarted) return false;
+
+   Pending & pending = m_pendings[m_count++];
+   pending.device = &device;
+   pending.handler = &handler;
+   pending.op = op;
+   pending.deadline = now() + device.getPendingMicros() + 5;
+   arm();
+   return true;
+}
+
+/*-------------------------------------------------------------Sgp30Loop::run-+
+| Returns the number of commands completed.                                   |
++----------------------------------------------------------------------------*/
+int Sgp30Loop::run(int timeoutMs) {
+   struct epoll_event event;
+   if ((m_count == 0) || (epoll_wait(m_epollFd, &event, 1, timeoutMs) <= 0)) {
+      return 0;
+   }else {
+      return dispatch();
+   }
+}
+
+/*--------------------------------------------------------Sgp30Loop::dispatch-+
+| The handler is called once the command is removed from the pending list:    |
+| it can submit a new command for the same device.                            |
+| The deadline is the worst case: if the values can't be read by then, the    |
+| command is abandoned, so that the device accepts another one.               |
++----------------------------------------------------------------------------*/
+int Sgp30Loop::dispatch() {
+   unsigned long long expirations;
+   long long const time = now();
+   int done = 0;
+
+   while (::read(m_timerFd, &expirations, sizeof expirations) > 0) {}
+   for (int i=0; i < m_count; ) {
+      if (m_pendings[i].deadline > time) {
+         ++i;
+      }else {
+         Pending pending = m_pendings[i];
+         unsigned short values[2] = { 0, 0 };
+         bool isOk = false;
+         m_pendings[i] = m_pendings[--m_count];
+         switch (pending.op) {
+         case AIR_QUALITY:
+            isOk = pending.device->getAirQuality(values, values+1);
+            break;
+         case RAW_SIGNALS:
+            isOk = pending.device->getRawSignals(values, values+1);
+            break;
+         case TEST:
+            isOk = pending.device->getTest(values);
+            break;
+         }
+         if (!isOk) pending.device->abandon();
+         pending.handler->onCompletion(
+            *pending.device, pending.op, isOk, values
+         );
+         ++done;
+      }
+   }
+   arm();
+   return done;
+}
+
+/*-------------------------------------------------------------Sgp30Loop::arm-+
+| Set the timer to the earliest deadline                                      |
++----------------------------------------------------------------------------*/
+void Sgp30Loop::arm() {
+   struct itimerspec spec = {};
+   if (m_count > 0) {
+      long long deadline = m_pendings[0].deadline;
+      for (int i=1; i < m_count; ++i) {
+         if (m_pendings[i].deadline < deadline) {
+            deadline = m_pendings[i].deadline;
+         }
+      }
+      spec.it_value.tv_sec = deadline / 1000000;
+      spec.it_value.tv_nsec = (deadline % 1000000) * 1000;
+   }
+   timerfd_settime(m_timerFd, TFD_TIMER_ABSTIME, &spec, 0);
+}
+
+/*STATIC-------------------------------------------------------Sgp30Loop::now-+
+| CLOCK_MONOTONIC, in microseconds                                            |
++----------------------------------------------------------------------------*/
+long long Sgp30Loop::now() {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (ts.tv_sec * 1000000LL) + (ts.tv_nsec / 1000);
+}
+/*===========================================================================*/
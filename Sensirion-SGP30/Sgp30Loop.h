@@ -0,0 +1,80 @@
+/*
+* Author:  agent
+* Written: 10/16/2026
+*
+* SGP30 - Sensirion Multi-Pixel Gas Sensor - Non-blocking command engine
+*
+* A single thread drives many Sgp30Device's, on one or several buses:
+* - submit() starts a command, and returns immediately;
+* - run() waits (epoll on a timerfd) for the earliest command deadline,
+*   gets its values and calls the Handler back.
+* getFd() can be added to the caller's own epoll set instead of calling
+* run(): when it is readable, call dispatch().
+*/
+#ifndef _SGP30_LOOP_H_
+#define _SGP30_LOOP_H_
+
+#include "Sgp30Device.h"
+
+class Sgp30Loop {
+public:
+   enum OPERATION {
+      AIR_QUALITY,                 // values: co2eq, tvoc
+      RAW_SIGNALS,                 // values: h2, ethanol
+      TEST                         // values: test result
+   };
+   class Handler {                 // pure abstract class
+   public:
+      virtual void onCompletion(
+         Sgp30Device & device,
+         OPERATION op,
+         bool isOk,
+         unsigned short const * values
+      ) = 0;
+   };
+
+   Sgp30Loop(int capacity);        // max number of pending commands
+   ~Sgp30Loop();
+   bool isOk() const;
+   int getFd() const;
+   int getPendingCount() const;
+
+   bool submit(Sgp30Device & device, OPERATION op, Handler & handler);
+   int run(int timeoutMs = -1);    // -1: wait until a command completes
+   int dispatch();                 // complete the due commands, if any
+
+private:
+   struct Pending {
+      Sgp30Device * device;
+      Handler * handler;
+      OPERATION op;
+      long long deadline;          // CLOCK_MONOTONIC, in microseconds
+   };
+   Pending * m_pendings;
+   int m_capacity;
+   int m_count;
+   int m_epollFd;
+   int m_timerFd;
+
+   void arm();
+   static long long now();
+
+   Sgp30Loop(Sgp30Loop const &);   // no copy
+   Sgp30Loop & operator=(Sgp30Loop const &);
+};
+
+/*--------+
+| INLINES |
++--------*/
+inline bool Sgp30Loop::isOk() const {
+   return (m_epollFd >= 0) && (m_timerFd >= 0);
+}
+inline int Sgp30Loop::getFd() const {
+   return m_epollFd;
+}
+inline int Sgp30Loop::getPendingCount() const {
+   return m_count;
+}
+
+#endif
+/*===========================================================================*/
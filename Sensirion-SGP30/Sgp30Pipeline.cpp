@@ -0,0 +1,93 @@
+/*
+* Author:  agent
+* Written: 10/16/2026
+*
+* SGP30 - Sensirion Multi-Pixel Gas Sensor - Interleaved acquisition
+*/
+#include "Sgp30Pipeline.h"
+
+/*-----------------------------------------------Sgp30Pipeline::Sgp30Pipeline-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+Sgp30Pipeline::Sgp30Pipeline(
+   Sgp30Device & device,
+   int rawPerFrame,
+   long periodMicros,
+   long baselineSeconds
+) :
+Sgp30Tickler(device, periodMicros, baselineSeconds),
+m_rawPerFrame(rawPerFrame),
+m_frame(0),
+m_rawCount(0),
+m_rawShortfall(0)
+{}
+
+/*----------------------------------------------------Sgp30Pipeline::onSample-+
+| Starts a new frame                                                          |
++----------------------------------------------------------------------------*/
+void Sgp30Pipeline::onSample(
+   bool isOk,
+   unsigned short co2eq,
+   unsigned short tvoc,
+   long long stamp
+) {
+   ++m_frame;
+   if (isOk) {
+      Record record;
+      record.kind = AIR_QUALITY;
+      record.frame = m_frame;
+      record.stamp = stamp;
+      record.values[0] = co2eq;
+      record.values[1] = tvoc;
+      onRecord(record);
+   }
+}
+
+/*-------------------------------------------------Sgp30Pipeline::onSpareTime-+
+| Run back to back as many raw signals measurements as asked, and as fit in   |
+| the frame.  The lock is taken for each one: other threads may interleave    |
+| their own commands.                                                         |
++----------------------------------------------------------------------------*/
+void Sgp30Pipeline::onSpareTime(long long deadline) {
+   Sgp30Device & device = getDevice();
+   long long const duration = (
+      device.getDurationMicros(Sgp30Features::MEASURE_RAW_SIGNALS) + 5
+   );
+   int done = 0;
+
+   while ((done < m_rawPerFrame) && (duration > 5)) {
+      Sgp30Device::RawSignals values;
+      long long stamp;
+      bool isOk;
+
+      lock();
+      stamp = now();
+      if (stamp + duration + GUARD_MICROS > deadline) {
+         unlock();
+         break;
+      }
+      isOk = device.measureRawSignals();
+      if (isOk) {
+         sleepUntil(stamp + duration);
+         isOk = device.getRawSignals(values);
+      }
+      unlock();
+      if (!isOk) break;
+
+      Record record;
+      record.kind = RAW_SIGNALS;
+      record.frame = m_frame;
+      record.stamp = stamp;
+      record.values[0] = values.h2;
+      record.values[1] = values.ethanol;
+      m_rawCount.fetch_add(1, std::memory_order_relaxed);
+      ++done;
+      onRecord(record);
+   }
+   if (done < m_rawPerFrame) {
+      m_rawShortfall.fetch_add(
+         m_rawPerFrame - done, std::memory_order_relaxed
+      );
+   }
+}
+/*===========================================================================*/
@@ -0,0 +1,68 @@
+/*
+* Author:  agent
+* Written: 10/16/2026
+*
+* SGP30 - Sensirion Multi-Pixel Gas Sensor - Interleaved acquisition
+*
+* Each period (frame) of the Tickler starts with "measure air quality",
+* at the exact 1 Hz cadence the baseline algorithm expects.  The spare
+* time of the frame is then filled with up to 'rawPerFrame' "measure raw
+* signals", each one started only if it completes before the next frame.
+* Both streams are handed to onRecord(), time stamped and numbered by
+* frame.
+*/
+#ifndef _SGP30_PIPELINE_H_
+#define _SGP30_PIPELINE_H_
+
+#include "Sgp30Tickler.h"
+
+class Sgp30Pipeline : public Sgp30Tickler {
+public:
+   enum KIND {
+      AIR_QUALITY,                 // values: co2eq, tvoc
+      RAW_SIGNALS                  // values: h2, ethanol
+   };
+   struct Record {
+      KIND kind;
+      unsigned long frame;         // the same for a frame's records
+      long long stamp;             // CLOCK_MONOTONIC, in microseconds
+      unsigned short values[2];
+   };
+
+   Sgp30Pipeline(
+      Sgp30Device & device,
+      int rawPerFrame = 1,
+      long periodMicros = 1000000,
+      long baselineSeconds = 3600
+   );
+   long long getRawCount() const;     // raw signals records emitted
+   long long getRawShortfall() const; // not run, for lack of time/failure
+
+protected:
+   // Called from the tickler thread, the lock being released
+   virtual void onRecord(Record const & record) {}
+
+   void onSample(
+      bool isOk, unsigned short co2eq, unsigned short tvoc, long long stamp
+   );
+   void onSpareTime(long long deadline);
+
+private:
+   enum { GUARD_MICROS = 2000 };   // margin before the next frame
+   int const m_rawPerFrame;
+   unsigned long m_frame;
+   std::atomic<long long> m_rawCount;
+   std::atomic<long long> m_rawShortfall;
+};
+
+/*--------+
+| INLINES |
++--------*/
+inline long long Sgp30Pipeline::getRawCount() const {
+   return m_rawCount.load(std::memory_order_relaxed);
+}
+inline long long Sgp30Pipeline::getRawShortfall() const {
+   return m_rawShortfall.load(std::memory_order_relaxed);
+}
+#endif
+/*===========================================================================*/
@@ -6,9 +6,15 @@
 *
 * An implementation example to demonstrate the Sgp30Device class.
 *
+* No hardware is needed for:
+* - "Sgp30Test check": correctness checks, exit code 1 on failure;
+* - "Sgp30Test bench": benchmarks.
+*
 * Compile with:
-g++ -Wall -std=c++0x -pthread -o Sgp30Test \
-   Sgp30Test.cpp Sgp30Device.cpp Sgp30Features.cpp
+g++ -O2 -Wall -std=c++0x -pthread -o Sgp30Test \
+   Sgp30Test.cpp Sgp30Device.cpp Sgp30Features.cpp Sgp30Crc.cpp \
+   Sgp30Tickler.cpp Sgp30BaselineStore.cpp Sgp30Latency.cpp \
+   Sgp30Loop.cpp Sgp30Pipeline.cpp Sgp30Humidity.cpp Sgp30Emulator.cpp
 */
 #include <unistd.h>
 #include <stdio.h>
@@ -17,16 +23,24 @@ g++ -Wall -std=c++0x -pthread -o Sgp30Test \
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/ioctl.h>
-#include <sys/syscall.h>
-#include <sys/resource.h>
 #include <linux/i2c-dev.h>
 #include <pthread.h>
-#include <signal.h>
-#include <errno.h>
 #include <time.h>
+#include <string.h>
+#include <math.h>
+#include <atomic>
 #include "Sgp30Device.h"
+#include "Sgp30Crc.h"
+#include "Sgp30Loop.h"
+#include "Sgp30Pipeline.h"
+#include "Sgp30Emulator.h"
+#include "Sgp30Tickler.h"
+#include "Sgp30BaselineStore.h"
+#include "Sgp30Humidity.h"
 
 static char const * const timeStamp(time_t time = (time_t)-1);
+static bool check();
+static void bench();
 
 static char const * const usage(
    "| Enter one of:\n"
@@ -36,18 +50,20 @@ static char const * const usage(
    "|   %s <i2c-address> <co2-eq-compensate> <tvoc-compensate> <time-stamp>\n"
 );
 static char const * const baselineUsage(
-   "| You didn't enter any compensation arguments. For the next 15 seconds\n"
+   "| No compensation arguments, and no stored baseline.  For the next 15s\n"
    "| the SGP30 will self-initialize, returning erroneous values.\n"
    "| After having run for one hour, a rough baseline will be established\n"
    "| and refined each following hours. To have enough accuracy, it is\n"
    "| advised to run this program during 12 hours.\n"
    "|\n"
-   "| Before exiting, a specific command will be displayed to be used\n"
-   "| at the next time this program is run.\n"
+   "| Each hourly baseline is saved to a file named after the SGP30 serial\n"
+   "| id, in $SGP30_BASELINE_DIR (or the current directory), and is reused\n"
+   "| automatically at the next time this program is run.\n"
+   "| Before exiting, a specific command will also be displayed.\n"
    "|\n"
    "| IMPORTANT:\n"
    "|   To exit, enter the letter \'q\', do *not* press Ctrl-C.\n"
-   "|   If you do, you will loose all your precious compensation parameters.\n"
+   "|   If you do, you will loose the last hour of compensation parameters.\n"
    "|   Also, note that the compensation parameters are valid only one week.\n"
 );
 static char const * const runUsage(
@@ -85,19 +101,6 @@ private:
 };
 
 
-/*--------------------------------------------------------------class Thread -+
-|                                                                             |
-+----------------------------------------------------------------------------*/
-class Thread {
-public:
-   Thread();
-   bool create(char const * name, void *(*func)(void *), void * arg);
-   void terminate();
-private:
-   pthread_t m_tid;
-   char const * m_name;
-};
-
 /*-------------------------------------------------------- class MyInterface -+
 |                                                                             |
 +----------------------------------------------------------------------------*/
@@ -127,7 +130,7 @@ private:
 /*------------------------------------------------------ class MySgp30Device -+
 |                                                                             |
 +----------------------------------------------------------------------------*/
-class MySgp30Device : public Sgp30Device {
+class MySgp30Device : public Sgp30Device, private Sgp30Tickler {
 public:
    MySgp30Device(MyInterface & interface, Args & args);
    ~MySgp30Device();
@@ -137,20 +140,37 @@ public:
    void releaseLock() {
       if (pthread_mutex_unlock(&m_mutex) != 0) perror("mutex_unlock");
    }
+   using Sgp30Tickler::Sample;
+   using Sgp30Tickler::getLatest;
+   long long getAge(Sample const & sample) const {
+      return now() - sample.stamp;
+   }
+   void printLatency();
 private:
    Args & m_args;
-   Thread m_tickler; // to send measureAirQuality each sec in the background
+   Sgp30BaselineStore m_store;
+   Sgp30Latency m_latency;
    pthread_mutex_t m_mutex;
-   sigset_t m_sigset;
-   static void * runTickler(void * p);
-   void * tickle();
+   time_t m_startTime;
+
+   // Sgp30Tickler hooks: measureAirQuality each sec in the background
+   void lock() { acquireLock(); }
+   void unlock() { releaseLock(); }
+   void onBaseline(
+      bool isOk, unsigned short co2eq, unsigned short tvoc, time_t stamp
+   );
 };
 
 /*-----------------------------------------------MySgp30Device::MySgp30Device-+
 |                                                                             |
 +----------------------------------------------------------------------------*/
 MySgp30Device::MySgp30Device(MyInterface & interface, Args & args) :
-Sgp30Device(interface), m_args(args), m_mutex(PTHREAD_MUTEX_INITIALIZER)
+Sgp30Device(interface),
+Sgp30Tickler((Sgp30Device &)*this),
+m_args(args),
+m_store(getenv("SGP30_BASELINE_DIR")? getenv("SGP30_BASELINE_DIR") : "."),
+m_mutex(PTHREAD_MUTEX_INITIALIZER),
+m_startTime(time(0))
 {
    if (!isOperational()) {
       printf("No SGP30 device, or device not operational - Exiting\n");
@@ -167,73 +187,45 @@ Sgp30Device(interface), m_args(args), m_mutex(PTHREAD_MUTEX_INITIALIZER)
       printf("Init Air Quality failure - Exiting\n");
       exit(4);
    }
+   if (
+      !args.isCompensated &&
+      m_store.load(
+         getSerialId(), &args.co2eqCompens, &args.tvocCompens,
+         &args.stampCompens
+      )
+   ) {
+      printf(
+         "Re-using stored baseline dated %s\n", timeStamp(args.stampCompens)
+      );
+      args.isCompensated = true;
+   }
    if (args.isCompensated && !setBaseline(args.co2eqCompens, args.tvocCompens)) {
       printf("Set Baseline failure - Exiting\n");
       exit(5);
    }
+   setAdaptiveLatency(&m_latency);
 
    // start tickling in the background at a period of 1s
-   sigemptyset(&m_sigset);
-   sigaddset(&m_sigset, SIGUSR1);
-   if (
-      (pthread_sigmask(SIG_BLOCK, &m_sigset, 0) != 0) ||
-      (m_tickler.create("MySgp30Device.Tickler", runTickler, this))
-   ) {
-      perror("MySgp30Device.Tickler");
-   }
-}
-
-/*--------------------------------------------------MySgp30Device::runTickler-+
-|                                                                             |
-+----------------------------------------------------------------------------*/
-void * MySgp30Device::runTickler(void * p) {
-   return ((MySgp30Device *)p)->tickle();
+   Sgp30Tickler::start();
 }
 
 /*----------------------------------------------MySgp30Device::~MySgp30Device-+
 |                                                                             |
 +----------------------------------------------------------------------------*/
 MySgp30Device::~MySgp30Device() {
-   m_tickler.terminate();
-   pthread_mutex_destroy(&m_mutex);
-}
+   Stats stats;
+   time_t duration = time(0) - m_startTime;
 
-/*------------------------------------------------------MySgp30Device::tickle-+
-| This is executed under a separate thread.                                   |
-+----------------------------------------------------------------------------*/
-void * MySgp30Device::tickle() {
-   unsigned short ticks = 0;
-   unsigned short hours = 0;
-   struct timespec timeout;
-   timeout.tv_sec = 1;           // tickeling period of 1s
-   timeout.tv_nsec = 0L;
-// ::setpriority(PRIO_PROCESS, syscall(SYS_gettid), 2); // lower the priority
-   do {
-      acquireLock();
-      measureAirQuality();       // no arguments -> immediate return
-      usleep(12000);             // sleep 12ms (table 10)
-      if (++ticks % 3601 == 0) { // every hour, get the baseline
-         ++hours;
-         ticks = 1;
-         if (getBaseline(&m_args.co2eqCompens, &m_args.tvocCompens)) {
-            m_args.stampCompens = time(0);
-            m_args.isCompensated = true;
-            printf(
-               "[%s] Hourly baseline established: %d/%d/0x%lx\n",
-               timeStamp(), m_args.co2eqCompens, m_args.tvocCompens,
-               m_args.stampCompens
-            );
-         }else {
-            printf("Get Baseline failure - Exiting\n");
-            exit(6);
-         }
-      }
-      releaseLock();
-      // printf("\u2022"); fflush(stdout);
-   }while ((sigtimedwait(&m_sigset, 0, &timeout) == -1) && (errno == EAGAIN));
-
-   printf("| This run durated %d hour(s) and %d seconds.\n", hours, ticks);
-   if (hours == 0) {
+   stop();  // before any member goes: the hooks use them
+   getStats(stats);
+   printf(
+      "| This run durated %ld hour(s) and %ld seconds.\n"
+      "| %lld samples, %lld missed, jitter: mean %lldus, max %ldus.\n",
+      duration / 3600, duration % 3600,
+      stats.ticks, stats.missed,
+      stats.ticks? stats.jitterSum / stats.ticks : 0LL, stats.jitterMax
+   );
+   if (stats.baselines == 0) {
       printf("%s|\n", noNewBaseline);
    }
    if (m_args.isCompensated) {
@@ -243,7 +235,61 @@ void * MySgp30Device::tickle() {
          m_args.co2eqCompens, m_args.tvocCompens, m_args.stampCompens
       );
    }
-   return 0;
+   pthread_mutex_destroy(&m_mutex);
+}
+
+/*--------------------------------------------------MySgp30Device::onBaseline-+
+| Called from the tickler thread, every hour                                  |
++----------------------------------------------------------------------------*/
+void MySgp30Device::onBaseline(
+   bool isOk,
+   unsigned short co2eq,
+   unsigned short tvoc,
+   time_t stamp
+) {
+   if (!isOk) {
+      printf("Get Baseline failure - Exiting\n");
+      exit(6);
+   }
+   m_args.co2eqCompens = co2eq;
+   m_args.tvocCompens = tvoc;
+   m_args.stampCompens = stamp;
+   m_args.isCompensated = true;
+   printf(
+      "[%s] Hourly baseline established: %d/%d/0x%lx\n",
+      timeStamp(), m_args.co2eqCompens, m_args.tvocCompens,
+      m_args.stampCompens
+   );
+   m_store.save(getSerialId(), co2eq, tvoc, stamp);
+}
+
+/*------------------------------------------------MySgp30Device::printLatency-+
+| Gain of the adaptive early read, for the commands run so far                |
++----------------------------------------------------------------------------*/
+void MySgp30Device::printLatency() {
+   static Sgp30Features::ID const ids[] = {
+      Sgp30Features::MEASURE_RAW_SIGNALS,
+      Sgp30Features::GET_BASELINE,
+      Sgp30Features::MEASURE_TEST
+   };
+   static char const * const names[] = {
+      "measure_signals", "iaq_get_baseline", "measure_test"
+   };
+   for (unsigned int i=0; i < sizeof ids / sizeof *ids; ++i) {
+      Sgp30Latency::Stats stats;
+      acquireLock();
+      m_latency.getStats(ids[i], stats);
+      releaseLock();
+      if (stats.runs > stats.failures) {
+         unsigned long ok = stats.runs - stats.failures;
+         printf(
+            "| %s: %lu runs, %lu early, %lu retries, %lu failures, "
+            "mean %lluus (worst %lluus)\n",
+            names[i], stats.runs, stats.earlyHits, stats.retries,
+            stats.failures, stats.elapsedSum / ok, stats.worstSum / ok
+         );
+      }
+   }
 }
 
 /*-----------------------------------------------------------------Args::Args-+
@@ -284,22 +330,24 @@ isCompensated(false)
       break;
    }
    if (isCompensated) {
-      time_t t;
-      time(&t);
-      if (stampCompens > t) {
+      switch (Sgp30BaselineStore::getValidity(stampCompens, time(0))) {
+      case Sgp30BaselineStore::IN_FUTURE:
          printf(
             "Baseline discarded: timestamp (%s) greather than current time\n",
             timeStamp(stampCompens)
          );
          isCompensated = false;
-      }else if ((t - stampCompens) > 604800) {
+         break;
+      case Sgp30BaselineStore::EXPIRED:
          printf(
             "Baseline discarded: timestamp (%s) is older than a week\n",
             timeStamp(stampCompens)
          );
          isCompensated = false;
-      }else {
+         break;
+      default:
          printf("Re-using baseline dated %s\n", timeStamp(stampCompens));
+         break;
       }
    }
 };
@@ -324,47 +372,6 @@ int Args::getI2cAddr(char const * buf) {
    return addr;
 }
 
-/*-------------------------------------------------------------Thread::Thread-+
-|                                                                             |
-+----------------------------------------------------------------------------*/
-Thread::Thread() : m_tid((pthread_t)0L) {}
-
-/*-------------------------------------------------------------Thread::create-+
-|                                                                             |
-+----------------------------------------------------------------------------*/
-bool Thread::create(
-   char const * name,
-   void *(*func)(void *),
-   void * arg
-) {
-   m_name = name;
-   return (
-     (pthread_create(&m_tid, 0, func, arg) == 0) &&
-     (pthread_setname_np(m_tid, name) == 0)
-   );
-}
-
-/*----------------------------------------------------------Thread::terminate-+
-|                                                                             |
-+----------------------------------------------------------------------------*/
-void Thread::terminate() {
-   if (m_tid != 0) {
-      void * status;
-      int rc = 100;
-      struct timespec timeout;
-      timeout.tv_sec = 10;  // give 10 seconds for the child to finish
-      timeout.tv_nsec = 0;
-      pthread_kill(m_tid, SIGUSR1);
-      if (clock_gettime(CLOCK_REALTIME, &timeout) == 0) {
-         timeout.tv_sec += 10;  // give 10 seconds for the child to finish
-         rc = pthread_timedjoin_np(m_tid, &status, &timeout);
-      }
-      if (rc != 0) {
-         printf("*** %s didn't terminate properly: %d\n", m_name, rc);
-      }
-   }
-}
-
 /*------------------------------------------------------------------timeStamp-+
 |                                                                             |
 +----------------------------------------------------------------------------*/
@@ -379,6 +386,12 @@ static char const * const timeStamp(time_t t) {
 |                                                                             |
 +----------------------------------------------------------------------------*/
 int main(int argc, char const * const * argv) {
+   if ((argc == 2) && (strcmp(argv[1], "check") == 0)) {
+      return check()? 0 : 1;
+   }else if ((argc == 2) && (strcmp(argv[1], "bench") == 0)) {
+      bench();
+      return 0;
+   }
    Args args(argc, argv);
    MyInterface interface(args.i2cAddr);
    MySgp30Device device(interface, args);
@@ -391,7 +404,6 @@ int main(int argc, char const * const * argv) {
    }
    printf("\n");
    while (!isDone && ((ch=fgetc(stdin)) >= 0)) {
-      device.acquireLock();
       switch (ch) {
       case 'q':    // quit
          isDone = true;
@@ -400,7 +412,10 @@ int main(int argc, char const * const * argv) {
          {
             unsigned short h2;
             unsigned short ethanol;
-            if (!device.measureRawSignals(&h2, &ethanol)) {
+            device.acquireLock();
+            bool isOk = device.measureRawSignals(&h2, &ethanol);
+            device.releaseLock();
+            if (!isOk) {
                printf("[%s] Error: measureRawSignals\n", timeStamp());
             }else {
                printf(
@@ -410,11 +425,17 @@ int main(int argc, char const * const * argv) {
             }
          }
          break;
+      case 'l':    // latency (undocumented)
+         device.printLatency();
+         break;
       case 'b':    // baseline (undocumented)
          {
             unsigned short co2eq;
             unsigned short tvoc;
-            if (!device.getBaseline(&co2eq, &tvoc)) {
+            device.acquireLock();
+            bool isOk = device.getBaseline(&co2eq, &tvoc);
+            device.releaseLock();
+            if (!isOk) {
                printf("[%s] Error: getBaseline\n", timeStamp());
             }else {
                printf(
@@ -424,20 +445,762 @@ int main(int argc, char const * const * argv) {
             }
          }
          break;
-      default:
+      default:     // latest sample from the tickler: no bus access
          {
-            unsigned short co2eq;
-            unsigned short tvoc;
-            device.measureAirQuality(&co2eq, &tvoc);
-            printf(
-               "[%s] CO\u2082 Eq: %huppm, TVOC: %huppb\n",
-               timeStamp(), co2eq, tvoc
-            );
+            MySgp30Device::Sample sample;
+            if (!device.getLatest(sample)) {
+               printf("[%s] No sample yet\n", timeStamp());
+            }else {
+               printf(
+                  "[%s] CO\u2082 Eq: %huppm, TVOC: %huppb (#%lu, %lldms)\n",
+                  timeStamp(), sample.co2eq, sample.tvoc, sample.seq,
+                  device.getAge(sample) / 1000
+               );
+            }
          }
       }
-      device.releaseLock();
       while (ch != '\n') ch=fgetc(stdin); // flush the rest...
    }
    return 0;
 }
+
+/*-------------------------------------------------------------------getNanos-+
+| CLOCK_MONOTONIC, in nanoseconds                                             |
++----------------------------------------------------------------------------*/
+static long long getNanos() {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (ts.tv_sec * 1000000000LL) + ts.tv_nsec;
+}
+
+/*-------------------------------------------------------------------checkCrc-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+static bool checkCrc() {
+   unsigned char frame[6] = { 0xBE, 0xEF, 0x92, 0x12, 0x34, 0x00 };
+   unsigned short values[2] = { 1, 2 };
+   bool isOk = Sgp30Crc::selfCheck();
+   printf("CRC: the table %s the bit by bit CRC\n", isOk? "matches" : "DIFFERS");
+
+   // a bad CRC in the 2nd word: the 1st value must not be stored either
+   frame[5] = Sgp30Crc::compute(frame + 3, 2) ^ 0x01;
+   bool isDecodeOk = !Sgp30Crc::decode(frame, values, 2) &&
+      (values[0] == 1) && (values[1] == 2);
+   frame[5] ^= 0x01;
+   isDecodeOk = isDecodeOk && Sgp30Crc::decode(frame, values, 2) &&
+      (values[0] == 0xBEEF) && (values[1] == 0x1234);
+   printf(
+      "CRC: decode %s the values on a bad CRC\n",
+      isDecodeOk? "leaves" : "DOES NOT LEAVE"
+   );
+   return isOk && isDecodeOk;
+}
+
+/*-------------------------------------------------------------checkBitErrors-+
+| Air quality and raw signals read with 2% of the bits flipped: each read     |
+| failing its CRC must leave the caller's struct untouched.                   |
++----------------------------------------------------------------------------*/
+static bool checkBitErrors() {
+   enum { READS = 200, CANARY_1 = 0xA5A5, CANARY_2 = 0x5A5A };
+   Sgp30Emulator emulator;
+   Sgp30Device device(emulator);
+   int failures = 0;
+   int changed = 0;
+   bool isOk = device.initAirQuality();
+
+   emulator.setBitErrorRate(0.02);
+   for (int i=0; isOk && (i < READS); ++i) {
+      Sgp30Device::AirQuality airQuality = { CANARY_1, CANARY_2 };
+      Sgp30Device::RawSignals rawSignals = { CANARY_1, CANARY_2 };
+      if (!device.measureAirQuality(airQuality)) {
+         ++failures;
+         if ((airQuality.co2eq != CANARY_1) || (airQuality.tvoc != CANARY_2)) {
+            ++changed;
+         }
+      }
+      if (!device.measureRawSignals(rawSignals)) {
+         ++failures;
+         if ((rawSignals.h2 != CANARY_1) || (rawSignals.ethanol != CANARY_2)) {
+            ++changed;
+         }
+      }
+   }
+   printf(
+      "CRC: %d bad read(s) out of %d, %d changed the values\n",
+      failures, 2 * READS, changed
+   );
+   return isOk && (failures > 0) && (failures < 2 * READS) && (changed == 0);
+}
+
+/*-------------------------------------------------------------------benchCrc-+
+| Time per word: bit by bit, table driven, and validate (4 words at a time)   |
++----------------------------------------------------------------------------*/
+static void benchCrc() {
+   enum { WORDS = 4096, ROUNDS = 500 };
+   unsigned char * words = new unsigned char[WORDS * 3];
+   unsigned int sum = 0;
+
+   for (int i=0; i < WORDS; ++i) {
+      words[3*i] = (unsigned char)(i * 7);
+      words[3*i+1] = (unsigned char)(i >> 3);
+      words[3*i+2] = Sgp30Crc::compute(words + 3*i, 2);
+   }
+   printf("CRC, per word:\n");
+   for (int method=0; method < 3; ++method) {
+      long long start = getNanos();
+      for (int round=0; round < ROUNDS; ++round) {
+         if (method == 2) {
+            sum += Sgp30Crc::validate(words, WORDS);
+         }else {
+            for (int i=0; i < WORDS; ++i) {
+               sum += method?
+                  Sgp30Crc::compute(words + 3*i, 2) :
+                  Sgp30Crc::computeBitwise(words + 3*i, 2);
+            }
+         }
+      }
+      printf(
+         "   %-10s %6.2f ns\n",
+         (method == 0)? "bitwise" : (method == 1)? "table" : "validate",
+         (double)(getNanos() - start) / ((double)ROUNDS * WORDS)
+      );
+   }
+   if (sum == 0) printf("(never printed: keeps the results alive)\n");
+   delete [] words;
+}
+
+/*------------------------------------------------------ class RealTimeSgp30 -+
+| The emulator, following the real time (Sgp30Loop waits on a timerfd.)       |
+| failReads(n) NACKs the next n reads.                                        |
++----------------------------------------------------------------------------*/
+class RealTimeSgp30 : public Sgp30Emulator {
+public:
+   RealTimeSgp30() : m_start(getNanos() / 1000), m_failures(0) {}
+   void failReads(int count) { m_failures = count; }
+   void sleep(int us) { usleep(us); }
+   bool write(void const * buf, int len) {
+      sync();
+      return Sgp30Emulator::write(buf, len);
+   }
+   bool read(void * buf, int len) {
+      sync();
+      if (m_failures > 0) {
+         --m_failures;
+         return false;
+      }
+      return Sgp30Emulator::read(buf, len);
+   }
+private:
+   long long m_start;
+   int m_failures;
+   void sync() { advance((getNanos() / 1000) - m_start - getTime()); }
+};
+
+/*------------------------------------------------------- class LoopRecorder -+
+|                                                                             |
++----------------------------------------------------------------------------*/
+class LoopRecorder : public Sgp30Loop::Handler {
+public:
+   LoopRecorder() : m_completions(0), m_failures(0) {}
+   void onCompletion(
+      Sgp30Device &, Sgp30Loop::OPERATION, bool isOk, unsigned short const *
+   ) {
+      ++m_completions;
+      if (!isOk) ++m_failures;
+   }
+   int m_completions;
+   int m_failures;
+};
+
+/*------------------------------------------------------------------checkLoop-+
+| A command whose values can't be read (NACK) at its deadline fails, and the  |
+| device must then accept the next command.                                   |
++----------------------------------------------------------------------------*/
+static bool checkLoop() {
+   RealTimeSgp30 emulator;
+   Sgp30Device device(emulator);
+   Sgp30Loop loop(1);
+   LoopRecorder recorder;
+   bool isOk = device.isOperational() && loop.isOk();
+
+   emulator.failReads(1);
+   isOk = isOk && loop.submit(device, Sgp30Loop::RAW_SIGNALS, recorder);
+   while (isOk && loop.getPendingCount()) loop.run(1000);
+   isOk = isOk && (recorder.m_failures == 1);
+   bool isResubmitted = loop.submit(device, Sgp30Loop::RAW_SIGNALS, recorder);
+   while (isResubmitted && loop.getPendingCount()) loop.run(1000);
+   printf(
+      "Loop: NACK'ed read %s, next command %s\n",
+      (recorder.m_failures == 1)? "failed" : "DID NOT FAIL",
+      !isResubmitted? "REFUSED" :
+      (recorder.m_completions == 2) && (recorder.m_failures == 1)?
+      "completed" : "FAILED"
+   );
+   return isOk && isResubmitted &&
+      (recorder.m_completions == 2) && (recorder.m_failures == 1);
+}
+
+/*------------------------------------------------------- class TickRecorder -+
+| The tickler, recording the samples published, in the order of their seq.    |
++----------------------------------------------------------------------------*/
+class TickRecorder : public Sgp30Tickler {
+public:
+   enum { MAX_SAMPLES = 64 };
+   TickRecorder(Sgp30Device & device, long periodMicros) :
+   Sgp30Tickler(device, periodMicros), m_count(0), m_failures(0) {}
+   Sample m_samples[MAX_SAMPLES];  // seq n at [n-1]
+   int m_count;
+   int m_failures;
+protected:
+   void onSample(
+      bool isOk, unsigned short co2eq, unsigned short tvoc, long long stamp
+   ) {
+      if (!isOk) {
+         ++m_failures;
+      }else if (m_count < MAX_SAMPLES) {
+         Sample & sample = m_samples[m_count];
+         sample.co2eq = co2eq;
+         sample.tvoc = tvoc;
+         sample.stamp = stamp;
+         sample.seq = ++m_count;
+      }
+   }
+};
+
+/*------------------------------------------------------- class LatestReader -+
+| Calls getLatest() in a loop, until stopped.  The seq must never decrease,   |
+| and a given seq must always come with the same values: each new one is      |
+| kept, to be compared to those published.                                    |
++----------------------------------------------------------------------------*/
+class LatestReader {
+public:
+   enum { MAX_SAMPLES = 64 };
+   LatestReader(Sgp30Tickler const & tickler) :
+   m_tickler(tickler), m_isStopped(false), m_reads(0), m_backwards(0),
+   m_torn(0), m_count(0) {}
+   static void * run(void * p) {
+      LatestReader & reader = *(LatestReader *)p;
+      Sgp30Tickler::Sample last = { 0, 0, 0, 0 };
+      Sgp30Tickler::Sample sample;
+      while (!reader.m_isStopped) {
+         if (!reader.m_tickler.getLatest(sample)) continue;
+         ++reader.m_reads;
+         if (sample.seq < last.seq) {
+            ++reader.m_backwards;
+         }else if (sample.seq == last.seq) {
+            if (
+               (sample.co2eq != last.co2eq) || (sample.tvoc != last.tvoc) ||
+               (sample.stamp != last.stamp)
+            ) {
+               ++reader.m_torn;
+            }
+         }else {
+            if (reader.m_count < MAX_SAMPLES) {
+               reader.m_samples[reader.m_count++] = sample;
+            }
+            last = sample;
+         }
+      }
+      return 0;
+   }
+   Sgp30Tickler const & m_tickler;
+   std::atomic<bool> m_isStopped;
+   long m_reads;
+   int m_backwards;
+   int m_torn;
+   Sgp30Tickler::Sample m_samples[MAX_SAMPLES];
+   int m_count;
+};
+
+/*---------------------------------------------------------------checkTickler-+
+| The tickler on the emulator following the real time, with a 100 ms period   |
+| (the air quality takes up to 50 ms), for 1.5 s, while 3 threads hammer      |
+| getLatest():                                                                |
+| - the mean period between samples is within 1% of the period, none missed;  |
+| - the readers never see the seq decrease, nor a (co2eq, tvoc, stamp) which  |
+|   was not published with that seq.                                          |
++----------------------------------------------------------------------------*/
+static bool checkTickler() {
+   enum { PERIOD = 100000, TICKS = 15, READERS = 3 };
+   RealTimeSgp30 emulator;
+   Sgp30Device device(emulator);
+   TickRecorder tickler(device, PERIOD);
+   Sgp30Tickler::Stats stats;
+   LatestReader * readers[READERS];
+   pthread_t tids[READERS];
+   long reads = 0;
+   int backwards = 0;
+   int torn = 0;
+   bool isOk = device.initAirQuality() && tickler.start();
+
+   for (int i=0; i < READERS; ++i) {
+      readers[i] = new LatestReader(tickler);
+      pthread_create(&tids[i], 0, LatestReader::run, readers[i]);
+   }
+   usleep(TICKS * PERIOD - PERIOD / 2);
+   tickler.stop();
+   for (int i=0; i < READERS; ++i) {
+      readers[i]->m_isStopped = true;
+      pthread_join(tids[i], 0);
+      reads += readers[i]->m_reads;
+      backwards += readers[i]->m_backwards;
+      torn += readers[i]->m_torn;
+      for (int j=0; j < readers[i]->m_count; ++j) {
+         Sgp30Tickler::Sample const & seen = readers[i]->m_samples[j];
+         Sgp30Tickler::Sample const & published = (
+            tickler.m_samples[(seen.seq - 1) % TickRecorder::MAX_SAMPLES]
+         );
+         if (
+            (seen.seq > (unsigned long)tickler.m_count) ||
+            (seen.co2eq != published.co2eq) || (seen.tvoc != published.tvoc) ||
+            (seen.stamp != published.stamp)
+         ) {
+            ++torn;
+         }
+      }
+      delete readers[i];
+   }
+   tickler.getStats(stats);
+   double meanPeriod = (tickler.m_count < 2)? 0 : (
+      (double)(
+         tickler.m_samples[tickler.m_count - 1].stamp -
+         tickler.m_samples[0].stamp
+      ) / (tickler.m_count - 1)
+   );
+   isOk = isOk && (tickler.m_count >= TICKS - 1) &&
+      (tickler.m_failures == 0) && (stats.missed == 0) &&
+      (meanPeriod > PERIOD * 0.99) && (meanPeriod < PERIOD * 1.01) &&
+      (backwards == 0) && (torn == 0);
+   printf(
+      "Tickler, %d ms period: %d sample(s), mean period %.2f ms, "
+      "%lld missed\n"
+      "   %d readers, %ld getLatest(): %d backward seq, %d torn\n",
+      PERIOD / 1000, tickler.m_count, meanPeriod / 1000, stats.missed,
+      READERS, reads, backwards, torn
+   );
+   return isOk;
+}
+
+/*--------------------------------------------------------- class LoadDriver -+
+| Keeps every device busy: each completed command submits the next one.       |
++----------------------------------------------------------------------------*/
+class LoadDriver : public Sgp30Loop::Handler {
+public:
+   LoadDriver(Sgp30Loop & loop) :
+   m_loop(loop), m_isRunning(true), m_completions(0), m_failures(0),
+   m_refusals(0) {}
+   void onCompletion(
+      Sgp30Device & device, Sgp30Loop::OPERATION op, bool isOk,
+      unsigned short const *
+   ) {
+      ++m_completions;
+      if (!isOk) ++m_failures;
+      if (m_isRunning && !m_loop.submit(device, op, *this)) ++m_refusals;
+   }
+   Sgp30Loop & m_loop;
+   bool m_isRunning;
+   long m_completions;
+   long m_failures;
+   long m_refusals;
+};
+
+/*------------------------------------------------------------------benchLoad-+
+| One thread drives 32 emulated SGP30's through Sgp30Loop, for 2 seconds:     |
+| back to back raw signal measures, spread timings and bit errors injected.   |
+| Prints the commands per second, the failures and the CPU time used.         |
++----------------------------------------------------------------------------*/
+static void benchLoad() {
+   enum { DEVICES = 32, SECONDS = 2 };
+   RealTimeSgp30 * emulators = new RealTimeSgp30[DEVICES];
+   Sgp30Device * devices[DEVICES];
+   Sgp30Loop loop(DEVICES);
+   LoadDriver driver(loop);
+   Sgp30Emulator::Stats stats;
+   unsigned long nacks = 0;
+   unsigned long bitErrors = 0;
+   struct timespec cpu;
+   long long cpuStart;
+   long long start;
+   double seconds;
+
+   for (int i=0; i < DEVICES; ++i) {
+      emulators[i].setTiming(Sgp30Emulator::TIMING_SPREAD);
+      emulators[i].setBitErrorRate(1e-4, i + 1);
+      devices[i] = new Sgp30Device(emulators[i]);
+      emulators[i].resetStats();
+   }
+   clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu);
+   cpuStart = (cpu.tv_sec * 1000000000LL) + cpu.tv_nsec;
+   start = getNanos();
+   for (int i=0; i < DEVICES; ++i) {
+      if (!loop.submit(*devices[i], Sgp30Loop::RAW_SIGNALS, driver)) {
+         ++driver.m_refusals;
+      }
+   }
+   while (getNanos() - start < SECONDS * 1000000000LL) loop.run(1000);
+   driver.m_isRunning = false;
+   while (loop.getPendingCount()) loop.run(1000);
+   seconds = (getNanos() - start) / 1e9;
+   clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu);
+   for (int i=0; i < DEVICES; ++i) {
+      emulators[i].getStats(stats);
+      nacks += stats.nacks;
+      bitErrors += stats.bitErrors;
+      delete devices[i];
+   }
+   delete [] emulators;
+   printf(
+      "Sgp30Loop load, %d emulated SGP30's, one thread:\n"
+      "   %.0f commands/s, %ld failed, %ld refused\n"
+      "   %lu NACK'ed reads, %lu bit errors injected, CPU %.1f%%\n",
+      DEVICES, driver.m_completions / seconds,
+      driver.m_failures, driver.m_refusals, nacks, bitErrors,
+      100.0 * (
+         (cpu.tv_sec * 1000000000LL) + cpu.tv_nsec - cpuStart
+      ) / (seconds * 1e9)
+   );
+}
+
+/*------------------------------------------------------------benchGetCommand-+
+| getCommand, against the former lookup: a switch for the commands common to  |
+| all the chips, else a linear search among those of the feature set.         |
++----------------------------------------------------------------------------*/
+static Sgp30Features::Command const * formerGetCommand(
+   Sgp30Features::Command const * const * commands,
+   int count,
+   Sgp30Features::ID id
+) {
+   switch (id) {
+   case Sgp30Features::GET_SERIAL_ID:
+   case Sgp30Features::GET_FEATURE_SET_VERSION:
+   case Sgp30Features::MEASURE_TEST:
+      return commands[id];
+   default:
+      for (int i=0; i < count; ++i) {
+         if (commands[i] && (commands[i]->m_id == id)) return commands[i];
+      }
+   }
+   return 0;
+}
+
+static void benchGetCommand() {
+   enum { ROUNDS = 2000000 };
+   Sgp30Features::Set const * set = Sgp30Features::Set::makeSet(0x20);
+   Sgp30Features::Command const * commands[Sgp30Features::ID_COUNT];
+   unsigned long sum = 0;
+
+   for (int id=0; id < Sgp30Features::ID_COUNT; ++id) {
+      commands[id] = set->getCommand((Sgp30Features::ID)id);
+   }
+   printf("getCommand, per call:\n");
+   for (int method=0; method < 2; ++method) {
+      long long start = getNanos();
+      for (int round=0; round < ROUNDS; ++round) {
+         // the id is not known at compile time
+         Sgp30Features::ID id = (Sgp30Features::ID)(
+            (round ^ (round >> 3)) % Sgp30Features::ID_COUNT
+         );
+         Sgp30Features::Command const * command = method?
+            formerGetCommand(commands, Sgp30Features::ID_COUNT, id) :
+            set->getCommand(id);
+         sum += command->m_durationMicros;
+      }
+      printf(
+         "   %-7s %6.2f ns\n", method? "former" : "indexed",
+         (double)(getNanos() - start) / ROUNDS
+      );
+   }
+   if (sum == 0) printf("(never printed: keeps the results alive)\n");
+}
+
+/*---------------------------------------------------------------benchStartUp-+
+| Host time to construct a Sgp30Device (serial id, feature set: the command   |
+| lookups and CRCs), the emulated SGP30 not sleeping.                         |
++----------------------------------------------------------------------------*/
+static void benchStartUp() {
+   enum { ROUNDS = 10000 };
+   Sgp30Emulator emulator;
+   unsigned long long sum = 0;
+   long long start = getNanos();
+
+   for (int round=0; round < ROUNDS; ++round) {
+      Sgp30Device device(emulator);
+      sum += device.getSerialId();
+   }
+   printf(
+      "Sgp30Device start up (host time, emulated bus): %.2f us\n",
+      (double)(getNanos() - start) / (ROUNDS * 1000.0)
+   );
+   if (sum == 0) printf("(never printed: keeps the results alive)\n");
+}
+
+/*--------------------------------------------------------------checkHumidity-+
+| - The interpolated absolute humidity, from -40 to 85 Celsius degrees and    |
+|   1 to 100% of relative humidity, against the formula: below 0.05 g/m**3,   |
+|   and within 1 LSB (8.8) plus 0.1% of the value;                            |
+| - fed with the temperature drifting by 0.001 degree per sample, update()    |
+|   only sends the changed values: as many as the emulator receives.          |
++----------------------------------------------------------------------------*/
+static bool checkHumidity() {
+   enum { UPDATES = 100 };
+   Sgp30Emulator emulator;
+   Sgp30Device device(emulator);
+   Sgp30Humidity humidity(device);
+   Sgp30Emulator::Stats stats;
+   double worst = 0;
+   double worstTemperature = 0;
+   int outliers = 0;
+
+   for (int tenths=-400; tenths <= 850; ++tenths) {
+      double t = tenths / 10.0;
+      for (int rh=1; rh <= 100; ++rh) {
+         double exact = 216.7 * (
+            ((rh / 100.0) * 6.112 * exp((17.62 * t) / (243.12 + t))) /
+            (273.15 + t)
+         );
+         if (exact * 256 >= 0xffff) break;   // clamped
+         double value = Sgp30Humidity::getAbsoluteHumidity(rh, t);
+         double error = fabs(value / 256 - exact);
+         if (error > worst) {
+            worst = error;
+            worstTemperature = t;
+         }
+         if (
+            (error >= 0.05) ||
+            (fabs(value - (exact * 256)) > 1 + (exact * 256 * 0.001))
+         ) {
+            ++outliers;
+         }
+      }
+   }
+   printf(
+      "Humidity: worst error %.3f g/m**3 (at %.1f C), %d outlier(s)\n",
+      worst, worstTemperature, outliers
+   );
+
+   bool isOk = device.isOperational();
+   emulator.resetStats();
+   for (int i=0; isOk && (i < UPDATES); ++i) {
+      isOk = humidity.update(50.0, 21.0 + (i / 1000.0));
+   }
+   emulator.getStats(stats);
+   isOk = isOk &&
+      (humidity.getSentCount() > 1) &&
+      (humidity.getSentCount() < UPDATES / 2) &&
+      (humidity.getSentCount() + humidity.getSkippedCount() == UPDATES) &&
+      (stats.humidities == (unsigned long)humidity.getSentCount()) && (
+         emulator.getHumidity() ==
+         Sgp30Humidity::getAbsoluteHumidity(50.0, 21.0 + (UPDATES-1) / 1000.0)
+      );
+   printf(
+      "Humidity: %d update(s), %d sent, %lu received by the emulator\n",
+      UPDATES, humidity.getSentCount(), stats.humidities
+   );
+   return isOk && (outliers == 0);
+}
+
+/*-----------------------------------------------------------------checkStore-+
+| A saved baseline loads back under its serial id only, and one dated more    |
+| than a week ago is refused.                                                 |
++----------------------------------------------------------------------------*/
+static bool checkStore() {
+   unsigned long long const serialId = 0x800112345678ULL;
+   char directory[] = "/tmp/sgp30-store-XXXXXX";
+   char path[64];
+   unsigned short co2eq = 0;
+   unsigned short tvoc = 0;
+   time_t stamp = 0;
+   time_t const now = time(0);
+   bool isOk;
+
+   if (!mkdtemp(directory)) return false;
+   snprintf(path, sizeof path,
+      "%s/sgp30-%012llx.baseline", directory, serialId
+   );
+   Sgp30BaselineStore store(directory);
+   isOk = (
+      store.save(serialId, 34000, 35000, now) &&
+      store.load(serialId, &co2eq, &tvoc, &stamp) &&
+      (co2eq == 34000) && (tvoc == 35000) && (stamp == now) &&
+      !store.load(serialId + 1, &co2eq, &tvoc, &stamp)
+   );
+   isOk = isOk && store.save(
+      serialId, 34000, 35000, now - Sgp30BaselineStore::VALIDITY_SECONDS - 1
+   ) && !store.load(serialId, &co2eq, &tvoc, &stamp);
+   printf("Baseline store: save and load %s\n", isOk? "ok" : "FAILED");
+   remove(path);
+   rmdir(directory);
+   return isOk;
+}
+
+/*---------------------------------------------------------------checkLatency-+
+| measure_signals, 500 times, on the emulator completing in 20 to 25 ms (the  |
+| worst case is 200 ms), fixed then adaptive:                                 |
+| - no adaptive run waits past the worst case, nor fails more than fixed;     |
+| - the learned percentile converges on the 25 ms bucket edge.                |
++----------------------------------------------------------------------------*/
+static bool checkLatency() {
+   enum { RUNS = 500, SPREAD_MAX = 25000 };
+   int failures[2] = { 0, 0 };
+   int late = 0;
+   unsigned long learned = 0;
+   unsigned long worst = 0;
+
+   for (int isAdaptive=0; isAdaptive < 2; ++isAdaptive) {
+      Sgp30Emulator emulator;
+      Sgp30Device device(emulator);
+      Sgp30Latency latency;
+
+      emulator.setTiming(Sgp30Emulator::TIMING_SPREAD);
+      if (isAdaptive) device.setAdaptiveLatency(&latency);
+      worst = device.getDurationMicros(Sgp30Features::MEASURE_RAW_SIGNALS) + 5;
+      for (int i=0; i < RUNS; ++i) {
+         Sgp30Device::RawSignals values;
+         long long start = emulator.getTime();
+         if (!device.measureRawSignals(values)) ++failures[isAdaptive];
+         if (emulator.getTime() - start > (long long)worst) ++late;
+      }
+      if (isAdaptive) {
+         learned = latency.getPercentileMicros(
+            Sgp30Features::MEASURE_RAW_SIGNALS, worst
+         );
+      }
+   }
+   printf(
+      "Latency: %d failure(s) fixed, %d adaptive, %d past the worst case, "
+      "learned %.2f ms\n",
+      failures[0], failures[1], late, learned / 1000.0
+   );
+   return (failures[1] <= failures[0]) && (late == 0) &&
+      (learned >= SPREAD_MAX) &&
+      (learned <= SPREAD_MAX + (worst / Sgp30Latency::BUCKETS));
+}
+
+/*---------------------------------------------------------------benchLatency-+
+| measure_signals, 500 times, on the emulator (virtual time): the datasheet   |
+| gives 200 ms, the emulated part completes in 20 to 25 ms.  Mean wait per    |
+| command, without and with the adaptive early read.                          |
++----------------------------------------------------------------------------*/
+static void benchLatency() {
+   enum { RUNS = 500 };
+   printf("measure_signals, emulated part completing in 20-25 ms:\n");
+   for (int isAdaptive=0; isAdaptive < 2; ++isAdaptive) {
+      Sgp30Emulator emulator;
+      Sgp30Device device(emulator);
+      Sgp30Latency latency;
+      Sgp30Latency::Stats stats;
+      int failures = 0;
+
+      emulator.setTiming(Sgp30Emulator::TIMING_SPREAD);
+      if (isAdaptive) device.setAdaptiveLatency(&latency);
+      long long start = emulator.getTime();
+      for (int i=0; i < RUNS; ++i) {
+         Sgp30Device::RawSignals values;
+         if (!device.measureRawSignals(values)) ++failures;
+      }
+      printf(
+         "   %-9s mean wait %6.2f ms, %d failure(s)",
+         isAdaptive? "adaptive" : "fixed",
+         (emulator.getTime() - start) / (RUNS * 1000.0), failures
+      );
+      if (isAdaptive) {
+         latency.getStats(Sgp30Features::MEASURE_RAW_SIGNALS, stats);
+         printf(
+            ", %lu early hit(s), %lu retry(ies)", stats.earlyHits, stats.retries
+         );
+      }
+      printf("\n");
+   }
+}
+
+/*------------------------------------------------------ class FrameRecorder -+
+| Counts the raw signals records of each frame                                |
++----------------------------------------------------------------------------*/
+class FrameRecorder : public Sgp30Pipeline {
+public:
+   FrameRecorder(Sgp30Device & device, int rawPerFrame) :
+      Sgp30Pipeline(device, rawPerFrame),
+      m_frames(0), m_rawInFrame(0), m_rawMin(-1), m_rawMax(0) {}
+   int m_frames;                   // completed frames
+   int m_rawInFrame;
+   int m_rawMin;
+   int m_rawMax;
+protected:
+   void onRecord(Record const & record) {
+      if (record.kind == RAW_SIGNALS) {
+         ++m_rawInFrame;
+      }else {                      // a new frame: close the former one
+         if (record.frame > 1) {
+            ++m_frames;
+            if ((m_rawMin < 0) || (m_rawInFrame < m_rawMin)) {
+               m_rawMin = m_rawInFrame;
+            }
+            if (m_rawInFrame > m_rawMax) m_rawMax = m_rawInFrame;
+         }
+         m_rawInFrame = 0;
+      }
+   }
+};
+
+/*--------------------------------------------------------------checkPipeline-+
+| The pipeline, asked for 8 raw signals per frame, on the emulator following  |
+| the real time, for 3 frames.  With the datasheet durations (50 ms for the   |
+| air quality, 200 ms per raw signals), at least 3 of them must fit in each   |
+| 1 s frame, and no air quality period may be missed.                         |
++----------------------------------------------------------------------------*/
+static bool checkPipeline() {
+   enum { FRAMES = 3, RAW_PER_FRAME = 8, RAW_MIN = 3 };
+   RealTimeSgp30 emulator;
+   Sgp30Device device(emulator);
+   FrameRecorder pipeline(device, RAW_PER_FRAME);
+   Sgp30Tickler::Stats stats;
+
+   if (!device.initAirQuality() || !pipeline.start()) {
+      printf("Pipeline: can't start\n");
+      return false;
+   }
+   usleep((FRAMES * 1000000) + 500000); // the last frame starts, not the next
+   pipeline.stop();
+   pipeline.getStats(stats);
+   printf(
+      "Pipeline, %d raw signals asked per 1 s frame, %d complete frame(s):\n"
+      "   raw signals per frame: %d to %d (%lld in all, %lld short)\n"
+      "   air quality cadence: %lld missed period(s), jitter mean %lld us, "
+      "max %ld us\n",
+      RAW_PER_FRAME, pipeline.m_frames, pipeline.m_rawMin, pipeline.m_rawMax,
+      pipeline.getRawCount(), pipeline.getRawShortfall(),
+      stats.missed, stats.ticks? stats.jitterSum / stats.ticks : 0LL,
+      stats.jitterMax
+   );
+   return (pipeline.m_frames == FRAMES) && (pipeline.m_rawMin >= RAW_MIN) &&
+      (stats.missed == 0);
+}
+
+/*----------------------------------------------------------------------check-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+static bool check() {
+   bool isOk = true;
+   isOk = checkCrc() && isOk;
+   isOk = checkBitErrors() && isOk;
+   isOk = checkLatency() && isOk;
+   isOk = checkLoop() && isOk;
+   isOk = checkTickler() && isOk;
+   isOk = checkStore() && isOk;
+   isOk = checkHumidity() && isOk;
+   isOk = checkPipeline() && isOk;
+   printf("%s\n", isOk? "All checks passed" : "CHECK FAILED");
+   return isOk;
+}
+
+/*----------------------------------------------------------------------bench-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+static void bench() {
+   benchCrc();
+   benchGetCommand();
+   benchStartUp();
+   benchLatency();
+   benchLoad();
+}
 /*===========================================================================*/
@@ -0,0 +1,211 @@
+/*
+* Author:  agent
+* Written: 10/16/2026
+*
+* SGP30 - Sensirion Multi-Pixel Gas Sensor - 1 Hz background scheduler
+*/
+#include <stdio.h>
+#include <errno.h>
+#include "Sgp30Tickler.h"
+
+/*-------------------------------------------------Sgp30Tickler::Sgp30Tickler-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+Sgp30Tickler::Sgp30Tickler(
+   Sgp30Device & device,
+   long periodMicros,
+   long baselineSeconds
+) :
+m_device(device),
+m_periodMicros(periodMicros),
+m_baselineMicros(baselineSeconds * 1000000LL),
+m_tid((pthread_t)0L),
+m_isStarted(false),
+m_isStopRequested(false),
+m_statsMutex(PTHREAD_MUTEX_INITIALIZER),
+m_stats(),
+m_seq(0),
+m_values(0),
+m_stamp(0)
+{}
+
+/*------------------------------------------------Sgp30Tickler::~Sgp30Tickler-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+Sgp30Tickler::~Sgp30Tickler() {
+   stop();
+   pthread_mutex_destroy(&m_statsMutex);
+}
+
+/*--------------------------------------------------------Sgp30Tickler::start-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+bool Sgp30Tickler::start() {
+   if (m_isStarted) return false;
+   m_isStopRequested = false;
+   if (pthread_create(&m_tid, 0, runThread, this) != 0) {
+      perror("Sgp30Tickler");
+      return false;
+   }
+   pthread_setname_np(m_tid, "Sgp30Tickler");
+   m_isStarted = true;
+   return true;
+}
+
+/*---------------------------------------------------------Sgp30Tickler::stop-+
+| The tickler checks the stop request at each period.                         |
++----------------------------------------------------------------------------*/
+void Sgp30Tickler::stop() {
+   m_isStopRequested = true;
+   if (m_isStarted) {
+      pthread_join(m_tid, 0);
+      m_isStarted = false;
+   }
+}
+
+/*----------------------------------------------------Sgp30Tickler::runThread-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+void * Sgp30Tickler::runThread(void * p) {
+   ((Sgp30Tickler *)p)->run();
+   return 0;
+}
+
+/*----------------------------------------------------------Sgp30Tickler::run-+
+| Deadlines are absolute: a late wake-up is reported as jitter, and the next  |
+| deadline stays on the original grid.  If later than a full period, the      |
+| missed periods are skipped (and counted) rather than run in a burst.        |
++----------------------------------------------------------------------------*/
+void Sgp30Tickler::run() {
+   long long deadline = now();
+   long long nextBaseline = deadline + m_baselineMicros;
+
+   while (!m_isStopRequested) {
+      tick(nextBaseline);
+      long long missed = 0;
+      long long time = now();
+      deadline += m_periodMicros;
+      while (deadline <= time) {
+         deadline += m_periodMicros;
+         ++missed;
+      }
+      onSpareTime(deadline);
+      sleepUntil(deadline);
+      long jitter = (long)(now() - deadline);
+
+      pthread_mutex_lock(&m_statsMutex);
+      m_stats.missed += missed;
+      m_stats.jitterSum += jitter;
+      if (jitter > m_stats.jitterMax) m_stats.jitterMax = jitter;
+      pthread_mutex_unlock(&m_statsMutex);
+   }
+}
+
+/*---------------------------------------------------------Sgp30Tickler::tick-+
+| The lock is held from the start of the command until its values are read:   |
+| no other command may be interleaved.                                        |
++----------------------------------------------------------------------------*/
+void Sgp30Tickler::tick(long long & nextBaseline) {
+   long long stamp;
+   Sgp30Device::AirQuality values = { 0, 0 };
+   bool isOk;
+   bool isBaselineDue = false;
+   bool isBaselineOk = false;
+   Sgp30Device::AirQuality baseline = { 0, 0 };
+
+   lock();
+   stamp = now();
+   isOk = m_device.measureAirQuality();
+   if (isOk) {
+      sleepUntil(now() + m_device.getPendingMicros() + 5);
+      isOk = m_device.getAirQuality(values);
+   }
+   if (now() >= nextBaseline) {
+      isBaselineDue = true;
+      nextBaseline += m_baselineMicros;
+      isBaselineOk = m_device.getBaseline(baseline);
+   }
+   unlock();
+
+   pthread_mutex_lock(&m_statsMutex);
+   ++m_stats.ticks;
+   if (isBaselineOk) ++m_stats.baselines;
+   pthread_mutex_unlock(&m_statsMutex);
+
+   if (isOk) publish(values.co2eq, values.tvoc, stamp);
+   onSample(isOk, values.co2eq, values.tvoc, stamp);
+   if (isBaselineDue) {
+      onBaseline(isBaselineOk, baseline.co2eq, baseline.tvoc, time(0));
+   }
+}
+
+/*-----------------------------------------------------Sgp30Tickler::getStats-+
+|                                                                             |
++----------------------------------------------------------------------------*/
+void Sgp30Tickler::getStats(Stats & stats) const {
+   pthread_mutex_lock(&m_statsMutex);
+   stats = m_stats;
+   pthread_mutex_unlock(&m_statsMutex);
+}
+
+/*------------------------------------------------------Sgp30Tickler::publish-+
+| Seqlock writer (there is only one: the tickler thread).                     |
+| The fields are atomics themselves, so that a torn read is not a data race.  |
++----------------------------------------------------------------------------*/
+void Sgp30Tickler::publish(
+   unsigned short co2eq,
+   unsigned short tvoc,
+   long long stamp
+) {
+   unsigned long seq = m_seq.load(std::memory_order_relaxed);
+   m_seq.store(seq + 1, std::memory_order_relaxed);
+   std::atomic_thread_fence(std::memory_order_release);
+   m_values.store(
+      ((unsigned long)co2eq << 16) | tvoc, std::memory_order_relaxed
+   );
+   m_stamp.store(stamp, std::memory_order_relaxed);
+   m_seq.store(seq + 2, std::memory_order_release);
+}
+
+/*----------------------------------------------------Sgp30Tickler::getLatest-+
+| Seqlock reader: retries only if the tickler published meanwhile, which      |
+| happens at most once per period.                                            |
++----------------------------------------------------------------------------*/
+bool Sgp30Tickler::getLatest(Sample & sample) const {
+   unsigned long seq;
+   unsigned long values;
+   long long stamp;
+   do {
+      seq = m_seq.load(std::memory_order_acquire);
+      values = m_values.load(std::memory_order_relaxed);
+      stamp = m_stamp.load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+   }while ((seq & 1) || (seq != m_seq.load(std::memory_order_relaxed)));
+
+   if (seq == 0) return false;
+   sample.co2eq = (unsigned short)(values >> 16);
+   sample.tvoc = (unsigned short)values;
+   sample.stamp = stamp;
+   sample.seq = seq / 2;
+   return true;
+}
+
+/*STATIC----------------------------------------------------Sgp30Tickler::now-+
+| CLOCK_MONOTONIC, in microseconds                                            |
++----------------------------------------------------------------------------*/
+long long Sgp30Tickler::now() {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (ts.tv_sec * 1000000LL) + (ts.tv_nsec / 1000);
+}
+
+/*STATIC---------------------------------------------Sgp30Tickler::sleepUntil-+
+| deadline: CLOCK_MONOTONIC, in microseconds                                  |
++----------------------------------------------------------------------------*/
+void Sgp30Tickler::sleepUntil(long long deadline) {
+   struct timespec ts;
+   ts.tv_sec = deadline / 1000000;
+   ts.tv_nsec = (deadline % 1000000) * 1000;
+   while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, 0) == EINTR) {}
+}
+/*===========================================================================*/
@@ -0,0 +1,102 @@
+/*
+* Author:  agent
+* Written: 10/16/2026
+*
+* SGP30 - Sensirion Multi-Pixel Gas Sensor - 1 Hz background scheduler
+*
+* The SGP30 on-chip algorithm expects "measure air quality" to be sent
+* at exactly 1 Hz.  The Tickler runs on its own thread and sleeps to
+* absolute CLOCK_MONOTONIC deadlines (clock_nanosleep, TIMER_ABSTIME):
+* the time spent measuring, or waiting for the lock, never accumulates.
+* Each sample, and the baseline taken every hour of elapsed time, are
+* handed to the virtual hooks.
+*
+* The latest sample is also published through a seqlock: getLatest()
+* never blocks, nor touches the bus, whatever the number of readers.
+*/
+#ifndef _SGP30_TICKLER_H_
+#define _SGP30_TICKLER_H_
+
+#include <time.h>
+#include <pthread.h>
+#include <atomic>
+#include "Sgp30Device.h"
+
+class Sgp30Tickler {
+public:
+   struct Sample {
+      unsigned short co2eq;
+      unsigned short tvoc;
+      long long stamp;             // CLOCK_MONOTONIC, in microseconds
+      unsigned long seq;           // 1 for the first sample, then 2...
+   };
+   struct Stats {
+      long long ticks;             // samples attempted
+      long long missed;            // periods skipped, when late by > 1 period
+      long long jitterSum;         // wake-up lateness, in microseconds
+      long jitterMax;
+      int baselines;               // baselines taken
+   };
+
+   Sgp30Tickler(
+      Sgp30Device & device,
+      long periodMicros = 1000000,
+      long baselineSeconds = 3600
+   );
+   virtual ~Sgp30Tickler();
+
+   bool start();                   // run on a new thread
+   void stop();                    // returns within one period
+   void run();                     // or run on the calling thread
+   void getStats(Stats & stats) const;
+   bool getLatest(Sample & sample) const; // false if no sample yet
+
+protected:
+   // Hooks, called from the tickler thread.  lock() guards the device
+   // for the whole measurement, when other threads also talk to it.
+   virtual void lock() {}
+   virtual void unlock() {}
+   virtual void onSample(
+      bool isOk, unsigned short co2eq, unsigned short tvoc, long long stamp
+   ) {}
+   virtual void onBaseline(
+      bool isOk, unsigned short co2eq, unsigned short tvoc, time_t stamp
+   ) {}
+   // Called once per period, after the sample, lock released: other
+   // commands can be run there, if they complete before 'deadline'.
+   virtual void onSpareTime(long long deadline) {}
+
+   Sgp30Device & getDevice() const;
+
+   static long long now();         // CLOCK_MONOTONIC, in microseconds
+   static void sleepUntil(long long deadline);
+
+private:
+   Sgp30Device & m_device;
+   long const m_periodMicros;
+   long long const m_baselineMicros;
+   pthread_t m_tid;
+   bool m_isStarted;
+   std::atomic<bool> m_isStopRequested;
+   mutable pthread_mutex_t m_statsMutex;
+   Stats m_stats;
+   std::atomic<unsigned long> m_seq;     // odd while publishing
+   std::atomic<unsigned long> m_values;  // co2eq << 16 | tvoc
+   std::atomic<long long> m_stamp;
+
+   void tick(long long & nextBaseline);
+   void publish(unsigned short co2eq, unsigned short tvoc, long long stamp);
+   static void * runThread(void * p);
+
+   Sgp30Tickler(Sgp30Tickler const &);   // no copy
+   Sgp30Tickler & operator=(Sgp30Tickler const &);
+};
+
+/*--------+
+| INLINES |
++--------*/
+inline Sgp30Device & Sgp30Tickler::getDevice() const {
+   return m_device;
+}
+#endif
+/*===========================================================================*/